@@ -0,0 +1,25 @@
+# Test de fumée du rendu sans fenêtre, lancé par ctest (cmake -DFLAG=<flag> -DOUTPUT_DIR=<dossier> -P ...):
+# flag --headless crée un contexte EGL (Mesa llvmpipe suffit), simule et relit quelques frames.
+# La dernière image doit avoir été écrite et ne pas être uniforme.
+file(REMOVE_RECURSE ${OUTPUT_DIR})
+execute_process(COMMAND ${FLAG} --headless ${OUTPUT_DIR} 5 --dt 0.16 RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "flag --headless failed (${result})")
+endif()
+
+set(frame ${OUTPUT_DIR}/frame_00004.ppm)
+if(NOT EXISTS ${frame})
+    message(FATAL_ERROR "${frame} was not written")
+endif()
+file(READ ${frame} header LIMIT 2 HEX)
+if(NOT header STREQUAL "5036") # "P6"
+    message(FATAL_ERROR "${frame} is not a binary PPM")
+endif()
+
+# Bande de pixels au milieu de l'image: au moins deux valeurs différentes
+file(READ ${frame} pixels OFFSET 900000 LIMIT 30000 HEX)
+string(SUBSTRING "${pixels}" 0 2 first)
+string(REPLACE "${first}" "" others "${pixels}")
+if(others STREQUAL "")
+    message(FATAL_ERROR "${frame} is uniform: nothing was rendered")
+endif()
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace PartyKel {
+
+// Nombre d'allocations sur le tas depuis le lancement du programme, tous threads confondus.
+// Les opérateurs new globaux ne sont remplacés (et les allocations comptées) que si AllocationCounter.cpp
+// est compilé avec PARTYKEL_ENABLE_PROFILING: sinon la fonction renvoie toujours 0
+uint64_t getAllocationCount();
+
+// true si les allocations sont comptées. Défini avec getAllocationCount: un programme lié au compteur
+// instrumenté (PartyKelAllocationCounter) le sait sans être lui-même compilé avec PARTYKEL_ENABLE_PROFILING
+bool isAllocationCountingEnabled();
+
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+namespace PartyKel {
+
+// Format binaire versionné des sauvegardes d'état:
+//   en-tête (CheckpointHeader), sections alignées sur 16 octets, table des sections, puis
+//   CheckpointFooter donnant la position de la table.
+// Chaque section est identifiée par une étiquette de quatre caractères (checkpointTag("POSI")).
+// Les données sont écrites dans l'ordre natif de la machine: un fichier n'est relu que sur la même architecture.
+
+// Version 2: le vent est tiré par un générateur à compteur, sauvegardé par sa graine et la frame courante
+static const uint32_t CHECKPOINT_VERSION = 2;
+
+constexpr uint32_t checkpointTag(const char (&name)[5]) {
+    return uint32_t(uint8_t(name[0])) | (uint32_t(uint8_t(name[1])) << 8) |
+           (uint32_t(uint8_t(name[2])) << 16) | (uint32_t(uint8_t(name[3])) << 24);
+}
+
+struct CheckpointHeader {
+    char magic[4];      // "PKCP"
+    uint32_t version;
+    uint32_t flags;     // Réservé
+    uint32_t reserved;
+};
+
+struct CheckpointSection {
+    uint32_t tag;
+    uint32_t reserved;
+    uint64_t offset;    // Depuis le début du fichier
+    uint64_t size;      // En octets
+};
+
+struct CheckpointFooter {
+    uint64_t tableOffset;
+    uint32_t sectionCount;
+    char magic[4];      // "PKCP"
+};
+
+// Écrit une sauvegarde section par section; la table est écrite par close()
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(const std::string& path);
+
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+
+    CheckpointWriter& operator =(const CheckpointWriter&) = delete;
+
+    void write(uint32_t tag, const void* data, size_t size);
+
+    template<typename T>
+    void write(uint32_t tag, const T& value) {
+        write(tag, &value, sizeof(T));
+    }
+
+    template<typename T>
+    void write(uint32_t tag, const std::vector<T>& values) {
+        write(tag, values.data(), values.size() * sizeof(T));
+    }
+
+    // Termine le fichier; lève une std::runtime_error si une écriture a échoué
+    void close();
+
+private:
+    // Écrit data à la suite du fichier, aligné sur 16 octets; renvoit sa position
+    uint64_t append(const void* data, size_t size);
+
+    std::string m_Path;
+    FILE* m_pFile;
+    uint64_t m_nOffset;
+    std::vector<CheckpointSection> m_Sections;
+    bool m_bFailed;
+};
+
+// Lit une sauvegarde projetée en mémoire (mmap): section() et array() donnent accès aux données sans copie
+// tant que le lecteur existe; read() les copie. Flag::load copie chaque tableau dans ses std::vector,
+// le fichier n'étant pas conservé après le chargement
+class CheckpointReader {
+public:
+    explicit CheckpointReader(const std::string& path);
+
+    ~CheckpointReader();
+
+    CheckpointReader(const CheckpointReader&) = delete;
+
+    CheckpointReader& operator =(const CheckpointReader&) = delete;
+
+    uint32_t getVersion() const {
+        return m_nVersion;
+    }
+
+    bool hasSection(uint32_t tag) const {
+        return findSection(tag) != nullptr;
+    }
+
+    // Adresse des données d'une section dans le fichier projeté; lève une std::runtime_error si elle est absente
+    const void* section(uint32_t tag, size_t& size) const;
+
+    // Vue sans copie sur une section contenant un tableau de T
+    template<typename T>
+    const T* array(uint32_t tag, size_t& count) const {
+        size_t size;
+        const void* data = section(tag, size);
+        if (size % sizeof(T) != 0) {
+            throw std::runtime_error("Checkpoint section has an unexpected size");
+        }
+        count = size / sizeof(T);
+        return static_cast<const T*>(data);
+    }
+
+    template<typename T>
+    void read(uint32_t tag, std::vector<T>& values) const {
+        size_t count;
+        const T* data = array<T>(tag, count);
+        values.assign(data, data + count);
+    }
+
+    template<typename T>
+    void read(uint32_t tag, T& value) const {
+        size_t count;
+        const T* data = array<T>(tag, count);
+        if (count != 1) {
+            throw std::runtime_error("Checkpoint section has an unexpected size");
+        }
+        value = *data;
+    }
+
+private:
+    const CheckpointSection* findSection(uint32_t tag) const;
+
+    const uint8_t* m_pData;
+    size_t m_nSize;
+    uint32_t m_nVersion;
+    const CheckpointSection* m_pSections;
+    uint32_t m_nSectionCount;
+};
+
+}
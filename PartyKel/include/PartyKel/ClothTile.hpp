@@ -0,0 +1,74 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <vector>
+
+namespace PartyKel {
+
+struct SceneConfig;
+class ThreadPool;
+
+// Bande de rangées [rowBegin, rowEnd) du drapeau de la scène, simulée indépendamment des autres bandes
+// (un processus par bande, voir src/tiles.cpp). Les ressorts relient des particules distantes d'au plus
+// HALO_ROWS rangées: la bande conserve une copie de ces rangées voisines (halo), mise à jour à chaque pas
+// par les bandes qui les possèdent.
+// Les forces sont celles de Flag (gravité, vent, ressorts, sphères), dans le même ordre: pour une même scène,
+// le résultat est identique à celui d'un Flag, quel que soit le découpage. Les auto-collisions et le solveur
+// de contacts, qui relient des particules quelconques du drapeau, ne sont pas simulés.
+class ClothTile {
+public:
+    static const int HALO_ROWS = 2;
+
+    // Les bandes doivent avoir au moins HALO_ROWS rangées, pour que chaque halo vienne d'une seule voisine
+    ClothTile(const SceneConfig& scene, int rowBegin, int rowEnd);
+
+    // Applique les forces aux rangées de la bande et les intègre; le halo doit être à jour
+    void step(const SceneConfig& scene, float dt, const glm::vec3& wind, ThreadPool& pool);
+
+    // Copie les positions puis les vitesses des rangées [row, row + rowCount) dans data (2 * rowCount * gridWidth vecteurs)
+    void packRows(int row, int rowCount, glm::vec3* data) const;
+
+    // Remplace les rangées [row, row + rowCount) du halo par des données écrites par packRows
+    void unpackRows(int row, int rowCount, const glm::vec3* data);
+
+    int getRowBegin() const {
+        return m_nRowBegin;
+    }
+
+    int getRowEnd() const {
+        return m_nRowEnd;
+    }
+
+    int getGridWidth() const {
+        return m_nGridWidth;
+    }
+
+    // Position d'une particule de la bande ou de son halo (i colonne, j rangée du drapeau)
+    const glm::vec3& getPosition(int i, int j) const {
+        return m_Positions[index(i, j)];
+    }
+
+    const glm::vec3& getVelocity(int i, int j) const {
+        return m_Velocities[index(i, j)];
+    }
+
+private:
+    int index(int i, int j) const {
+        return (j - m_nStoredBegin) * m_nGridWidth + i;
+    }
+
+    int m_nGridWidth, m_nGridHeight;
+    int m_nRowBegin, m_nRowEnd;         // Rangées simulées
+    int m_nStoredBegin, m_nStoredEnd;   // Rangées simulées et halo
+
+    // Longueurs à vide, calculées comme dans Flag (gridRestLengths)
+    glm::vec2 m_L0;
+    float m_fL1;
+    glm::vec2 m_L2;
+
+    std::vector<glm::vec3> m_Positions;
+    std::vector<glm::vec3> m_Velocities;
+    std::vector<glm::vec3> m_Forces;
+};
+
+}
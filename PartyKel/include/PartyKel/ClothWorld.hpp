@@ -0,0 +1,139 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include "PartyKel/ContactCache.hpp"
+#include "PartyKel/SpatialHash.hpp"
+#include <vector>
+#include <cstdint>
+
+namespace PartyKel {
+
+struct SphereHandler;
+struct SceneConfig;
+class ThreadPool;
+
+// Ensemble de tissus rectangulaires simulés ensemble. Les particules de tous les tissus sont rangées
+// dans les mêmes tableaux (un tissu occupe un intervalle contigu), de même que leurs ressorts: chaque
+// phase du pas est une seule boucle parallèle sur toutes les particules, quel que soit le nombre de tissus.
+// Une grille de hachage commune sert aux collisions entre particules (d'un même tissu ou de deux tissus)
+// et avec les sphères; les contacts sont résolus par lots sans particule commune, traités en parallèle.
+class ClothWorld {
+public:
+    // Tissu du monde, de même topologie que Flag: la particule (i, j) a l'indice firstParticle + j * gridWidth + i
+    // et la dernière ligne (j = gridHeight - 1) est fixe
+    struct Cloth {
+        int firstParticle;
+        int gridWidth, gridHeight;
+        glm::vec2 size;         // Dimensions en 3D
+        glm::mat4 transform;    // Placement de la position initiale, celle de Flag::reset()
+    };
+
+    ClothWorld();
+
+    // Ajoute un tissu de grid.x * grid.y particules, avec les paramètres de ressorts de la scène.
+    // Renvoie l'indice du tissu. Invalide les pointeurs renvoyés par getPositions()
+    int addCloth(const glm::ivec2& grid, const glm::vec2& size, const glm::mat4& transform, const SceneConfig& scene);
+
+    // Replace tous les tissus dans leur position initiale, immobiles et sans contacts
+    void reset();
+
+    // Un pas de simulation de tous les tissus: forces, collisions, contacts et intégration.
+    // Les arènes du pool sont vidées au début du pas. Renvoie le nombre d'itérations du solveur de contacts
+    int step(float dt, const SceneConfig& scene, const SphereHandler& sphereHandler, ThreadPool& pool);
+
+    int getClothCount() const {
+        return m_Cloths.size();
+    }
+
+    const Cloth& getCloth(int index) const {
+        return m_Cloths[index];
+    }
+
+    int getParticleCount() const {
+        return m_Positions.size();
+    }
+
+    // Positions de toutes les particules; celles d'un tissu commencent à getCloth(index).firstParticle
+    const glm::vec3* getPositions() const {
+        return m_Positions.data();
+    }
+
+    size_t getSpringCount() const {
+        return m_Springs.size();
+    }
+
+    // Contacts de la dernière frame: particule / sphère et entre particules (d'un même tissu ou non)
+    const ContactCache& getSphereContacts() const {
+        return m_SphereContacts;
+    }
+
+    const ContactCache& getParticleContacts() const {
+        return m_ParticleContacts;
+    }
+
+    // Nombre de lots de contacts indépendants du dernier pas
+    int getBatchCount() const;
+
+    uint64_t getFrame() const {
+        return m_nFrame;
+    }
+
+private:
+    // Ressort vu depuis une de ses extrémités: les ressorts de chaque particule sont consécutifs
+    struct Spring {
+        int other;
+        float K, L, V;
+    };
+
+    // Contacts d'un cache regroupés en lots: deux contacts d'un même lot n'ont pas de particule commune
+    struct Batches {
+        std::vector<int> colors;    // Lot de chaque contact
+        std::vector<int> order;     // Indices des contacts, lot par lot
+        std::vector<int> offsets;   // Début de chaque lot dans order (un de plus pour la fin)
+    };
+
+    // Nombre de lots colorés; les contacts restants forment un dernier lot résolu séquentiellement
+    static const int MAX_BATCH_COLORS = 64;
+
+    void initCloth(int index);
+
+    void applyForces(float dt, const SceneConfig& scene, const SphereHandler& sphereHandler, ThreadPool& pool);
+
+    void detectCollisions(const SceneConfig& scene, const SphereHandler& sphereHandler, ThreadPool& pool);
+
+    void buildBatches(const std::vector<Contact>& contacts, bool pairs, Batches& batches);
+
+    int solveContacts(float dt, int maxIterations, ThreadPool& pool);
+
+    void integrate(float dt, ThreadPool& pool);
+
+    // Deux particules d'un même tissu reliées par des ressorts (jusqu'à deux cases d'écart)
+    bool areNeighbors(int a, int b) const;
+
+    std::vector<Cloth> m_Cloths;
+
+    // Particules de tous les tissus
+    std::vector<glm::vec3> m_Positions;
+    std::vector<glm::vec3> m_Velocities;
+    std::vector<glm::vec3> m_Forces;
+    std::vector<glm::vec3> m_ContactVelocities;
+    std::vector<float> m_InvMasses;     // 0 pour les particules fixes
+    std::vector<int> m_ClothIndices;    // Tissu de chaque particule
+
+    // Ressorts de la particule k: m_Springs[m_SpringStart[k]] à m_Springs[m_SpringStart[k + 1]]
+    std::vector<Spring> m_Springs;
+    std::vector<int> m_SpringStart;
+
+    std::vector<glm::vec3> m_Winds;     // Vent de la frame courante, un tirage par tissu
+
+    SpatialHash m_SpatialHash;
+    ContactCache m_SphereContacts;
+    ContactCache m_ParticleContacts;
+    Batches m_SphereBatches, m_ParticleBatches;
+    std::vector<uint64_t> m_ParticleColors;     // Lots déjà utilisés par chaque particule pendant buildBatches
+    std::vector<float> m_ThreadCorrections;     // Correction maximale de chaque thread pendant une itération du solveur
+
+    uint64_t m_nFrame;
+};
+
+}
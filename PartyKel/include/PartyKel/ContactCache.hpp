@@ -0,0 +1,87 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <vector>
+#include <cstdint>
+
+namespace PartyKel {
+
+// Contact entre une particule et un collisionneur (sphère ou autre particule)
+struct Contact {
+    uint64_t key;       // Identifiant stable du contact d'une frame à l'autre
+    int particle;       // Indice de la particule
+    int other;          // Indice du collisionneur ou de la seconde particule
+    glm::vec3 normal;   // Normale de contact, orientée vers la particule
+    float penetration;  // Profondeur de pénétration
+    float impulse;      // Impulsion normale accumulée par le solveur
+    uint32_t reserved;  // Toujours 0: la structure, écrite telle quelle dans les sauvegardes, n'a pas d'octets de remplissage
+};
+
+static_assert(sizeof(Contact) == 40, "Contact is written as is in checkpoints and must not contain padding");
+
+// Cache de contacts persistant: les contacts trouvés à la frame précédente sont conservés
+// (triés par clé) afin d'initialiser le solveur avec leurs impulsions accumulées (warm-starting).
+// Aucune allocation une fois la capacité des tableaux atteinte.
+class ContactCache {
+public:
+    // Clé d'un contact (particule, collisionneur)
+    static uint64_t colliderKey(int particle, int collider) {
+        return (uint64_t(uint32_t(particle)) << 32) | uint32_t(collider);
+    }
+
+    // Clé d'un contact entre deux particules, indépendante de l'ordre
+    static uint64_t pairKey(int a, int b) {
+        return a < b ? colliderKey(a, b) : colliderKey(b, a);
+    }
+
+    // A appeler avant la détection: les contacts courants deviennent les contacts de la frame précédente
+    void beginFrame();
+
+    // Ajoute un contact; son impulsion est reprise de la frame précédente s'il existait déjà
+    void add(uint64_t key, int particle, int other, const glm::vec3& normal, float penetration);
+
+    // A appeler après la détection: trie les contacts pour la recherche de la frame suivante
+    void endFrame();
+
+    void clear();
+
+    // Remplace les contacts courants (triés par clé), par exemple lors d'un chargement de sauvegarde
+    void restore(const Contact* contacts, size_t count);
+
+    std::vector<Contact>& contacts() {
+        return m_Contacts;
+    }
+
+    const std::vector<Contact>& contacts() const {
+        return m_Contacts;
+    }
+
+    // Nombre de contacts de la frame courante qui existaient à la frame précédente
+    uint32_t persistentCount() const {
+        return m_nPersistentCount;
+    }
+
+    // Appelle f(contact) pour chaque contact apparu (de la frame courante) ou disparu (de la frame précédente),
+    // entre endFrame() et le beginFrame() suivant
+    template<typename F>
+    void forEachChangedContact(const F& f) const {
+        auto current = m_Contacts.begin(), previous = m_PreviousContacts.begin();
+        while (current != m_Contacts.end() || previous != m_PreviousContacts.end()) {
+            if (previous == m_PreviousContacts.end() || (current != m_Contacts.end() && current->key < previous->key)) {
+                f(*current++);
+            } else if (current == m_Contacts.end() || previous->key < current->key) {
+                f(*previous++);
+            } else {
+                ++current;
+                ++previous;
+            }
+        }
+    }
+
+private:
+    std::vector<Contact> m_Contacts;
+    std::vector<Contact> m_PreviousContacts;
+    uint32_t m_nPersistentCount = 0;
+};
+
+}
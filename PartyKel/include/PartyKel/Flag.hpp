@@ -0,0 +1,131 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include "PartyKel/Octree.hpp"
+#include "PartyKel/ContactCache.hpp"
+#include <vector>
+#include <cstdint>
+
+namespace PartyKel {
+
+struct SphereHandler;
+class ThreadPool;
+class CheckpointWriter;
+class CheckpointReader;
+
+// Structure permettant de simuler un drapeau à l'aide un système masse-ressort
+struct Flag {
+    int gridWidth, gridHeight; // Dimensions de la grille de points
+    glm::vec2 size; // Dimensions du drapeau en 3D
+    glm::vec3 offset; // Déplacement du drapeau dans la scène, appliqué par reset()
+
+    // Propriétés physique des points:
+    std::vector<glm::vec3> positionArray;
+    std::vector<glm::vec3> velocityArray;
+    std::vector<float> massArray;
+    std::vector<glm::vec3> forceArray;
+    int nbParticles;
+
+    // Paramètres des forces interne de simulation
+    // Longueurs à vide
+    glm::vec2 L0;
+    float L1;
+    glm::vec2 L2;
+
+    float K0, K1, K2; // Paramètres de résistance
+    float V0, V1, V2; // Paramètres de frein
+
+    // Contacts persistants d'une frame à l'autre (avec les sphères et entre particules)
+    ContactCache sphereContacts;
+    ContactCache selfContacts;
+    std::vector<glm::vec3> contactVelocityArray; // Variations de vitesse calculées par le solveur de contacts
+
+    // Mise en sommeil des zones immobiles, par tuiles de SLEEP_TILE_SIZE x SLEEP_TILE_SIZE particules.
+    // Une tuile dont l'énergie cinétique moyenne par particule reste sous sleepThreshold pendant sleepFrames pas
+    // s'endort: ses particules ne reçoivent plus de forces, ne sont plus intégrées et sont immobiles pour le solveur.
+    // Elle se réveille lorsqu'un de ses contacts apparaît ou disparaît, lorsque la moyenne glissante des forces externes
+    // s'écarte de plus de wakeForceDelta de celle sous laquelle elle s'est endormie (rafale de vent), ou lorsqu'une tuile
+    // voisine bouge (énergie au-dessus du seuil). La moyenne porte sur EXTERNAL_FORCE_FRAMES pas: le vent, tiré dans une
+    // direction aléatoire à chaque pas, ne réveille pas les tuiles. Avec sleepThreshold = 0 (par défaut), aucune tuile ne s'endort
+    static const int SLEEP_TILE_SIZE = 8;
+    static const int EXTERNAL_FORCE_FRAMES = 64;
+    float sleepThreshold;
+    int sleepFrames;
+    float wakeForceDelta;
+    int tileCountX, tileCountY;
+    std::vector<uint8_t> awakeArray;            // 1 si la tuile de la particule est éveillée
+    std::vector<uint8_t> tileAwakeArray;
+    std::vector<int> tileQuietFrameArray;       // Pas consécutifs sous le seuil
+    std::vector<float> tileEnergyArray;         // Énergie cinétique moyenne au dernier pas (tuiles éveillées)
+    std::vector<glm::vec3> tileSleepForceArray; // Moyenne des forces externes au moment de l'endormissement
+    std::vector<uint8_t> rowChangedArray;       // Rangées déplacées par le dernier pas (FlagRenderer3D::setChangedRows)
+    glm::vec3 externalForce;                    // Somme des forces externes du pas en cours
+    glm::vec3 meanExternalForce;                // Moyenne glissante de externalForce
+    int externalForceFrames;                    // Pas comptés dans la moyenne (au plus EXTERNAL_FORCE_FRAMES)
+
+    // Créé un drapeau discretisé sous la forme d'une grille contenant gridWidth * gridHeight
+    // points. Chaque point a pour masse : mass / (gridWidth * gridHeight).
+    // La taille du drapeau en 3D est spécifié par les paramètres width et height
+    Flag(float mass, float width, float height, int gridWidth, int gridHeight);
+
+    // Replace le drapeau dans sa position initiale, immobile et sans contacts, sans réallouer ses tableaux.
+    // Les paramètres des ressorts sont conservés
+    void reset();
+
+    // Applique les forces internes sur chaque point du drapeau SAUF les points fixes
+    void applyInternalForces(float dt);
+
+    // L'octree contient les indices des particules.
+    // Avec skipContactPairs (solveur de contacts actif), seuls les voisins ignorés par detectSelfContacts
+    // sont repoussés: les autres paires sont résolues par le solveur
+    void applyRepulseForces(Octree<int>& octree, float maxDst, float multRepulse, bool skipContactPairs = false);
+
+    // Applique une force externe sur chaque point du drapeau SAUF les points fixes
+    void applyExternalForce(const glm::vec3& F);
+
+    // Force de pénalité des sphères; inutile avec le solveur de contacts, qui résout les mêmes contacts
+    void applySphereCollision(const SphereHandler& sphereHandler, float multiplier, float radiusDelta);
+
+    // Recherche les contacts particule / sphère. Les contacts déjà présents à la frame
+    // précédente conservent leur impulsion accumulée
+    void detectSphereContacts(const SphereHandler& sphereHandler, float radiusDelta);
+
+    // Recherche les paires de particules plus proches que minDst à l'aide de l'octree.
+    // Les voisins reliés par des ressorts (jusqu'à deux cases d'écart) sont ignorés.
+    // Avec un pool, la recherche est répartie entre les threads: chacun collecte ses paires dans
+    // son arène (ThreadPool::getFrameArena), qui doit être vidée entre deux pas
+    void detectSelfContacts(Octree<int>& octree, float minDst, ThreadPool* pool = nullptr);
+
+    // Résout les contacts par impulsions séquentielles sur les vitesses prédites (v + dt * F / m).
+    // Le solveur part des impulsions de la frame précédente (warm-starting) et s'arrête dès que
+    // les corrections deviennent négligeables. Renvoit le nombre d'itérations effectuées
+    int solveContacts(float dt, int maxIterations);
+
+    // Met à jour la vitesse et la position de chaque point éveillé du drapeau
+    // en utilisant un schema de type Leapfrog, puis l'état des tuiles (updateSleeping)
+    void update(float dt);
+
+    // Endort et réveille les tuiles d'après les vitesses et les contacts du pas qui vient d'être intégré
+    void updateSleeping();
+
+    // Réveille toutes les tuiles; toutes les rangées sont marquées comme déplacées
+    void wakeAll();
+
+    // Réveille la tuile de la particule k, par exemple au contact d'un autre drapeau (FlagCollisions)
+    void wakeParticle(int k);
+
+    // Change l'état d'une tuile; les vitesses d'une tuile endormie sont annulées
+    void setTileAwake(int tile, bool awake);
+
+    int getSleepingTileCount() const;
+
+    // Sauvegarde l'état complet du drapeau: tableaux des particules, paramètres et contacts persistants
+    void save(CheckpointWriter& checkpoint) const;
+
+    // Restaure un état écrit par save(), en copiant les tableaux du fichier projeté.
+    // Le drapeau doit avoir les mêmes dimensions de grille
+    void load(const CheckpointReader& checkpoint);
+};
+
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include "PartyKel/ContactCache.hpp"
+#include "PartyKel/SpatialHash.hpp"
+#include <vector>
+
+namespace PartyKel {
+
+struct Flag;
+class ThreadPool;
+
+// Collisions de plusieurs drapeaux indépendants, entre eux et avec eux-mêmes.
+// Les boîtes englobantes des drapeaux, élargies de la distance de collision, sont comparées d'abord:
+// les particules de deux drapeaux dont les boîtes ne se recouvrent pas ne sont jamais comparées.
+// Les particules de tous les drapeaux sont ensuite rangées dans une grille commune, parcourue une seule fois
+// pour les répulsions et les contacts d'un même drapeau (Flag::selfContacts) ou de deux drapeaux (contacts mutuels).
+class FlagCollisions {
+public:
+    // Remplace Flag::applyRepulseForces et Flag::detectSelfContacts de chaque drapeau, sans octree.
+    // Avec findContacts, la répulsion ne s'applique qu'aux paires que le solveur ignore (voisins de la grille);
+    // sans, seules les forces de répulsion sont appliquées et les contacts sont effacés.
+    // Les candidats sont collectés dans les arènes du pool, qui doivent être vidées entre deux pas
+    void detect(const std::vector<Flag*>& flags, float maxDst, float multRepulse, bool findContacts, ThreadPool& pool);
+
+    // Résout les contacts mutuels, après Flag::solveContacts de chaque drapeau et avant Flag::update.
+    // Les corrections sont ajoutées aux vitesses. Renvoie le nombre d'itérations effectuées
+    int solveContacts(const std::vector<Flag*>& flags, float dt, int maxIterations);
+
+    // Contacts entre deux drapeaux; les particules sont numérotées à la suite, drapeau par drapeau
+    const ContactCache& getMutualContacts() const {
+        return m_MutualContacts;
+    }
+
+    // Paires de drapeaux dont les boîtes se recouvrent lors du dernier appel à detect()
+    int getOverlappingPairCount() const {
+        return m_nOverlappingPairs;
+    }
+
+private:
+    struct Box {
+        glm::vec3 min, max;
+    };
+
+    bool overlap(int a, int b) const {
+        return m_Overlaps[a * m_Boxes.size() + b] != 0;
+    }
+
+    std::vector<Box> m_Boxes;
+    std::vector<char> m_Overlaps;           // Recouvrement des boîtes de chaque paire de drapeaux
+    int m_nOverlappingPairs = 0;
+
+    // Particules de tous les drapeaux, à la suite
+    std::vector<int> m_FirstParticles;      // Première particule de chaque drapeau (un de plus pour le total)
+    std::vector<int> m_FlagIndices;         // Drapeau de chaque particule
+    std::vector<glm::vec3> m_Positions;     // Copie des positions pour la grille
+    std::vector<glm::vec3> m_ContactVelocities;
+
+    SpatialHash m_SpatialHash;
+    ContactCache m_MutualContacts;
+};
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <algorithm>
+
+namespace PartyKel {
+
+// Forces élémentaires des systèmes masse-ressort (drapeau et vêtements)
+
+// Calcule une force de type ressort de Hook entre deux particules de positions P1 et P2
+// K est la résistance du ressort et L sa longueur à vide
+inline glm::vec3 hookForce(float K, float L, const glm::vec3& P1, const glm::vec3& P2) {
+    static const float epsilon = 0.0001;
+    return K * (1-(L/std::max(glm::distance(P1, P2), epsilon))) * (P2 - P1);
+}
+
+inline glm::vec3 repulseForce(float dst, const glm::vec3& P1, const glm::vec3& P2) {
+    glm::vec3 direction = glm::normalize(P1 - P2);
+    return direction * (1 / (1 + glm::pow(dst, 2.f)));
+}
+
+// Calcule une force de type frein cinétique entre deux particules de vélocités v1 et v2
+// V est le paramètre du frein
+// dt est le pas temporel (delta time)
+inline glm::vec3 brakeForce(float V, float dt, const glm::vec3& v1, const glm::vec3& v2) {
+    return V * ((v2-v1) / dt);
+}
+
+// Force de répulsion d'une sphère de centre sphereCenter sur une particule à distanceToCenter de ce centre
+inline glm::vec3 sphereCollisionForce(float distanceToCenter,
+                                      const glm::vec3& sphereCenter,
+                                      const glm::vec3& particlePosition) {
+    glm::vec3 direction = glm::normalize(particlePosition - sphereCenter);
+    return direction * (1 / (1 + glm::pow(distanceToCenter, 2.f)));
+}
+
+// Ressorts d'une grille de points (Flag, ClothTile, ClothWorld), par topologie:
+// voisins directs (0), diagonales (1) et voisins à deux cases (2)
+struct GridSprings {
+    float K0, K1, K2;   // Paramètres de résistance
+    float V0, V1, V2;   // Paramètres de frein
+    glm::vec2 L0;       // Longueurs à vide (horizontale, verticale) des voisins directs
+    float L1;           // Longueur à vide des diagonales
+    glm::vec2 L2;       // Longueurs à vide des voisins à deux cases
+};
+
+// Longueurs à vide d'une grille de gridWidth * gridHeight points couvrant size au repos.
+// Les voisins à deux cases reçoivent 4 * L0 et non 2 * L0: valeur d'origine du drapeau, sur laquelle les scènes sont réglées
+inline void gridRestLengths(const glm::vec2& size, int gridWidth, int gridHeight, glm::vec2& L0, float& L1, glm::vec2& L2) {
+    L0 = glm::vec2(size.x / (gridWidth - 1), size.y / (gridHeight - 1));
+    L1 = glm::length(L0);
+    L2 = 4.f * L0;
+}
+
+// Appelle spring(x, y, K, L, V) pour chaque ressort reliant la particule (i, j) d'une grille de
+// gridWidth * gridHeight points à son voisin (x, y), dans l'ordre de Flag::applyInternalForces.
+// Comme dans le drapeau d'origine, les deux premiers voisins existants d'une topologie 0 ou 2 reçoivent
+// la longueur horizontale: au bord, un ressort vertical peut donc recevoir la longueur horizontale.
+// Renvoit le nombre de ressorts
+template<typename F>
+inline int forEachGridSpring(int i, int j, int gridWidth, int gridHeight, const GridSprings& springs, F spring) {
+    static const glm::ivec2 offsets[3][4] = {
+        { glm::ivec2(1, 0), glm::ivec2(-1, 0), glm::ivec2(0, -1), glm::ivec2(0, 1) },
+        { glm::ivec2(-1, -1), glm::ivec2(1, -1), glm::ivec2(1, 1), glm::ivec2(-1, 1) },
+        { glm::ivec2(-2, 0), glm::ivec2(2, 0), glm::ivec2(0, -2), glm::ivec2(0, 2) }
+    };
+    const float K[3] = { springs.K0, springs.K1, springs.K2 };
+    const float V[3] = { springs.V0, springs.V1, springs.V2 };
+    const glm::vec2 L[3] = { springs.L0, glm::vec2(springs.L1), springs.L2 };
+
+    int count = 0;
+    for (int topology = 0; topology < 3; ++topology) {
+        int found = 0;
+        for (const glm::ivec2& offset : offsets[topology]) {
+            int x = i + offset.x, y = j + offset.y;
+            if (x < 0 || y < 0 || x >= gridWidth || y >= gridHeight)
+                continue;
+            spring(x, y, K[topology], found < 2 ? L[topology].x : L[topology].y, V[topology]);
+            ++found;
+        }
+        count += found;
+    }
+    return count;
+}
+
+}
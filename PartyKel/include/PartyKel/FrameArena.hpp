@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+
+namespace PartyKel {
+
+// Allocateur linéaire pour les données temporaires d'un pas de simulation (contacts candidats,
+// listes de paires...): chaque allocation avance un pointeur dans un bloc, et reset() libère
+// toutes les allocations d'un coup. Les destructeurs ne sont pas appelés: seuls les types
+// trivialement destructibles y sont placés.
+// Si un pas dépasse la capacité, des blocs supplémentaires sont chaînés; au reset() suivant ils sont
+// remplacés par un bloc unique assez grand: une fois dimensionnée, l'arène n'alloue plus.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialCapacity = 64 * 1024);
+
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+
+    FrameArena& operator =(const FrameArena&) = delete;
+
+    // Mémoire non initialisée de size octets, alignée sur alignment (puissance de 2)
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Tableau non initialisé de count éléments
+    template<typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never calls destructors");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Libère toutes les allocations. Les pointeurs obtenus depuis le dernier reset() deviennent invalides
+    void reset();
+
+    // Octets alloués depuis le dernier reset()
+    size_t getUsedBytes() const {
+        return m_nUsedBytes;
+    }
+
+    size_t getCapacity() const;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    void addBlock(size_t minimumSize);
+
+    std::vector<Block> m_Blocks;    // Le dernier bloc est le bloc courant
+    size_t m_nInitialCapacity;
+    size_t m_nOffset;               // Position dans le bloc courant
+    size_t m_nUsedBytes;
+    size_t m_nFrameBytes;           // Octets réservés par le pas courant, alignements et fins de blocs compris
+};
+
+// Liste de valeurs placée dans une arène: blocs chaînés de taille croissante, les valeurs ne sont
+// jamais déplacées. Sert à collecter un nombre inconnu de résultats par thread
+template<typename T>
+class ArenaList {
+public:
+    explicit ArenaList(FrameArena& arena):
+        m_pArena(&arena), m_pFirst(nullptr), m_pLast(nullptr), m_nSize(0) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never calls destructors");
+    }
+
+    void push_back(const T& value) {
+        if (!m_pLast || m_pLast->count == m_pLast->capacity) {
+            size_t capacity = m_pLast ? 2 * m_pLast->capacity : 64;
+            Block* block = static_cast<Block*>(m_pArena->allocate(sizeof(Block), alignof(Block)));
+            block->values = m_pArena->allocateArray<T>(capacity);
+            block->count = 0;
+            block->capacity = capacity;
+            block->next = nullptr;
+            if (m_pLast)
+                m_pLast->next = block;
+            else
+                m_pFirst = block;
+            m_pLast = block;
+        }
+        new (&m_pLast->values[m_pLast->count++]) T(value);
+        ++m_nSize;
+    }
+
+    size_t size() const {
+        return m_nSize;
+    }
+
+    // Appelle f(value) sur chaque valeur, dans l'ordre d'insertion
+    template<typename F>
+    void forEach(F f) const {
+        for (const Block* block = m_pFirst; block; block = block->next) {
+            for (size_t k = 0; k < block->count; ++k)
+                f(block->values[k]);
+        }
+    }
+
+private:
+    struct Block {
+        T* values;
+        size_t count, capacity;
+        Block* next;
+    };
+
+    FrameArena* m_pArena;
+    Block* m_pFirst;
+    Block* m_pLast;
+    size_t m_nSize;
+};
+
+}
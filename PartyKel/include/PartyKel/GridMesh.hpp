@@ -0,0 +1,30 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <vector>
+#include <cstdint>
+
+namespace PartyKel {
+
+class ThreadPool;
+
+// Calcul des normales d'une grille de gridWidth * gridHeight sommets, indépendant d'OpenGL.
+// Chaque quad (i, j) est découpé en deux triangles (i, j) (i+1, j) (i+1, j+1) et (i, j) (i+1, j+1) (i, j+1),
+// comme dans l'index buffer de FlagRenderer3D. faceNormalArray contient 2 * (gridWidth - 1) * (gridHeight - 1) normales.
+
+// Première passe: normales unitaires des deux triangles de chaque quad des lignes [rowBegin, rowEnd)
+void computeGridFaceNormals(const glm::vec3* positionArray, int gridWidth, int gridHeight,
+                            glm::vec3* faceNormalArray, int rowBegin, int rowEnd);
+
+// Seconde passe: normale de chaque sommet des lignes [rowBegin, rowEnd), moyenne des normales des triangles adjacents
+void gatherGridVertexNormals(const glm::vec3* faceNormalArray, int gridWidth, int gridHeight,
+                             glm::vec3* normalArray, int rowBegin, int rowEnd);
+
+// Indices des triangles de la grille (6 par quad, dans l'ordre des normales de faces)
+void buildGridIndices(int gridWidth, int gridHeight, std::vector<uint32_t>& indexArray);
+
+// Enchaîne les deux passes sur toute la grille, en parallèle sur les lignes si un pool est fourni
+void computeGridNormals(const glm::vec3* positionArray, int gridWidth, int gridHeight,
+                        glm::vec3* faceNormalArray, glm::vec3* normalArray, ThreadPool* pool = nullptr);
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace PartyKel {
+
+// Contexte OpenGL sans fenêtre (EGL surfaceless, fonctionne avec Mesa llvmpipe) rendant dans un FBO.
+// Chaque frame est relue de manière asynchrone via des pixel buffer objects, puis écrite
+// en PPM (outputDirectory/frame_00000.ppm, ...) par un thread d'encodage.
+class HeadlessRenderer {
+public:
+    // Nombre de PBO: la frame n est relue pendant que les frames n+1 et n+2 sont rendues
+    static const int PBO_COUNT = 3;
+
+    HeadlessRenderer(uint32_t width, uint32_t height, const std::string& outputDirectory);
+
+    ~HeadlessRenderer();
+
+    HeadlessRenderer(const HeadlessRenderer&) = delete;
+
+    HeadlessRenderer& operator =(const HeadlessRenderer&) = delete;
+
+    // A appeler à la fin du rendu d'une frame: lance sa relecture et récupère les frames précédentes terminées
+    void endFrame();
+
+    // Nombre de frames rendues
+    uint32_t getFrameCount() const {
+        return m_nFrameCount;
+    }
+
+private:
+    struct Frame {
+        uint32_t index;
+        std::vector<uint8_t> pixels;
+    };
+
+    void createContext();
+    void destroyContext();
+
+    // Copie le PBO de la frame index dans une image et la confie au thread d'encodage
+    void collectFrame(uint32_t index);
+
+    void encoderLoop();
+    void writeFrame(const Frame& frame);
+
+    uint32_t m_nWidth, m_nHeight;
+    std::string m_OutputDirectory;
+
+    // Ressources EGL (types opaques pour ne pas inclure EGL dans l'en-tête)
+    void* m_pDisplay;
+    void* m_pContext;
+
+    GLuint m_FBOID, m_ColorRBOID, m_DepthRBOID;
+    GLuint m_PBOIDs[PBO_COUNT];
+    GLsync m_PBOFences[PBO_COUNT];
+    uint32_t m_nFrameCount;
+
+    // Images prêtes à être encodées et images libres (réutilisées pour éviter les allocations)
+    std::deque<Frame> m_PendingFrames;
+    std::vector<Frame> m_FreeFrames;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_bStop;
+    std::thread m_EncoderThread;
+};
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include "PartyKel/TriangleMesh.hpp"
+#include <vector>
+#include <cstdint>
+
+namespace PartyKel {
+
+struct SphereHandler;
+
+// Ressort entre les particules a et b
+struct Spring {
+    uint32_t a, b;
+    float restLength;   // Longueur à vide, distance initiale entre les deux particules
+};
+
+// Tissu masse-ressort construit à partir d'un maillage triangulaire quelconque (panneau de vêtement...).
+// Les ressorts reprennent les trois topologies du drapeau, déduites des arêtes et des adjacences du maillage:
+// - structure (K0, V0): chaque arête du maillage;
+// - cisaillement (K1, V1): les deux sommets opposés à une arête partagée par deux triangles
+//   (la seconde diagonale du quadrilatère formé par les deux triangles);
+// - courbure (K2, V2): les deux extrémités des paires d'arêtes alignées passant par un sommet
+//   (équivalent des voisins à deux cases de la grille).
+// Les sommets sont renumérotés selon une courbe de Morton pour que les particules proches dans l'espace
+// (et donc reliées par des ressorts) soient proches en mémoire; les ressorts et les triangles suivent cet ordre.
+struct MeshCloth {
+    // Propriétés physique des points (dans l'ordre renuméroté):
+    std::vector<glm::vec3> positionArray;
+    std::vector<glm::vec3> velocityArray;
+    std::vector<float> massArray;
+    std::vector<glm::vec3> forceArray;
+    std::vector<uint8_t> fixedArray;    // 1 pour les points fixes (aucune force appliquée)
+    int nbParticles;
+
+    std::vector<uint32_t> indexArray;   // Triangles (renumérotés), 3 indices par triangle
+    std::vector<uint32_t> vertexRemap;  // Nouvel indice de chaque sommet du maillage d'origine
+
+    std::vector<Spring> structuralSprings;
+    std::vector<Spring> shearSprings;
+    std::vector<Spring> bendSprings;
+
+    float K0, K1, K2; // Paramètres de résistance
+    float V0, V1, V2; // Paramètres de frein
+
+    // Chaque particule a pour masse particleMass
+    MeshCloth(const TriangleMesh& mesh, float particleMass);
+
+    // Fixe les points dont l'ordonnée est supérieure ou égale à y (vêtement suspendu)
+    void fixAbove(float y);
+
+    // Applique les forces des ressorts; chaque ressort est évalué une fois et agit sur ses deux particules
+    void applyInternalForces(float dt);
+
+    // Applique une force externe sur chaque point du tissu SAUF les points fixes
+    void applyExternalForce(const glm::vec3& F);
+
+    void applySphereCollision(const SphereHandler& sphereHandler, float multiplier, float radiusDelta);
+
+    // Met à jour la vitesse et la position de chaque point (Leapfrog), les points fixes ne bougent pas
+    void update(float dt);
+
+private:
+    void applySprings(const std::vector<Spring>& springs, float K, float V, float dt);
+
+    void reorderVertices(const TriangleMesh& mesh);
+    void buildSprings();
+};
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace PartyKel {
+
+// Export d'une séquence de maillages (un fichier par frame: outputDirectory/frame_00000.ply, ...)
+// pour les outils de DCC. La topologie (triangles) est sérialisée une seule fois à la construction:
+// - par défaut, elle est écrite une fois dans outputDirectory/topology.<ext>, maillage complet dont les sommets sont
+//   referencePositions (par exemple la position de repos), et les frames ne contiennent que les sommets;
+// - embedTopology: chaque fichier de frame est un maillage complet, le bloc de faces est recopié tel quel.
+// L'écriture est faite par un thread dédié à partir d'un nombre fixe de tampons préalloués:
+// submit() ne fait qu'une copie des positions, et ne bloque jamais si la politique est Drop.
+class MeshSequenceExporter {
+public:
+    enum class Format {
+        BinaryPLY,  // PLY binaire little endian, positions en float et faces en listes uchar / int
+        OBJ         // OBJ texte
+    };
+
+    // Comportement de submit() quand tous les tampons sont en attente d'écriture
+    enum class Backpressure {
+        Drop,       // La frame est ignorée (et comptée dans droppedFrames): la simulation n'attend jamais le disque
+        Block       // submit() attend qu'un tampon se libère (temps compté dans blockedMilliseconds)
+    };
+
+    struct Stats {
+        uint32_t submittedFrames;   // Frames acceptées par submit()
+        uint32_t writtenFrames;     // Frames écrites sur le disque
+        uint32_t droppedFrames;     // Frames ignorées faute de tampon libre
+        uint32_t failedFrames;      // Frames dont l'écriture a échoué
+        uint32_t pendingFrames;     // Frames en attente d'écriture
+        uint32_t maxPendingFrames;  // Plus grand nombre de frames en attente observé
+        double blockedMilliseconds; // Temps passé par submit() à attendre un tampon
+    };
+
+    MeshSequenceExporter(const std::string& outputDirectory, uint32_t vertexCount,
+                         const std::vector<uint32_t>& triangleIndices, const glm::vec3* referencePositions,
+                         Format format = Format::BinaryPLY, uint32_t bufferCount = 4,
+                         Backpressure backpressure = Backpressure::Drop, bool embedTopology = false);
+
+    ~MeshSequenceExporter();
+
+    MeshSequenceExporter(const MeshSequenceExporter&) = delete;
+
+    MeshSequenceExporter& operator =(const MeshSequenceExporter&) = delete;
+
+    // Confie les vertexCount positions d'une frame au thread d'écriture.
+    // Chaque appel consomme un numéro de frame, y compris si la frame est ignorée: les frames perdues
+    // apparaissent comme des trous dans la numérotation des fichiers. Renvoit false si la frame est ignorée
+    bool submit(const glm::vec3* positionArray);
+
+    // Attend l'écriture des frames en attente
+    void flush();
+
+    Stats getStats() const;
+
+    // true si le disque n'a pas suivi depuis la création (frames ignorées ou submit() bloqué)
+    bool isFallingBehind() const;
+
+private:
+    struct Frame {
+        uint32_t index;
+        std::vector<glm::vec3> positions;
+    };
+
+    void writerLoop();
+    void writeFrame(const Frame& frame);
+    void writeTopology(const glm::vec3* referencePositions);
+
+    std::string m_OutputDirectory;
+    uint32_t m_nVertexCount;
+    uint32_t m_nTriangleCount;
+    Format m_Format;
+    Backpressure m_Backpressure;
+    bool m_bEmbedTopology;
+
+    // Bloc de faces sérialisé une fois dans le format de sortie
+    std::vector<char> m_Topology;
+
+    // Tampon de mise en forme des sommets (thread d'écriture uniquement)
+    std::vector<char> m_VertexBuffer;
+
+    std::vector<Frame> m_Frames;        // Tampons préalloués
+    std::vector<Frame*> m_FreeFrames;
+    std::deque<Frame*> m_PendingFrames;
+    Frame* m_pWritingFrame;
+    uint32_t m_nNextIndex;
+    Stats m_Stats;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_bStop;
+    std::thread m_WriterThread;
+};
+
+}
@@ -2,8 +2,10 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtx/string_cast.hpp>
+#include "PartyKel/ProfileCounters.hpp"
 #include <vector>
 #include <string>
+#include <stdexcept>
 #include <iostream>
 
 namespace PartyKel {
@@ -12,67 +14,151 @@ namespace PartyKel {
     class Octree {
     private:
         /**
-         * Depth of the octree.
-         * depth = 0 -> 1 voxel
-         * depth = 1 -> 8 voxels
-         * depth = n -> 8^n voxels
+         * A voxel of the octree.
+         * Nodes and values are stored in pools owned by the octree and recycled: once the pools
+         * are large enough for the scene, adding & removing values does not allocate memory
          */
-        int _depth;
+        struct Node {
+            /**
+             * Depth of the voxel.
+             * depth = 0 -> 1 voxel (a leaf)
+             * depth = 1 -> 8 voxels
+             * depth = n -> 8^n voxels
+             */
+            int depth;
+
+            /**
+             * Space position (center) of the voxel.
+             */
+            glm::vec3 position;
+
+            /**
+             * Dimension ( = scale) of the voxel.
+             * Example for a dim 2 octree
+             * Dimension at depth 0 : 2
+             * Dimension at depth 1 : 2/2 = 1
+             * Dimension at depth 2 : 2/4 = 0.5
+             * Dimension at depth n : 2/2^n
+             */
+            glm::vec3 dimension;
+
+            /**
+             * Index of the parent voxel, -1 for the root
+             */
+            int parent;
+
+            /**
+             * Index of the first of the 8 consecutive children, -1 if children have not been constructed
+             */
+            int firstChild;
+
+            /**
+             * Values of a leaf: first and last entries of its list, -1 if empty
+             */
+            int firstValue;
+            int lastValue;
+            int valueCount;
+
+            /**
+             * Number of values stored in the voxel and its children
+             */
+            int subtreeCount;
+        };
 
         /**
-         * Space position of the octree.
+         * A value stored in a leaf, linked to the next value of the same leaf
          */
-        glm::vec3 _position;
+        struct Entry {
+            T value;
+            int next;
+        };
 
+    public:
         /**
-         * Dimension ( = scale) of the octree.
-         * Example for a dim 2 octree
-         * Dimension at depth 0 : 2
-         * Dimension at depth 1 : 2/2 = 1
-         * Dimension at depth 2 : 2/4 = 0.5
-         * Dimension at depth n : 2/2^n
+         * Values of a voxel, as returned by get(). Iterating over the range
+         * walks the list of the voxel in the entry pool
          */
-        glm::vec3 _dimension;
+        class ValueRange {
+        public:
+            class iterator {
+            public:
+                iterator(const std::vector<Entry>* entries, int index) : _entries(entries), _index(index) { }
+
+                const T& operator*() const { return (*_entries)[_index].value; }
+
+                iterator& operator++() {
+                    _index = (*_entries)[_index].next;
+                    return *this;
+                }
+
+                bool operator!=(const iterator& other) const { return _index != other._index; }
+
+            private:
+                const std::vector<Entry>* _entries;
+                int _index;
+            };
+
+            ValueRange(const std::vector<Entry>* entries, int first, int count) :
+                _entries(entries), _first(first), _count(count) { }
+
+            iterator begin() const { return iterator(_entries, _first); }
 
+            iterator end() const { return iterator(_entries, -1); }
+
+            size_t size() const { return _count; }
+
+            bool empty() const { return _count == 0; }
+
+        private:
+            const std::vector<Entry>* _entries;
+            int _first;
+            int _count;
+        };
+
+    private:
         /**
-         * Children of the current octree
-         * if _initChildren = false, this vector is empty
+         * Node pool, _nodes[0] is the root.
+         * Children are allocated by blocks of 8 consecutive nodes
          */
-        std::vector<Octree> _children;
+        std::vector<Node> _nodes;
 
         /**
-         * La madre of the octree.
-         * = nullptr if octree is root
+         * First free block of 8 nodes, -1 if none.
+         * Free blocks are linked by the firstChild field of their first node
          */
-        Octree* _madre;
+        int _freeBlock;
 
         /**
-         * If depth != 0 this vector is empty
+         * Value pool and head of its list of free entries (linked by their next field), -1 if none
          */
-        std::vector<T> _values;
+        std::vector<Entry> _entries;
+        int _freeEntry;
 
         /**
-         *  _initChildren = true if children have been constructed
+         * Initialize the 8 children of a voxel, reusing a free block if possible
          */
-        bool _initChildren;
+        void initChildren(int node);
 
         /**
-         * Initialize the 8 children of the octree.
-         * Calls the constructor 8 times
+         * Give the children of an empty voxel (and recursively theirs) back to the node pool
          */
-        void initChildren();
+        void releaseChildren(int node);
 
         /**
-         * From an octree, jump recursively to madre & remove all empty children
+         * Index of the first child of a voxel containing the given position, -1 if none
          */
-        void cleanRecursive();
+        int childContaining(int node, const glm::vec3& position) const;
+
+        bool contains(const Node& node, const glm::vec3& position) const;
+
+        void throwOutOfBounds(const char* action, const glm::vec3& position, const Node& node) const;
 
     public:
         /**
          * This method only initialize depth, position & dimension of the octree
          * It does not init all children voxels
          */
-        Octree(int depth, const glm::vec3 &position, const glm::vec3& dim, Octree<T>* madre = nullptr);
+        Octree(int depth, const glm::vec3 &position, const glm::vec3& dim);
 
         /**
          * Add a value in the octree.
@@ -81,18 +167,21 @@ namespace PartyKel {
         void add(const T& value, const glm::vec3& position);
 
         /**
-         * Remove a all value occurences at a specified position, if it exists
+         * Remove a value at a specified position, if it exists
+         * If the value was added several times, only its first occurence is removed
          * value should overload "==" operator
+         * Voxels left empty are given back to the node pool
          */
         void remove(const T& value, const glm::vec3& position);
 
         /**
          * Returns all the values stored at a specified position in the octree
+         * The range is valid until the next call to add or remove
          */
-        std::vector<T>& get(const glm::vec3& position);
+        ValueRange get(const glm::vec3& position);
 
         /**
-         * Return true if the given position is inside the voxel
+         * Return true if the given position is inside the octree
          */
         bool contains(const glm::vec3& position);
 
@@ -105,158 +194,218 @@ namespace PartyKel {
     // ***********************************************************************************************************************************************
 
     template <typename T>
-    Octree<T>::Octree(int depth, const glm::vec3 &position, const glm::vec3& dimension, Octree<T>* madre) :
-            _depth(depth),
-            _position(position),
-            _dimension(dimension),
-            _madre(madre),
-            _initChildren(false)
-    { }
+    Octree<T>::Octree(int depth, const glm::vec3 &position, const glm::vec3& dimension) :
+            _freeBlock(-1),
+            _freeEntry(-1)
+    {
+        _nodes.push_back(Node{ depth, position, dimension, -1, -1, -1, -1, 0, 0 });
+    }
 
     template <typename T>
-    void Octree<T>::initChildren() {
-        if (_initChildren || _depth == 0) return;
-
-        glm::vec3 offset = _dimension / 4.f;
-        glm::vec3 childDimension = _dimension / 2.f;
-
-        // top of the octree
-        _children.push_back(Octree<T>(_depth-1, glm::vec3(_position.x + offset.x, _position.y + offset.y, _position.z + offset.z), childDimension, this));
-        _children.push_back(Octree<T>(_depth-1, glm::vec3(_position.x + offset.x, _position.y + offset.y, _position.z - offset.z), childDimension, this));
-        _children.push_back(Octree<T>(_depth-1, glm::vec3(_position.x - offset.x, _position.y + offset.y, _position.z + offset.z), childDimension, this));
-        _children.push_back(Octree<T>(_depth-1, glm::vec3(_position.x - offset.x, _position.y + offset.y, _position.z - offset.z), childDimension, this));
+    void Octree<T>::initChildren(int node) {
+        if (_nodes[node].firstChild >= 0 || _nodes[node].depth == 0) return;
+
+        int block = _freeBlock;
+        if (block >= 0) {
+            _freeBlock = _nodes[block].firstChild;
+        } else {
+            block = _nodes.size();
+            _nodes.resize(_nodes.size() + 8);
+        }
 
-        //bottom of the octree
-        _children.push_back(Octree<T>(_depth-1, glm::vec3(_position.x + offset.x, _position.y - offset.y, _position.z + offset.z), childDimension, this));
-        _children.push_back(Octree<T>(_depth-1, glm::vec3(_position.x + offset.x, _position.y - offset.y, _position.z - offset.z), childDimension, this));
-        _children.push_back(Octree<T>(_depth-1, glm::vec3(_position.x - offset.x, _position.y - offset.y, _position.z + offset.z), childDimension, this));
-        _children.push_back(Octree<T>(_depth-1, glm::vec3(_position.x - offset.x, _position.y - offset.y, _position.z - offset.z), childDimension, this));
+        const Node& madre = _nodes[node];
+        glm::vec3 offset = madre.dimension / 4.f;
+        glm::vec3 childDimension = madre.dimension / 2.f;
+        const glm::vec3& p = madre.position;
+
+        const glm::vec3 positions[8] = {
+            // top of the octree
+            glm::vec3(p.x + offset.x, p.y + offset.y, p.z + offset.z),
+            glm::vec3(p.x + offset.x, p.y + offset.y, p.z - offset.z),
+            glm::vec3(p.x - offset.x, p.y + offset.y, p.z + offset.z),
+            glm::vec3(p.x - offset.x, p.y + offset.y, p.z - offset.z),
+
+            //bottom of the octree
+            glm::vec3(p.x + offset.x, p.y - offset.y, p.z + offset.z),
+            glm::vec3(p.x + offset.x, p.y - offset.y, p.z - offset.z),
+            glm::vec3(p.x - offset.x, p.y - offset.y, p.z + offset.z),
+            glm::vec3(p.x - offset.x, p.y - offset.y, p.z - offset.z)
+        };
+
+        for (int k = 0; k < 8; ++k) {
+            _nodes[block + k] = Node{ madre.depth - 1, positions[k], childDimension, node, -1, -1, -1, 0, 0 };
+        }
+        _nodes[node].firstChild = block;
 
-        _initChildren = true;
+        PK_COUNT(PROFILE_OCTREE_NODES_ALLOCATED, 8);
     }
 
     template <typename T>
-    void Octree<T>::cleanRecursive() {
-
-        bool allChildrenEmpty = true;
+    void Octree<T>::releaseChildren(int node) {
+        int block = _nodes[node].firstChild;
+        if (block < 0) return;
 
-        for (auto& child : _children) {
-            if (child._initChildren) {
-                allChildrenEmpty = false;
-                break;
-            }
+        for (int k = 0; k < 8; ++k) {
+            releaseChildren(block + k);
         }
 
-        if (allChildrenEmpty) {
-            _children.clear();
-            _initChildren = false;
-        }
+        _nodes[block].firstChild = _freeBlock;
+        _freeBlock = block;
+        _nodes[node].firstChild = -1;
+    }
 
-        if (_madre != nullptr) {
-            _madre->cleanRecursive();
-            return;
+    template <typename T>
+    int Octree<T>::childContaining(int node, const glm::vec3& position) const {
+        int block = _nodes[node].firstChild;
+        for (int k = 0; k < 8; ++k) {
+            if (contains(_nodes[block + k], position)) {
+                return block + k;
+            }
         }
+        return -1;
     }
 
     template <typename T>
     void Octree<T>::add(const T& value, const glm::vec3& position) {
 
-        if (_depth == 0 && contains(position)) {
-            _values.push_back(value);
-            return;
-        }
-
-        if (contains(position)) {
-            initChildren();
-            for(auto& octree : _children) {
-                if (octree.contains(position)) {
-                    octree.add(value, position);
-                    return;
-                }
+        int node = 0;
+        while (_nodes[node].depth != 0 || !contains(_nodes[node], position)) {
+            if (!contains(_nodes[node], position)) {
+                throwOutOfBounds("add", position, _nodes[node]);
+            }
+            initChildren(node);
+            int child = childContaining(node, position);
+            if (child < 0) {
+                throwOutOfBounds("add", position, _nodes[node]);
             }
+            node = child;
         }
 
-        std::string error = "Trying to add object at " + glm::to_string(position);
-        error += " which is out of bounds of octree ( position = " + glm::to_string(_position);
-        error += ", dimension = " + glm::to_string(_dimension) + " )";
+        int entry = _freeEntry;
+        if (entry >= 0) {
+            _freeEntry = _entries[entry].next;
+            _entries[entry].value = value;
+        } else {
+            entry = _entries.size();
+            _entries.push_back(Entry{ value, -1 });
+        }
 
-        throw std::out_of_range(error);
+        // Values are appended: they are returned in insertion order
+        Node& leaf = _nodes[node];
+        _entries[entry].next = -1;
+        if (leaf.lastValue >= 0)
+            _entries[leaf.lastValue].next = entry;
+        else
+            leaf.firstValue = entry;
+        leaf.lastValue = entry;
+        ++leaf.valueCount;
+
+        for (int n = node; n >= 0; n = _nodes[n].parent) {
+            ++_nodes[n].subtreeCount;
+        }
     }
 
     template <typename T>
     void Octree<T>::remove(const T& value, const glm::vec3& position) {
 
-        if (_depth == 0 && contains(position)) {
-            for(int i = 0; i < _values.size(); ++i) {
-                if (_values[i] == value) {
-                    _values.erase(_values.begin()+i);
-                    --i;
-                }
+        int node = 0;
+        while (_nodes[node].depth != 0 || !contains(_nodes[node], position)) {
+            if (!contains(_nodes[node], position)) {
+                throwOutOfBounds("remove", position, _nodes[node]);
             }
-            if (_values.empty()) cleanRecursive();
-            return;
+            // Same child as the one chosen by add()
+            int child = _nodes[node].firstChild >= 0 ? childContaining(node, position) : -1;
+            if (child < 0) return;
+            node = child;
         }
 
-        if (contains(position)) {
-            for (auto& octree : _children) {
-                if (octree.contains(position)) {
-                    octree.remove(value, position);
-                }
-            }
-            return;
+        // Values are usually removed in the order they were added: the value is often first in the list
+        Node& leaf = _nodes[node];
+        int previous = -1;
+        int entry = leaf.firstValue;
+        while (entry >= 0 && !(_entries[entry].value == value)) {
+            previous = entry;
+            entry = _entries[entry].next;
+        }
+        if (entry < 0) return;
+
+        int next = _entries[entry].next;
+        if (previous >= 0)
+            _entries[previous].next = next;
+        else
+            leaf.firstValue = next;
+        if (leaf.lastValue == entry)
+            leaf.lastValue = previous;
+        --leaf.valueCount;
+
+        _entries[entry].next = _freeEntry;
+        _freeEntry = entry;
+
+        // The highest voxel left empty gives its children back to the pool
+        int empty = -1;
+        for (int n = node; n >= 0; n = _nodes[n].parent) {
+            if (--_nodes[n].subtreeCount == 0)
+                empty = n;
+        }
+        if (empty >= 0) {
+            releaseChildren(empty);
         }
-
-        std::string error = "Trying to remove object at " + glm::to_string(position);
-        error += " which is out of bounds of octree ( position = " + glm::to_string(_position);
-        error += ", dimension = " + glm::to_string(_dimension) + " )";
-
-        throw std::out_of_range(error);
     }
 
     template <typename T>
-    std::vector<T>& Octree<T>::get(const glm::vec3& position) {
+    typename Octree<T>::ValueRange Octree<T>::get(const glm::vec3& position) {
 
-        if (_depth == 0 && contains(position)) {
-            return _values;
-        }
+        int node = 0;
+        while (true) {
+            const Node& voxel = _nodes[node];
+            if (voxel.depth == 0 && contains(voxel, position)) {
+                return ValueRange(&_entries, voxel.firstValue, voxel.valueCount);
+            }
 
-        if (!_initChildren) {
-            return _values;
-        }
+            if (voxel.firstChild < 0) {
+                return ValueRange(&_entries, voxel.firstValue, voxel.valueCount);
+            }
 
-        if (contains(position)) {
-            for (auto& octree : _children) {
-                if (octree.contains(position)) {
-                    return octree.get(position);
-                }
+            int child = contains(voxel, position) ? childContaining(node, position) : -1;
+            if (child < 0) {
+                throwOutOfBounds("get", position, voxel);
             }
+            node = child;
         }
-
-        std::string error = "Trying to get object at " + glm::to_string(position);
-        error += " which is out of bounds of octree ( position = " + glm::to_string(_position);
-        error += ", dimension = " + glm::to_string(_dimension) + " )";
-
-        throw std::out_of_range(error);
     }
 
     template <typename T>
-    bool Octree<T>::contains(const glm::vec3& position) {
+    bool Octree<T>::contains(const Node& node, const glm::vec3& position) const {
         return !(
-            position.x > _position.x + _dimension.x / 2.f ||
-            position.x < _position.x - _dimension.x / 2.f ||
-            position.y > _position.y + _dimension.y / 2.f ||
-            position.y < _position.y - _dimension.y / 2.f ||
-            position.z > _position.z + _dimension.z / 2.f ||
-            position.z < _position.z - _dimension.z / 2.f
+            position.x > node.position.x + node.dimension.x / 2.f ||
+            position.x < node.position.x - node.dimension.x / 2.f ||
+            position.y > node.position.y + node.dimension.y / 2.f ||
+            position.y < node.position.y - node.dimension.y / 2.f ||
+            position.z > node.position.z + node.dimension.z / 2.f ||
+            position.z < node.position.z - node.dimension.z / 2.f
         );
     }
 
+    template <typename T>
+    bool Octree<T>::contains(const glm::vec3& position) {
+        return contains(_nodes[0], position);
+    }
+
+    template <typename T>
+    void Octree<T>::throwOutOfBounds(const char* action, const glm::vec3& position, const Node& node) const {
+        std::string error = std::string("Trying to ") + action + " object at " + glm::to_string(position);
+        error += " which is out of bounds of octree ( position = " + glm::to_string(node.position);
+        error += ", dimension = " + glm::to_string(node.dimension) + " )";
+
+        throw std::out_of_range(error);
+    }
+
     template <typename T>
     void Octree<T>::printRecursive() {
-        if (_initChildren) {
-            for(auto& child : _children) {
-                child.printRecursive();
+        for (const Node& node : _nodes) {
+            if (node.depth == 0 && node.valueCount > 0) {
+                std::cout << glm::to_string(node.position) << ": " << node.valueCount << " values" << std::endl;
             }
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace PartyKel {
+
+enum HardwareCounter {
+    HARDWARE_CYCLES,
+    HARDWARE_INSTRUCTIONS,
+    HARDWARE_CACHE_MISSES,      // Défauts du dernier niveau de cache (LLC)
+    HARDWARE_BRANCH_MISSES,
+    HARDWARE_COUNTER_COUNT
+};
+
+// Compteurs matériels du thread appelant, lus ensemble (perf_event_open, Linux uniquement).
+// Seule l'activité en espace utilisateur est comptée, ce que permet perf_event_paranoid <= 2.
+// Si les compteurs ne sont pas disponibles (noyau, conteneur, machine virtuelle...),
+// isOpen() renvoie false et getError() en donne la raison
+class PerfCounters {
+public:
+    PerfCounters();
+
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+
+    PerfCounters& operator =(const PerfCounters&) = delete;
+
+    bool isOpen() const {
+        return m_nGroupFd >= 0;
+    }
+
+    const std::string& getError() const {
+        return m_Error;
+    }
+
+    // Valeurs cumulées depuis l'ouverture, corrigées du multiplexage éventuel des compteurs
+    bool read(uint64_t values[HARDWARE_COUNTER_COUNT]) const;
+
+    static const char* getCounterName(HardwareCounter counter);
+
+private:
+    int m_nGroupFd;
+    int m_Fds[HARDWARE_COUNTER_COUNT];
+    std::string m_Error;
+};
+
+}
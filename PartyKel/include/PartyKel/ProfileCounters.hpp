@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace PartyKel {
+
+// Compteurs remis à zéro à chaque frame
+enum ProfileCounter {
+    PROFILE_SPRINGS_EVALUATED,
+    PROFILE_CONTACTS_FOUND,
+    PROFILE_OCTREE_NODES_ALLOCATED,
+    PROFILE_STEP_ALLOCATIONS,   // Allocations sur le tas pendant le pas de simulation (voir AllocationCounter.hpp)
+    PROFILE_COUNTER_COUNT
+};
+
+// Ajoute count au compteur pour la frame en cours (Profiler::addCount), depuis n'importe quel thread.
+// Déclaré ici pour que les en-têtes qui ne font que compter (Octree.hpp) n'incluent pas Profiler.hpp
+void addProfileCount(ProfileCounter counter, uint64_t count);
+
+}
+
+// Comme les autres mesures de Profiler.hpp, les compteurs ne sont compilés qu'avec PARTYKEL_ENABLE_PROFILING:
+// sinon l'argument de PK_COUNT n'est pas évalué
+#ifdef PARTYKEL_ENABLE_PROFILING
+#define PK_COUNT(counter, count) PartyKel::addProfileCount(counter, count)
+#else
+#define PK_COUNT(counter, count) do { (void) sizeof(count); } while (0)
+#endif
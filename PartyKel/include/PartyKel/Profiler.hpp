@@ -0,0 +1,172 @@
+#pragma once
+
+#include "PartyKel/ProfileCounters.hpp"
+#include "PartyKel/Tracer.hpp"
+#include "PartyKel/PerfCounters.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+namespace PartyKel {
+
+// Phases mesurées d'une frame de la simulation et du rendu
+enum ProfilePhase {
+    PROFILE_EXTERNAL_FORCES,
+    PROFILE_INTERNAL_FORCES,
+    PROFILE_SPHERE_COLLISION,
+    PROFILE_OCTREE_BUILD,       // Insertion et suppression des particules dans l'octree
+    PROFILE_REPULSION,
+    PROFILE_CONTACTS,           // Détection des contacts et solveur
+    PROFILE_INTEGRATION,
+    PROFILE_NORMALS,
+    PROFILE_UPLOAD,             // Compression éventuelle et envoi des sommets au GPU
+    PROFILE_GUI,
+    PROFILE_PHASE_COUNT
+};
+
+// Temps par phase et compteurs des PROFILE_HISTORY_SIZE dernières frames.
+// addTime et addCount peuvent être appelés depuis n'importe quel thread (par exemple les Flag simulés
+// en parallèle par sweep): les totaux de la frame en cours sont atomiques. Le reste (endFrame, statistiques,
+// compteurs matériels) est réservé au thread principal; les boucles parallèles sont mesurées autour de
+// l'appel à ThreadPool::parallelFor
+class Profiler {
+public:
+    static const int HISTORY_SIZE = 240;
+
+    // Statistiques glissantes d'une phase, en millisecondes
+    struct Stats {
+        float min, avg, p99;
+    };
+
+    // Compteurs matériels d'une phase sur l'historique (voir enableHardwareCounters)
+    struct HardwareStats {
+        float ipc;                      // Instructions par cycle
+        float cacheMissesPerParticle;   // Défauts de LLC par frame et par particule
+        float branchMissesPerParticle;
+    };
+
+    static Profiler& instance();
+
+    void addTime(ProfilePhase phase, uint64_t nanoseconds) {
+        m_CurrentTimes[phase].fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    void addCount(ProfileCounter counter, uint64_t count) {
+        m_CurrentCounters[counter].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // Enregistre la frame courante dans l'historique (et dans la trace) et commence la suivante
+    void endFrame();
+
+    Stats getStats(ProfilePhase phase) const;
+
+    // Lit aussi les compteurs matériels du thread appelant (le thread principal) autour de chaque phase.
+    // Renvoie false et décrit la raison dans error si perf_event_open n'est pas disponible.
+    // Pour les phases parallèles, seule la part du thread principal est comptée
+    bool enableHardwareCounters(std::string& error);
+
+    // true si les compteurs matériels sont activés et lisibles depuis le thread appelant
+    // (ils ne mesurent que le thread qui les a activés)
+    bool hasHardwareCounters() const {
+        return m_pPerfCounters != nullptr && std::this_thread::get_id() == m_HardwareThread;
+    }
+
+    bool readHardwareCounters(uint64_t values[HARDWARE_COUNTER_COUNT]) const {
+        return m_pPerfCounters->read(values);
+    }
+
+    void addHardwareCounts(ProfilePhase phase, const uint64_t start[HARDWARE_COUNTER_COUNT], const uint64_t end[HARDWARE_COUNTER_COUNT]) {
+        for (int counter = 0; counter < HARDWARE_COUNTER_COUNT; ++counter)
+            m_CurrentHardwareCounts[phase][counter] += end[counter] - start[counter];
+    }
+
+    // Nombre de particules simulées, pour rapporter les défauts par particule
+    void setParticleCount(int count) {
+        m_nParticleCount = count;
+    }
+
+    HardwareStats getHardwareStats(ProfilePhase phase) const;
+
+    // Valeur du compteur à la dernière frame terminée
+    uint64_t getCounter(ProfileCounter counter) const {
+        return m_LastCounters[counter];
+    }
+
+    static const char* getPhaseName(ProfilePhase phase);
+
+    static const char* getCounterName(ProfileCounter counter);
+
+private:
+    Profiler();
+
+    std::atomic<uint64_t> m_CurrentTimes[PROFILE_PHASE_COUNT];
+    std::atomic<uint64_t> m_CurrentCounters[PROFILE_COUNTER_COUNT];
+    uint64_t m_LastCounters[PROFILE_COUNTER_COUNT];
+
+    uint64_t m_History[PROFILE_PHASE_COUNT][HISTORY_SIZE];
+    int m_nHistoryCount;
+    int m_nHistoryIndex;
+
+    std::unique_ptr<PerfCounters> m_pPerfCounters;
+    std::thread::id m_HardwareThread;
+    uint64_t m_CurrentHardwareCounts[PROFILE_PHASE_COUNT][HARDWARE_COUNTER_COUNT];
+    uint64_t m_HardwareHistory[PROFILE_PHASE_COUNT][HARDWARE_COUNTER_COUNT][HISTORY_SIZE];
+    int m_nParticleCount;
+
+    std::chrono::steady_clock::time_point m_FrameStart;
+};
+
+// Ajoute le temps passé dans sa portée à une phase (et les compteurs matériels s'ils sont activés),
+// et l'enregistre dans la trace si elle est active
+class ScopedTimer {
+public:
+    explicit ScopedTimer(ProfilePhase phase):
+        m_Phase(phase) {
+        Profiler& profiler = Profiler::instance();
+        m_bHardwareCounters = profiler.hasHardwareCounters() && profiler.readHardwareCounters(m_StartCounts);
+        m_Start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer() {
+        auto end = std::chrono::steady_clock::now();
+        Profiler& profiler = Profiler::instance();
+        profiler.addTime(m_Phase, std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_Start).count());
+
+        uint64_t endCounts[HARDWARE_COUNTER_COUNT];
+        if (m_bHardwareCounters && profiler.readHardwareCounters(endCounts))
+            profiler.addHardwareCounts(m_Phase, m_StartCounts, endCounts);
+
+        Tracer& tracer = Tracer::instance();
+        if (tracer.isRecording())
+            tracer.record(Profiler::getPhaseName(m_Phase), "phase", m_Start, end);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+
+    ScopedTimer& operator =(const ScopedTimer&) = delete;
+
+private:
+    ProfilePhase m_Phase;
+    std::chrono::steady_clock::time_point m_Start;
+    bool m_bHardwareCounters;
+    uint64_t m_StartCounts[HARDWARE_COUNTER_COUNT];
+};
+
+}
+
+// Les mesures ne sont compilées que si PARTYKEL_ENABLE_PROFILING est défini (option CMake du même nom):
+// sinon les macros ne génèrent aucun code. PK_COUNT est défini dans ProfileCounters.hpp
+#define PK_CONCAT_IMPL(a, b) a##b
+#define PK_CONCAT(a, b) PK_CONCAT_IMPL(a, b)
+
+#ifdef PARTYKEL_ENABLE_PROFILING
+#define PK_SCOPED_TIMER(phase) PartyKel::ScopedTimer PK_CONCAT(pkScopedTimer, __LINE__)(phase)
+#define PK_END_FRAME() PartyKel::Profiler::instance().endFrame()
+#else
+#define PK_SCOPED_TIMER(phase) do {} while (0)
+#define PK_END_FRAME() do {} while (0)
+#endif
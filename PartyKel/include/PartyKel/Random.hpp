@@ -0,0 +1,93 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <cstdint>
+#include <cmath>
+
+namespace PartyKel {
+
+// Générateur Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", 2011).
+// Sans état: chaque bloc de 4 entiers aléatoires est une fonction de (compteur, clé). Le même tirage
+// peut donc être refait à l'identique pour n'importe quelle frame, dans n'importe quel ordre et sur n'importe quel thread.
+struct Philox4x32 {
+    static void generate(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4]) {
+        static const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+        static const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0 = uint64_t(M0) * c0;
+            uint64_t p1 = uint64_t(M1) * c2;
+            uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+            c0 = n0;
+            c1 = uint32_t(p1);
+            c2 = n2;
+            c3 = uint32_t(p0);
+            k0 += W0;
+            k1 += W1;
+        }
+        result[0] = c0;
+        result[1] = c1;
+        result[2] = c2;
+        result[3] = c3;
+    }
+};
+
+// Suite de nombres aléatoires identifiée par (graine, flux, frame). Deux flux différents (un par
+// source de hasard, ou un par bloc de travail d'un thread) sont indépendants pour une même graine et une même frame.
+class RandomStream {
+public:
+    RandomStream(uint64_t seed, uint32_t stream, uint64_t frame):
+        m_nBlock(0), m_nAvailable(0) {
+        m_Key[0] = uint32_t(seed);
+        m_Key[1] = uint32_t(seed >> 32);
+        m_Counter[1] = stream;
+        m_Counter[2] = uint32_t(frame);
+        m_Counter[3] = uint32_t(frame >> 32);
+    }
+
+    uint32_t nextUint() {
+        if (!m_nAvailable) {
+            m_Counter[0] = m_nBlock++;
+            Philox4x32::generate(m_Counter, m_Key, m_Values);
+            m_nAvailable = 4;
+        }
+        return m_Values[4 - m_nAvailable--];
+    }
+
+    // Réel uniforme dans [0, 1)
+    float nextFloat() {
+        return (nextUint() >> 8) * (1.f / 16777216.f);
+    }
+
+    // Réel uniforme dans [min, max)
+    float nextFloat(float min, float max) {
+        return min + (max - min) * nextFloat();
+    }
+
+    // Vecteur de norme radius, de direction uniformément répartie sur la sphère
+    glm::vec3 sphericalRand(float radius) {
+        float z = nextFloat(-1.f, 1.f);
+        float a = nextFloat(-1.f, 1.f) * 3.14159265f;
+        float r = std::sqrt(1.f - z * z);
+        return glm::vec3(r * std::cos(a), r * std::sin(a), z) * radius;
+    }
+
+private:
+    uint32_t m_Key[2];
+    uint32_t m_Counter[4];
+    uint32_t m_Values[4];
+    uint32_t m_nBlock;
+    int m_nAvailable;
+};
+
+// Flux réservés des sources de hasard de la simulation
+enum RandomStreamId : uint32_t {
+    RANDOM_STREAM_WIND = 0,
+    RANDOM_STREAM_SWEEP = 1,    // Tirage des configurations de sweep (la frame est l'indice de la configuration)
+    RANDOM_STREAM_WORKERS = 1024 // Premier flux des blocs de travail parallèles (RANDOM_STREAM_WORKERS + indice du bloc)
+};
+
+}
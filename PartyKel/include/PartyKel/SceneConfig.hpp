@@ -0,0 +1,76 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <string>
+#include <vector>
+
+namespace PartyKel {
+
+// Paramètres d'une scène de simulation, lus dans un fichier texte de la forme:
+//
+//   # commentaire
+//   grid = 70 30
+//   K0 = 1.0
+//   gravity = 0 -0.05 0
+//   sphere = 0 -3 2  2.0  1 0 0     # position, rayon, couleur (optionnelle)
+//
+// Une clé par ligne, les vecteurs sont des nombres séparés par des espaces. Chaque ligne "sphere" ajoute
+// une sphère; la première remplace les sphères par défaut, "spheres = none" les supprime toutes.
+// Les clés inconnues et les valeurs invalides lèvent une std::runtime_error indiquant le fichier et la ligne.
+struct SceneConfig {
+    // Drapeau
+    glm::ivec2 grid = glm::ivec2(70, 30);   // Nombre de particules
+    glm::vec2 size = glm::vec2(8, 3);       // Taille en 3D
+    float mass = 1.f;
+    float K0 = 1.f, K1 = 1.f, K2 = 1.f;     // Paramètres de résistance
+    float V0 = 0.08f, V1 = 0.02f, V2 = 0.06f; // Paramètres de frein
+
+    // Forces externes
+    glm::vec3 gravity = glm::vec3(0.f, -0.05f, 0.f);
+    float windVelocity = 0.025f;
+
+    // Obstacles
+    std::vector<glm::vec3> spherePositions = { glm::vec3(0, -3, 2), glm::vec3(1.5, -3.5, 0.7), glm::vec3(3, -2, -1.5) };
+    std::vector<float> sphereRadius = { 2.f, 1.5f, 0.8f };
+    std::vector<glm::vec3> sphereColors = { glm::vec3(1, 0, 0), glm::vec3(1, 1, 0), glm::vec3(0, 1, 0) };
+    float sphereCollisionMultiplier = 1.5f;
+    float radiusDelta = 0.15f;
+
+    // Structure spatiale (octree) utilisée pour les auto-collisions
+    int octreeDepth = 7;
+    glm::vec3 octreeCenter = glm::vec3(0.f, -10.f, 0.f);
+    glm::vec3 octreeSize = glm::vec3(50.f);
+
+    // Collisions et solveur
+    float maxDstRepulseForce = 0.17f;
+    float multRepulseForce = 0.1f;
+    bool activeSpheres = true;
+    bool activeAutoCollisions = true;
+    bool activeContactSolver = true;
+    int contactIterations = 20;
+
+    // Mise en sommeil des zones immobiles (voir Flag::sleepThreshold), désactivée à 0
+    float sleepThreshold = 0.f;
+    int sleepFrames = 30;
+    float wakeForceDelta = 0.01f;
+
+    // Graine des tirages aléatoires (vent): deux exécutions de même graine sont identiques
+    int seed = 0;
+
+    // Lit un fichier de scène; les clés absentes gardent leur valeur courante
+    void loadFile(const std::string& path);
+
+    // Lit une scène depuis un texte; source désigne son origine dans les messages d'erreur
+    void parse(const char* begin, const char* end, const std::string& source);
+
+    // Applique une affectation "clé=valeur" (option --set de la ligne de commande)
+    void set(const std::string& assignment);
+
+    // Applique une valeur à une clé
+    void set(const std::string& key, const std::string& value);
+
+private:
+    bool m_bDefaultSpheres = true; // Les sphères n'ont pas encore été redéfinies
+};
+
+}
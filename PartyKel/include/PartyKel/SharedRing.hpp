@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace PartyKel {
+
+// Segment de mémoire partagée POSIX (shm_open + mmap), visible par tous les processus qui l'ouvrent par son nom.
+// Le processus qui l'a créé supprime le nom à la destruction; les projections existantes restent valides
+class SharedMemory {
+public:
+    // Crée le segment (erreur s'il existe déjà) et le remplit de zéros
+    SharedMemory(const std::string& name, size_t size);
+
+    // Ouvre un segment existant, de la taille donnée à sa création
+    explicit SharedMemory(const std::string& name);
+
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+
+    SharedMemory& operator =(const SharedMemory&) = delete;
+
+    void* getData() const {
+        return m_pData;
+    }
+
+    size_t getSize() const {
+        return m_nSize;
+    }
+
+    const std::string& getName() const {
+        return m_Name;
+    }
+
+private:
+    void map(int fd, const char* action);
+
+    std::string m_Name;
+    void* m_pData;
+    size_t m_nSize;
+    bool m_bOwner;
+};
+
+// File circulaire d'emplacements de taille fixe entre un producteur et un consommateur de deux processus.
+// Les compteurs d'écriture et de lecture sont des atomiques du segment: le producteur attend qu'un emplacement
+// soit libre, le consommateur qu'un emplacement soit publié (attente active, les échanges étant très courts)
+class SharedRing {
+public:
+    // Crée la file et son segment
+    SharedRing(const std::string& name, size_t slotSize, unsigned int slotCount);
+
+    // Ouvre une file créée par un autre processus
+    explicit SharedRing(const std::string& name);
+
+    size_t getSlotSize() const {
+        return m_pHeader->slotSize;
+    }
+
+    // Emplacement à remplir puis à publier par endWrite()
+    void* beginWrite();
+
+    void endWrite();
+
+    // Plus ancien emplacement publié, à rendre au producteur par endRead()
+    const void* beginRead();
+
+    void endRead();
+
+private:
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "SharedRing needs lock-free 64 bits atomics to work between processes");
+
+    // Les deux compteurs sont sur des lignes de cache distinctes: chacun n'est modifié que par un processus
+    struct Header {
+        alignas(64) std::atomic<uint64_t> written;
+        alignas(64) std::atomic<uint64_t> read;
+        uint64_t slotSize, slotCount;
+    };
+
+    char* getSlot(uint64_t index) const {
+        return m_pSlots + (index % m_pHeader->slotCount) * m_pHeader->slotSize;
+    }
+
+    SharedMemory m_Memory;
+    Header* m_pHeader;
+    char* m_pSlots;
+};
+
+}
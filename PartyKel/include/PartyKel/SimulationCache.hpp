@@ -0,0 +1,167 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+
+namespace PartyKel {
+
+// Fichier de cache d'une simulation: les positions des particules de chaque frame, écrites à la suite.
+//   en-tête (SimulationCacheHeader), frames, table d'index (SimulationCacheFrame par frame), SimulationCacheFooter.
+// Les frames sont stockées en float, ou quantifiées (pas quantizationStep) et codées en différence avec la
+// frame précédente: entiers zigzag de longueur variable, avec une frame clé complète toutes les keyframeInterval frames.
+// Si le fichier contient les normales (SIMULATION_CACHE_NORMALS), elles suivent les positions de chaque frame,
+// en encodage octaédrique sur 2 x int16 (4 octets par particule), sans codage en différence.
+
+static const uint32_t SIMULATION_CACHE_VERSION = 2;
+
+static const uint32_t SIMULATION_CACHE_NORMALS = 1;
+
+enum class SimulationCacheEncoding : uint32_t {
+    Raw = 0,            // 12 octets par particule, accès direct
+    QuantizedDelta = 1  // Différences quantifiées, décodées depuis la frame clé précédente
+};
+
+struct SimulationCacheHeader {
+    char magic[4];              // "PKSC"
+    uint32_t version;
+    uint32_t encoding;          // SimulationCacheEncoding
+    uint32_t particleCount;
+    float quantizationStep;
+    uint32_t keyframeInterval;
+    uint32_t flags;             // SIMULATION_CACHE_NORMALS (version 2)
+    uint32_t gridWidth;         // Largeur de la grille des particules si les normales sont stockées
+};
+
+struct SimulationCacheFrame {
+    uint64_t offset;    // Depuis le début du fichier
+    uint32_t size;      // En octets
+    uint32_t keyframe;  // 1 si la frame est décodable seule
+};
+
+struct SimulationCacheFooter {
+    uint64_t tableOffset;
+    uint32_t frameCount;
+    char magic[4];      // "PKSC"
+};
+
+// Enregistre les frames d'une simulation. L'encodage et l'écriture sont faits par un thread d'E/S:
+// append() ne fait qu'une copie des positions, et ne bloque que si le thread a trop de retard.
+// Si normalGridWidth > 0, les particules forment une grille de cette largeur: le thread d'E/S
+// calcule ses normales (voir GridMesh.hpp) et les stocke avec chaque frame.
+class SimulationCacheWriter {
+public:
+    SimulationCacheWriter(const std::string& path, uint32_t particleCount,
+                          SimulationCacheEncoding encoding = SimulationCacheEncoding::Raw,
+                          float quantizationStep = 0.0001f, uint32_t keyframeInterval = 30,
+                          uint32_t normalGridWidth = 0);
+
+    ~SimulationCacheWriter();
+
+    SimulationCacheWriter(const SimulationCacheWriter&) = delete;
+
+    SimulationCacheWriter& operator =(const SimulationCacheWriter&) = delete;
+
+    // Ajoute une frame de particleCount positions
+    void append(const glm::vec3* positionArray);
+
+    // Écrit les frames restantes puis la table d'index; lève une std::runtime_error si une écriture a échoué
+    void close();
+
+    uint32_t getFrameCount() const {
+        return m_nAppendedCount;
+    }
+
+private:
+    void ioLoop();
+    void writeFrame(const std::vector<glm::vec3>& positions);
+
+    std::string m_Path;
+    FILE* m_pFile;
+    SimulationCacheHeader m_Header;
+    uint32_t m_nAppendedCount;
+
+    // Accédés uniquement par le thread d'E/S
+    uint64_t m_nOffset;
+    std::vector<SimulationCacheFrame> m_Frames;
+    std::vector<int32_t> m_PreviousQuantized, m_Quantized;
+    std::vector<uint8_t> m_Encoded;
+    std::vector<glm::vec3> m_FaceNormals, m_Normals;
+    bool m_bFailed;
+
+    // Frames en attente d'écriture et tampons libres (réutilisés pour éviter les allocations)
+    std::deque<std::vector<glm::vec3>> m_PendingFrames;
+    std::vector<std::vector<glm::vec3>> m_FreeBuffers;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_bStop;
+    std::thread m_IOThread;
+};
+
+// Lit un cache projeté en mémoire (mmap): seule la frame demandée est lue depuis le disque.
+// Les frames brutes sont en accès direct; les frames codées en différence sont décodées depuis la frame
+// clé précédente (au plus keyframeInterval frames), ou depuis la dernière frame lue en lecture séquentielle.
+class SimulationCacheReader {
+public:
+    explicit SimulationCacheReader(const std::string& path);
+
+    ~SimulationCacheReader();
+
+    SimulationCacheReader(const SimulationCacheReader&) = delete;
+
+    SimulationCacheReader& operator =(const SimulationCacheReader&) = delete;
+
+    uint32_t getFrameCount() const {
+        return m_nFrameCount;
+    }
+
+    uint32_t getParticleCount() const {
+        return m_Header.particleCount;
+    }
+
+    SimulationCacheEncoding getEncoding() const {
+        return SimulationCacheEncoding(m_Header.encoding);
+    }
+
+    bool hasNormals() const {
+        return m_Header.flags & SIMULATION_CACHE_NORMALS;
+    }
+
+    // Largeur de la grille des particules, 0 si elle n'est pas connue
+    uint32_t getGridWidth() const {
+        return hasNormals() ? m_Header.gridWidth : 0;
+    }
+
+    // Positions de la frame index, sans copie; nullptr si la frame n'est pas stockée en float
+    const glm::vec3* rawFrame(uint32_t index) const;
+
+    // Écrit les particleCount positions de la frame index dans positionArray.
+    // Lève une std::out_of_range si index >= getFrameCount()
+    void readFrame(uint32_t index, glm::vec3* positionArray);
+
+    // Écrit les normales de la frame index dans normalArray (accès direct).
+    // Lève une std::out_of_range si index >= getFrameCount(), une std::runtime_error si le fichier n'a pas de normales
+    void readNormals(uint32_t index, glm::vec3* normalArray) const;
+
+private:
+    // Applique la frame index (clé ou différence) aux positions quantifiées m_Quantized
+    void decodeFrame(uint32_t index);
+
+    const uint8_t* m_pData;
+    size_t m_nSize;
+    SimulationCacheHeader m_Header;
+    const SimulationCacheFrame* m_pFrames;
+    uint32_t m_nFrameCount;
+    size_t m_nNormalSize; // Octets de normales à la fin de chaque frame
+
+    std::vector<int32_t> m_Quantized;
+    int64_t m_nDecodedFrame; // Frame contenue dans m_Quantized, -1 si aucune
+};
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "PartyKel/SimulationCache.hpp"
+
+namespace PartyKel {
+
+// Relecture d'un cache de simulation pour l'affichage. Le temps de lecture est exprimé en frames
+// et peut être fractionnaire: les positions (et normales) sont alors interpolées entre les deux frames
+// enregistrées qui l'encadrent, pour le ralenti. Les deux dernières frames lues restent en mémoire.
+class SimulationPlayback {
+public:
+    explicit SimulationPlayback(const std::string& path);
+
+    uint32_t getFrameCount() const {
+        return m_Reader.getFrameCount();
+    }
+
+    uint32_t getParticleCount() const {
+        return m_Reader.getParticleCount();
+    }
+
+    uint32_t getGridWidth() const {
+        return m_Reader.getGridWidth();
+    }
+
+    bool hasNormals() const {
+        return m_Reader.hasNormals();
+    }
+
+    // Place la lecture au temps time (borné à [0, getFrameCount() - 1])
+    void seek(float time);
+
+    const glm::vec3* getPositions() const {
+        return m_pPositions;
+    }
+
+    // nullptr si le cache ne contient pas de normales
+    const glm::vec3* getNormals() const {
+        return m_pNormals;
+    }
+
+private:
+    // Emplacement (0 ou 1) contenant la frame index, chargée si nécessaire à la place de l'emplacement other
+    int loadFrame(uint32_t index, int other);
+
+    SimulationCacheReader m_Reader;
+
+    int64_t m_FrameIndex[2]; // Frame chargée dans chaque emplacement, -1 si aucune
+    std::vector<glm::vec3> m_Positions[2], m_Normals[2];
+    std::vector<glm::vec3> m_InterpolatedPositions, m_InterpolatedNormals;
+
+    const glm::vec3* m_pPositions;
+    const glm::vec3* m_pNormals;
+};
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <vector>
+#include <cstdint>
+
+namespace PartyKel {
+
+class ThreadPool;
+
+// Grille uniforme adressée par hachage, pour la recherche des points à moins d'une distance radius:
+// les indices des points sont rangés par case de la table (tri par dénombrement), dans l'ordre croissant.
+// Les cellules mesurent 2 * radius, de sorte que les voisins d'un point sont dans le bloc de 2 x 2 x 2
+// cellules du côté où il se trouve (8 cases de la table consultées au lieu de 27).
+// Reconstruite à chaque pas; une fois les tableaux dimensionnés, build() n'alloue plus.
+class SpatialHash {
+public:
+    SpatialHash():
+        m_fCellSize(1.f), m_nBucketMask(0) {
+    }
+
+    // Range les count positions. Le calcul des cellules est réparti sur le pool s'il est fourni
+    void build(const glm::vec3* positions, int count, float radius, ThreadPool* pool = nullptr);
+
+    float getRadius() const {
+        return 0.5f * m_fCellSize;
+    }
+
+    float getCellSize() const {
+        return m_fCellSize;
+    }
+
+    glm::ivec3 cellOf(const glm::vec3& position) const {
+        return glm::ivec3(glm::floor(position / m_fCellSize));
+    }
+
+    // Appelle f(index) pour chaque point de la cellule. Les points des autres cellules
+    // rangés dans la même case de la table sont écartés
+    template<typename F>
+    void forEachInCell(const glm::ivec3& cell, F f) const {
+        uint32_t bucket = hash(cell);
+        for (int e = m_BucketStart[bucket]; e < m_BucketStart[bucket + 1]; ++e) {
+            int index = m_Entries[e];
+            if (m_Cells[index] == cell)
+                f(index);
+        }
+    }
+
+    // Appelle f(index) pour chaque point du bloc de 2 x 2 x 2 cellules le plus proche de position,
+    // dont tous les points à moins de getRadius(). Les autres doivent être écartés par l'appelant
+    template<typename F>
+    void forEachNear(const glm::vec3& position, F f) const {
+        glm::vec3 scaled = position / m_fCellSize;
+        glm::vec3 cell = glm::floor(scaled);
+        glm::ivec3 first(cell);
+        for (int axis = 0; axis < 3; ++axis) {
+            if (scaled[axis] - cell[axis] < 0.5f)
+                --first[axis];
+        }
+        for (int z = 0; z < 2; ++z)
+            for (int y = 0; y < 2; ++y)
+                for (int x = 0; x < 2; ++x)
+                    forEachInCell(first + glm::ivec3(x, y, z), f);
+    }
+
+private:
+    uint32_t hash(const glm::ivec3& cell) const {
+        return (uint32_t(cell.x) * 73856093u ^ uint32_t(cell.y) * 19349663u ^ uint32_t(cell.z) * 83492791u) & m_nBucketMask;
+    }
+
+    float m_fCellSize;
+    uint32_t m_nBucketMask;
+    std::vector<glm::ivec3> m_Cells;    // Cellule de chaque point
+    std::vector<uint32_t> m_Buckets;    // Case de la table de chaque point
+    std::vector<int> m_BucketStart;     // Début des points de chaque case dans m_Entries (une case de plus pour la fin)
+    std::vector<int> m_Entries;         // Indices des points, rangés par case
+};
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "PartyKel/FrameArena.hpp"
+
+namespace PartyKel {
+
+// Ensemble de threads persistants exécutant des boucles parallèles.
+// Le thread appelant participe au travail: un pool de N threads crée N - 1 workers.
+// Chaque thread dispose d'une arène pour ses données temporaires, vidée par resetFrameArenas().
+class ThreadPool {
+public:
+    // Avec pinThreads, le thread i est fixé sur le i-ème coeur autorisé (Linux uniquement),
+    // y compris le thread appelant qui reste fixé sur le premier coeur après la destruction du pool
+    explicit ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency(), bool pinThreads = false);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator =(const ThreadPool&) = delete;
+
+    // Découpe [begin, end) en blocs d'au moins grain éléments et appelle task(blockBegin, blockEnd)
+    // sur chacun d'eux. Bloquant: rend la main lorsque tous les blocs ont été traités.
+    // La tâche est passée par référence, sans copie ni allocation
+    template<typename F>
+    void parallelFor(int begin, int end, int grain, const F& task) {
+        run(begin, end, grain, TaskRef{ &task, &invoke<F> });
+    }
+
+    unsigned int getThreadCount() const {
+        return m_Workers.size() + 1;
+    }
+
+    // Indice du thread courant dans le pool: 0 pour le thread appelant, 1 à N - 1 pour les workers
+    static unsigned int getCurrentThreadIndex();
+
+    // Arène du thread courant, à utiliser depuis une tâche de parallelFor (ou depuis le thread appelant)
+    FrameArena& getFrameArena() {
+        return *m_FrameArenas[getCurrentThreadIndex()];
+    }
+
+    FrameArena& getFrameArena(unsigned int threadIndex) {
+        return *m_FrameArenas[threadIndex];
+    }
+
+    // Une liste par thread, chacune dans l'arène de son thread: une tâche ajoute ses résultats
+    // à la liste [getCurrentThreadIndex()] sans synchronisation
+    template<typename T>
+    ArenaList<T>* allocateThreadLists() {
+        unsigned int threadCount = getThreadCount();
+        ArenaList<T>* lists = getFrameArena().allocateArray<ArenaList<T>>(threadCount);
+        for (unsigned int t = 0; t < threadCount; ++t)
+            new (&lists[t]) ArenaList<T>(getFrameArena(t));
+        return lists;
+    }
+
+    // Libère les données temporaires de tous les threads, une fois par pas de simulation.
+    // Aucune tâche ne doit être en cours
+    void resetFrameArenas();
+
+private:
+    // Référence non propriétaire vers une tâche
+    struct TaskRef {
+        const void* task;
+        void (*call)(const void* task, int begin, int end);
+    };
+
+    template<typename F>
+    static void invoke(const void* task, int begin, int end) {
+        (*static_cast<const F*>(task))(begin, end);
+    }
+
+    void run(int begin, int end, int grain, TaskRef task);
+
+    // index: numéro du worker (1 à N - 1), nomme le thread dans la trace
+    void workerLoop(unsigned int index);
+
+    // Traite des blocs de la tâche courante jusqu'à épuisement
+    void runChunks(TaskRef task, int begin, int end, int chunkSize, int chunkCount);
+
+    std::vector<std::thread> m_Workers;
+    std::vector<std::unique_ptr<FrameArena>> m_FrameArenas;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_WakeCondition, m_DoneCondition;
+
+    // Tâche courante (protégée par m_Mutex, sauf m_nNextChunk)
+    TaskRef m_Task;
+    int m_nBegin, m_nEnd, m_nChunkSize, m_nChunkCount;
+    std::atomic<int> m_nNextChunk;
+    int m_nPendingChunks;
+    int m_nActiveWorkers;
+    uint64_t m_nGeneration;
+    bool m_bStop;
+};
+
+}
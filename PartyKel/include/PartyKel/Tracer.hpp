@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace PartyKel {
+
+// Événement d'une trace: intervalle de temps nommé sur un thread
+struct TraceEvent {
+    const char* name;       // Chaîne statique (nom de phase...)
+    const char* category;
+    uint64_t start;         // ns depuis la création du Tracer
+    uint64_t duration;      // ns
+    int32_t begin, end;     // Intervalle traité par une tâche du ThreadPool (-1 sinon)
+};
+
+// Chronologie des phases de chaque frame et des tâches des workers, exportée au format
+// Chrome trace-event (JSON lisible par chrome://tracing et ui.perfetto.dev).
+// Chaque thread écrit dans son propre tampon sans verrou (un seul écrivain par tampon); le verrou
+// n'est pris qu'au premier événement d'un thread pour enregistrer son tampon.
+// start() et writeJSON() doivent être appelés entre deux frames, lorsqu'aucune boucle parallèle ne tourne.
+class Tracer {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Événements conservés par thread; les suivants sont comptés comme perdus
+    static const size_t EVENTS_PER_THREAD = 1 << 18;
+
+    static Tracer& instance();
+
+    // Vide les tampons et commence l'enregistrement
+    void start();
+
+    void stop() {
+        m_bRecording.store(false, std::memory_order_relaxed);
+    }
+
+    bool isRecording() const {
+        return m_bRecording.load(std::memory_order_relaxed);
+    }
+
+    void record(const char* name, const char* category, Clock::time_point startTime, Clock::time_point endTime,
+                int32_t begin = -1, int32_t end = -1);
+
+    // Nom du thread appelant dans la trace (par défaut "Thread <n>")
+    void setThreadName(const std::string& name);
+
+    // Écrit les événements enregistrés depuis start(); lance std::runtime_error en cas d'échec
+    void writeJSON(const std::string& path) const;
+
+    uint64_t getDroppedCount() const;
+
+private:
+    struct ThreadBuffer {
+        std::string name;
+        uint32_t id;
+        std::unique_ptr<TraceEvent[]> events;   // Alloué au premier événement
+        std::atomic<size_t> count;
+        std::atomic<uint64_t> dropped;
+    };
+
+    Tracer();
+
+    ThreadBuffer* getThreadBuffer();
+
+    // Tampon du thread courant, enregistré au premier appel de getThreadBuffer
+    static thread_local ThreadBuffer* t_pBuffer;
+
+    Clock::time_point m_Epoch;
+    std::atomic<bool> m_bRecording;
+
+    mutable std::mutex m_Mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_Buffers;
+};
+
+// Enregistre une tâche exécutée par un thread du ThreadPool
+class TraceTaskScope {
+public:
+    TraceTaskScope(int32_t begin, int32_t end):
+        m_nBegin(begin), m_nEnd(end), m_bRecording(Tracer::instance().isRecording()) {
+        if (m_bRecording)
+            m_Start = Tracer::Clock::now();
+    }
+
+    ~TraceTaskScope() {
+        if (m_bRecording)
+            Tracer::instance().record("Task", "task", m_Start, Tracer::Clock::now(), m_nBegin, m_nEnd);
+    }
+
+    TraceTaskScope(const TraceTaskScope&) = delete;
+
+    TraceTaskScope& operator =(const TraceTaskScope&) = delete;
+
+private:
+    int32_t m_nBegin, m_nEnd;
+    bool m_bRecording;
+    Tracer::Clock::time_point m_Start;
+};
+
+}
+
+// Comme les timers de Profiler.hpp, la trace n'est compilée qu'avec PARTYKEL_ENABLE_PROFILING
+#ifdef PARTYKEL_ENABLE_PROFILING
+#define PK_TRACE_TASK(begin, end) PartyKel::TraceTaskScope pkTraceTask(begin, end)
+#else
+#define PK_TRACE_TASK(begin, end) do {} while (0)
+#endif
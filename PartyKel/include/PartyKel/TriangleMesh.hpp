@@ -0,0 +1,56 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace PartyKel {
+
+class ThreadPool;
+
+// Maillage triangulaire indexé (3 indices par triangle)
+struct TriangleMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+
+    uint32_t getVertexCount() const {
+        return positions.size();
+    }
+
+    uint32_t getTriangleCount() const {
+        return indices.size() / 3;
+    }
+};
+
+// Lit les sommets (v) et les faces (f) d'un fichier OBJ; les polygones sont découpés en éventails de triangles.
+// Les coordonnées de texture et les normales des faces (f v/vt/vn) sont ignorées: deux coins de faces
+// qui référencent le même sommet v sont reliés dans la simulation, même le long d'une couture UV.
+// Lève une std::runtime_error indiquant le fichier et la ligne si le fichier est invalide
+TriangleMesh loadOBJ(const std::string& path);
+
+// Triangles adjacents à chaque sommet, au format compressé: les triangles du sommet v
+// sont triangles[offsets[v]] ... triangles[offsets[v + 1] - 1]
+struct VertexTriangles {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+};
+
+void buildVertexTriangles(const std::vector<uint32_t>& indexArray, uint32_t vertexCount, VertexTriangles& adjacency);
+
+// Calcul des normales d'un maillage quelconque, en deux passes comme pour une grille (voir GridMesh.hpp)
+
+// Première passe: normales unitaires des triangles [triangleBegin, triangleEnd)
+void computeMeshFaceNormals(const glm::vec3* positionArray, const uint32_t* indexArray,
+                            glm::vec3* faceNormalArray, int triangleBegin, int triangleEnd);
+
+// Seconde passe: normale de chaque sommet de [vertexBegin, vertexEnd), moyenne des normales des triangles adjacents
+void gatherMeshVertexNormals(const glm::vec3* faceNormalArray, const VertexTriangles& adjacency,
+                             glm::vec3* normalArray, int vertexBegin, int vertexEnd);
+
+// Enchaîne les deux passes sur tout le maillage, en parallèle si un pool est fourni
+void computeMeshNormals(const glm::vec3* positionArray, const std::vector<uint32_t>& indexArray,
+                        const VertexTriangles& adjacency, glm::vec3* faceNormalArray, glm::vec3* normalArray,
+                        ThreadPool* pool = nullptr);
+
+}
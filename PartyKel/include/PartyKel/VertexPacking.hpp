@@ -0,0 +1,52 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include <cstdint>
+#include <cmath>
+
+namespace PartyKel {
+
+// Fonctions de compression des attributs de sommets, indépendantes d'OpenGL
+
+// Quantifie value dans [0, 1] sur 16 bits
+inline uint16_t packUnorm16(float value) {
+    return uint16_t(glm::clamp(value, 0.f, 1.f) * 65535.f + 0.5f);
+}
+
+inline float unpackUnorm16(uint16_t value) {
+    return value / 65535.f;
+}
+
+// Quantifie value dans [-1, 1] sur 16 bits signés
+inline int16_t packSnorm16(float value) {
+    return int16_t(std::lround(glm::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+inline float unpackSnorm16(int16_t value) {
+    return glm::max(value / 32767.f, -1.f);
+}
+
+// Encodage octaédrique d'une direction unitaire sur deux composantes dans [-1, 1]
+inline glm::vec2 encodeOctahedral(const glm::vec3& n) {
+    float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 == 0.f)
+        return glm::vec2(0.f);
+
+    glm::vec2 e(n.x / l1, n.y / l1);
+    if (n.z < 0.f) {
+        e = glm::vec2((1.f - std::abs(e.y)) * (e.x >= 0.f ? 1.f : -1.f),
+                      (1.f - std::abs(e.x)) * (e.y >= 0.f ? 1.f : -1.f));
+    }
+    return e;
+}
+
+inline glm::vec3 decodeOctahedral(const glm::vec2& e) {
+    glm::vec3 n(e.x, e.y, 1.f - std::abs(e.x) - std::abs(e.y));
+    if (n.z < 0.f) {
+        n.x = (1.f - std::abs(e.y)) * (e.x >= 0.f ? 1.f : -1.f);
+        n.y = (1.f - std::abs(e.x)) * (e.y >= 0.f ? 1.f : -1.f);
+    }
+    return glm::normalize(n);
+}
+
+}
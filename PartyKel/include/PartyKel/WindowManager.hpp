@@ -1,13 +1,20 @@
 #pragma once
 
 #include <SDL/SDL.h>
+#include <memory>
+#include <string>
 
 namespace PartyKel {
 
+class HeadlessRenderer;
+
 class WindowManager {
 public:
     WindowManager(uint32_t w, uint32_t h, const char* title);
 
+    // Rendu hors écran, sans fenêtre ni SDL: chaque frame est écrite dans outputDirectory (voir HeadlessRenderer)
+    WindowManager(uint32_t w, uint32_t h, const std::string& outputDirectory);
+
     ~WindowManager();
 
     WindowManager(const WindowManager&) = delete;
@@ -15,15 +22,21 @@ public:
     WindowManager& operator =(const WindowManager&) = delete;
 
     bool pollEvent(SDL_Event& e) const {
-        return SDL_PollEvent(&e);
+        return !m_pHeadless && SDL_PollEvent(&e);
+    }
+
+    bool isHeadless() const {
+        return m_pHeadless != nullptr;
     }
 
     // A appeler en début de boucle de rendu
     void startMainLoop() {
-        m_nStartTime = SDL_GetTicks();
+        if (!m_pHeadless)
+            m_nStartTime = SDL_GetTicks();
     }
 
     // Met à jour la fenetre et renvoit le temps écoulé depuis le dernier appel à startMainLoop (en secondes)
+    // Sans fenêtre, renvoit la durée d'une frame pour que la simulation soit indépendante du temps de rendu
     float update();
 
     void setFramerate(uint32_t fps) {
@@ -35,6 +48,8 @@ private:
     uint32_t m_nFrameDuration;
 
     uint32_t m_nStartTime;
+
+    std::unique_ptr<HeadlessRenderer> m_pHeadless;
 };
 
 }
@@ -3,16 +3,33 @@
 #include "PartyKel/glm.hpp"
 #include <GL/glew.h>
 #include <vector>
+#include <cstdint>
 
 namespace PartyKel {
 
+class ThreadPool;
+
 class FlagRenderer3D {
-	struct Vertex {
-		glm::vec3 position;
-		glm::vec3 normal;
-	};
 public:
-    FlagRenderer3D(int gridWidth, int gridHeight);
+    // Méthode d'envoi des sommets au GPU
+    enum class UploadMode {
+        Auto,               // PersistentMapped si ARB_buffer_storage est disponible, Orphaning sinon
+        PersistentMapped,   // Buffer mappé en permanence, découpé en régions protégées par des fences
+        Orphaning           // Réallocation du buffer (orphaning) puis glBufferSubData
+    };
+
+    // Format des sommets envoyés au GPU
+    enum class VertexFormat {
+        Float,      // Positions et normales en float (24 octets par sommet)
+        Compact     // Positions sur 16 bits relatives à la boîte englobante du drapeau,
+                    // normales en encodage octaédrique sur 2 x 16 bits (12 octets par sommet)
+    };
+
+    // Nombre de régions du buffer mappé: le CPU écrit une frame pendant que le GPU lit les précédentes
+    static const int REGION_COUNT = 3;
+
+    FlagRenderer3D(int gridWidth, int gridHeight, UploadMode uploadMode = UploadMode::Auto,
+                   VertexFormat vertexFormat = VertexFormat::Float);
 
     ~FlagRenderer3D();
 
@@ -24,6 +41,9 @@ public:
 
 	void drawGrid(const glm::vec3* positionArray, bool wireframe);
 
+    // Dessine la grille avec des normales précalculées (par exemple lues dans un cache de simulation)
+    void drawGrid(const glm::vec3* positionArray, const glm::vec3* normalArray, bool wireframe);
+
     void setProjMatrix(const glm::mat4& P) {
         m_ProjMatrix = P;
     }
@@ -32,22 +52,70 @@ public:
         m_ViewMatrix = V;
     }
 
+    UploadMode getUploadMode() const {
+        return m_UploadMode;
+    }
+
+    VertexFormat getVertexFormat() const {
+        return m_VertexFormat;
+    }
+
+    // Pool utilisé pour calculer les normales en parallèle (nullptr: calcul séquentiel)
+    void setThreadPool(ThreadPool* pool) {
+        m_pThreadPool = pool;
+    }
+
+    // Rangées déplacées depuis le drawGrid précédent (une valeur non nulle par rangée modifiée, par exemple
+    // Flag::rowChangedArray), pour le prochain drawGrid seulement. En mode PersistentMapped + Float, les rangées
+    // inchangées depuis REGION_COUNT frames ne sont pas recopiées et leurs normales ne sont pas recalculées.
+    // Sans appel, toutes les rangées sont considérées comme modifiées
+    void setChangedRows(const uint8_t* changedRows) {
+        m_pChangedRows = changedRows;
+    }
+
 private:
 	static const GLchar *VERTEX_SHADER, *FRAGMENT_SHADER;
 
+    // Écrit les positions et normales au format compact et met à jour la boîte englobante
+    void packCompactVertices(const glm::vec3* positionArray, const glm::vec3* normalArray,
+                             GLubyte* positionDst, GLubyte* normalDst);
+
     // Ressources OpenGL
     GLuint m_ProgramID;
     GLuint m_VBOID, m_VAOID, m_IBOID;
 
     GLint m_uMVPMatrix, m_uMVMatrix;
+    GLint m_uPositionOffset, m_uPositionScale, m_uOctahedralNormals;
 
     glm::mat4 m_ProjMatrix;
     glm::mat4 m_ViewMatrix;
 
     int m_nGridWidth, m_nGridHeight;
     uint32_t m_nIndexCount;
-
-    std::vector<Vertex> m_VertexBuffer;
+    uint32_t m_nVertexCount;
+
+    // Le VBO contient les positions des REGION_COUNT régions, puis leurs normales.
+    // La région r commence au sommet r * m_nVertexCount pour les deux attributs
+    UploadMode m_UploadMode;
+    VertexFormat m_VertexFormat;
+    size_t m_nPositionSize, m_nNormalSize; // Taille en octets d'un attribut
+    GLubyte* m_pMappedBuffer;
+    GLsync m_Fences[REGION_COUNT];
+    int m_nCurrentRegion;
+
+    // Boîte englobante utilisée pour décoder les positions compactes
+    glm::vec3 m_PositionOffset, m_PositionScale;
+
+    std::vector<glm::vec3> m_FaceNormals; // Deux normales par quad
+    std::vector<glm::vec3> m_Normals;     // Inutilisé en mode PersistentMapped + Float
+    std::vector<GLubyte> m_Staging;       // Sommets compacts en mode Orphaning
+
+    ThreadPool* m_pThreadPool;
+
+    // Frames consécutives sans modification de chaque rangée, plafonnées à REGION_COUNT: une rangée
+    // à REGION_COUNT est identique dans la région courante, écrite REGION_COUNT frames plus tôt
+    const uint8_t* m_pChangedRows;
+    std::vector<uint8_t> m_RowAges;
 };
 
 }
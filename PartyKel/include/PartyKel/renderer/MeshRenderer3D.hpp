@@ -0,0 +1,70 @@
+#pragma once
+
+#include "PartyKel/glm.hpp"
+#include "PartyKel/TriangleMesh.hpp"
+#include <GL/glew.h>
+#include <vector>
+
+namespace PartyKel {
+
+class ThreadPool;
+
+// Rendu d'un maillage triangulaire indexé quelconque dont les sommets bougent à chaque frame (tissu construit
+// à partir d'un maillage, voir MeshCloth). Les indices sont envoyés une fois; positions et normales
+// sont renvoyées à chaque frame par orphaning, avec le même éclairage que FlagRenderer3D
+class MeshRenderer3D {
+public:
+    MeshRenderer3D(uint32_t vertexCount, const std::vector<uint32_t>& indexArray);
+
+    ~MeshRenderer3D();
+
+    MeshRenderer3D(const MeshRenderer3D&) = delete;
+
+    MeshRenderer3D& operator =(const MeshRenderer3D&) = delete;
+
+	void clear();
+
+    // Dessine le maillage; les normales sont calculées à partir des positions (voir TriangleMesh.hpp)
+	void drawMesh(const glm::vec3* positionArray, bool wireframe);
+
+    // Dessine le maillage avec des normales précalculées
+    void drawMesh(const glm::vec3* positionArray, const glm::vec3* normalArray, bool wireframe);
+
+    void setProjMatrix(const glm::mat4& P) {
+        m_ProjMatrix = P;
+    }
+
+    void setViewMatrix(const glm::mat4& V) {
+        m_ViewMatrix = V;
+    }
+
+    // Pool utilisé pour calculer les normales en parallèle (nullptr: calcul séquentiel)
+    void setThreadPool(ThreadPool* pool) {
+        m_pThreadPool = pool;
+    }
+
+private:
+	static const GLchar *VERTEX_SHADER, *FRAGMENT_SHADER;
+
+    // Ressources OpenGL
+    GLuint m_ProgramID;
+    GLuint m_VBOID, m_VAOID, m_IBOID;
+
+    GLint m_uMVPMatrix, m_uMVMatrix;
+
+    glm::mat4 m_ProjMatrix;
+    glm::mat4 m_ViewMatrix;
+
+    uint32_t m_nVertexCount;
+    uint32_t m_nIndexCount;
+
+    // Données du calcul des normales
+    std::vector<uint32_t> m_Indices;
+    VertexTriangles m_VertexTriangles;
+    std::vector<glm::vec3> m_FaceNormals;
+    std::vector<glm::vec3> m_Normals;
+
+    ThreadPool* m_pThreadPool;
+};
+
+}
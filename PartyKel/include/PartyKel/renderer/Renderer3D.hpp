@@ -18,6 +18,9 @@ public:
 
     void clear();
 
+    // Dessine count sphères par appels instanciés: la position, la masse (rayon = massScale * masse)
+    // et la couleur de chaque sphère sont envoyées comme attributs d'instance.
+    // Chaque sphère utilise un niveau de détail choisi selon sa taille projetée à l'écran (un appel par niveau)
     void drawParticles(uint32_t count,
                        const glm::vec3* positionArray,
                        const float* massArray,
@@ -32,20 +35,37 @@ public:
         m_ViewMatrix = V;
     }
 
+    // Nombre de niveaux de détail de la sphère, du plus fin au plus grossier
+    static const int LOD_COUNT = 4;
+
 private:
     static const GLchar *SPHERE_VERTEX_SHADER, *SPHERE_FRAGMENT_SHADER;
 
+    // Plage d'un niveau de détail dans les buffers de sommets et d'indices partagés
+    struct SphereLOD {
+        GLsizei indexCount;
+        GLsizeiptr indexOffset; // En octets
+        GLint baseVertex;
+    };
+
     // Ressources OpenGL
     GLuint m_SphereProgramID;
-    GLuint m_SphereVBOID, m_SphereVAOID;
+    GLuint m_SphereVBOID, m_SphereIBOID, m_SphereVAOID;
+    GLuint m_InstancePositionVBOID, m_InstanceMassVBOID, m_InstanceColorVBOID;
+
+    SphereLOD m_SphereLODs[LOD_COUNT];
 
-    uint32_t m_nSphereVertexCount;
+    // Attributs d'instance regroupés par niveau de détail
+    std::vector<uint8_t> m_InstanceLODs;
+    std::vector<glm::vec3> m_SortedPositions;
+    std::vector<float> m_SortedMasses;
+    std::vector<glm::vec3> m_SortedColors;
 
     glm::mat4 m_ProjMatrix;
     glm::mat4 m_ViewMatrix;
 
-    GLint m_uMVPMatrix, m_uMVMatrix;
-    GLint m_uParticleColor;
+    GLint m_uProjMatrix, m_uViewMatrix;
+    GLint m_uMassScale;
 };
 
 }
@@ -8,6 +8,7 @@ namespace PartyKel {
 
 // Représente une sphère discrétisée centrée en (0, 0, 0) (dans son repère local)
 // Son axe vertical est (0, 1, 0) et ses axes transversaux sont (1, 0, 0) et (0, 0, 1)
+// Les sommets sont partagés entre les triangles, décrits par un tableau d'indices (GL_TRIANGLES)
 class Sphere {
     // Alloue et construit les données (implantation dans le .cpp)
     void build(GLfloat radius, GLsizei discLat, GLsizei discLong);
@@ -18,11 +19,8 @@ public:
         glm::vec3 normal;
     };
 
-    std::vector<glm::vec3> _positions;
-
     // Constructeur: alloue le tableau de données et construit les attributs des vertex
-    Sphere(GLfloat radius, GLsizei discLat, GLsizei discLong):
-        m_nVertexCount(0) {
+    Sphere(GLfloat radius, GLsizei discLat, GLsizei discLong) {
         build(radius, discLat, discLong); // Construction (voir le .cpp)
     }
 
@@ -33,12 +31,22 @@ public:
 
     // Renvoit le nombre de vertex
     GLsizei getVertexCount() const {
-        return m_nVertexCount;
+        return m_Vertices.size();
+    }
+
+    // Renvoit le pointeur vers les indices des triangles
+    const GLuint* getIndexPointer() const {
+        return &m_Indices[0];
+    }
+
+    // Renvoit le nombre d'indices (3 par triangle)
+    GLsizei getIndexCount() const {
+        return m_Indices.size();
     }
 
 private:
     std::vector<Vertex> m_Vertices;
-    GLsizei m_nVertexCount; // Nombre de sommets
+    std::vector<GLuint> m_Indices;
 };
 
 struct SphereHandler{
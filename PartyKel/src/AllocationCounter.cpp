@@ -0,0 +1,88 @@
+#include "PartyKel/AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef PARTYKEL_ENABLE_PROFILING
+
+// PartyKel est une bibliothèque statique: ces opérateurs ne sont liés qu'aux programmes qui
+// appellent getAllocationCount (défini dans ce fichier)
+static std::atomic<uint64_t> s_AllocationCount(0);
+
+static void* countedAllocation(std::size_t size) {
+    s_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    // malloc(0) peut renvoyer nullptr, new doit renvoyer un pointeur unique
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new(std::size_t size) {
+    return countedAllocation(size);
+}
+
+void* operator new[](std::size_t size) {
+    return countedAllocation(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAllocation(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAllocation(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+namespace PartyKel {
+
+uint64_t getAllocationCount() {
+    return s_AllocationCount.load(std::memory_order_relaxed);
+}
+
+bool isAllocationCountingEnabled() {
+    return true;
+}
+
+}
+
+#else
+
+namespace PartyKel {
+
+uint64_t getAllocationCount() {
+    return 0;
+}
+
+bool isAllocationCountingEnabled() {
+    return false;
+}
+
+}
+
+#endif
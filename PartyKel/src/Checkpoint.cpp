@@ -0,0 +1,145 @@
+#include "PartyKel/Checkpoint.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace PartyKel {
+
+static const char CHECKPOINT_MAGIC[4] = { 'P', 'K', 'C', 'P' };
+static const uint64_t CHECKPOINT_ALIGNMENT = 16;
+
+CheckpointWriter::CheckpointWriter(const std::string& path):
+    m_Path(path), m_pFile(std::fopen(path.c_str(), "wb")), m_nOffset(0), m_bFailed(false) {
+
+    if (!m_pFile) {
+        throw std::runtime_error("Unable to open " + path + " for writing");
+    }
+
+    CheckpointHeader header;
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, 4);
+    header.version = CHECKPOINT_VERSION;
+    header.flags = 0;
+    header.reserved = 0;
+    append(&header, sizeof(header));
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    if (m_pFile) {
+        std::fclose(m_pFile);
+    }
+}
+
+uint64_t CheckpointWriter::append(const void* data, size_t size) {
+    static const uint8_t padding[CHECKPOINT_ALIGNMENT] = {};
+
+    uint64_t offset = (m_nOffset + CHECKPOINT_ALIGNMENT - 1) & ~(CHECKPOINT_ALIGNMENT - 1);
+    if (offset != m_nOffset) {
+        m_bFailed |= std::fwrite(padding, 1, offset - m_nOffset, m_pFile) != offset - m_nOffset;
+    }
+    if (size) {
+        m_bFailed |= std::fwrite(data, 1, size, m_pFile) != size;
+    }
+    m_nOffset = offset + size;
+    return offset;
+}
+
+void CheckpointWriter::write(uint32_t tag, const void* data, size_t size) {
+    CheckpointSection section = { tag, 0, append(data, size), size };
+    m_Sections.push_back(section);
+}
+
+void CheckpointWriter::close() {
+    if (!m_pFile)
+        return;
+
+    CheckpointFooter footer;
+    footer.tableOffset = append(m_Sections.data(), m_Sections.size() * sizeof(CheckpointSection));
+    footer.sectionCount = uint32_t(m_Sections.size());
+    std::memcpy(footer.magic, CHECKPOINT_MAGIC, 4);
+    m_bFailed |= std::fwrite(&footer, sizeof(footer), 1, m_pFile) != 1;
+
+    m_bFailed |= std::fclose(m_pFile) != 0;
+    m_pFile = nullptr;
+
+    if (m_bFailed) {
+        throw std::runtime_error("Unable to write checkpoint " + m_Path);
+    }
+}
+
+CheckpointReader::CheckpointReader(const std::string& path):
+    m_pData(nullptr), m_nSize(0), m_nVersion(0), m_pSections(nullptr), m_nSectionCount(0) {
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open checkpoint " + path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(CheckpointHeader) + sizeof(CheckpointFooter)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid checkpoint " + path);
+    }
+    m_nSize = info.st_size;
+
+    void* data = ::mmap(nullptr, m_nSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Unable to map checkpoint " + path);
+    }
+    m_pData = static_cast<const uint8_t*>(data);
+
+    const CheckpointHeader* header = reinterpret_cast<const CheckpointHeader*>(m_pData);
+    const CheckpointFooter* footer = reinterpret_cast<const CheckpointFooter*>(m_pData + m_nSize - sizeof(CheckpointFooter));
+    m_nVersion = header->version;
+
+    bool valid = std::memcmp(header->magic, CHECKPOINT_MAGIC, 4) == 0 &&
+                 std::memcmp(footer->magic, CHECKPOINT_MAGIC, 4) == 0 &&
+                 footer->tableOffset % CHECKPOINT_ALIGNMENT == 0 &&
+                 footer->tableOffset <= m_nSize - sizeof(CheckpointFooter) &&
+                 footer->sectionCount <= (m_nSize - sizeof(CheckpointFooter) - footer->tableOffset) / sizeof(CheckpointSection);
+    if (!valid) {
+        ::munmap(const_cast<uint8_t*>(m_pData), m_nSize);
+        throw std::runtime_error("Invalid checkpoint " + path);
+    }
+    if (m_nVersion > CHECKPOINT_VERSION) {
+        ::munmap(const_cast<uint8_t*>(m_pData), m_nSize);
+        throw std::runtime_error("Checkpoint " + path + " was written by a newer version");
+    }
+
+    m_pSections = reinterpret_cast<const CheckpointSection*>(m_pData + footer->tableOffset);
+    m_nSectionCount = footer->sectionCount;
+
+    for (uint32_t i = 0; i < m_nSectionCount; ++i) {
+        const CheckpointSection& s = m_pSections[i];
+        if (s.offset > footer->tableOffset || s.size > footer->tableOffset - s.offset) {
+            ::munmap(const_cast<uint8_t*>(m_pData), m_nSize);
+            throw std::runtime_error("Invalid checkpoint " + path);
+        }
+    }
+}
+
+CheckpointReader::~CheckpointReader() {
+    ::munmap(const_cast<uint8_t*>(m_pData), m_nSize);
+}
+
+const CheckpointSection* CheckpointReader::findSection(uint32_t tag) const {
+    for (uint32_t i = 0; i < m_nSectionCount; ++i) {
+        if (m_pSections[i].tag == tag)
+            return m_pSections + i;
+    }
+    return nullptr;
+}
+
+const void* CheckpointReader::section(uint32_t tag, size_t& size) const {
+    const CheckpointSection* s = findSection(tag);
+    if (!s) {
+        throw std::runtime_error("Missing checkpoint section");
+    }
+    size = s->size;
+    return m_pData + s->offset;
+}
+
+}
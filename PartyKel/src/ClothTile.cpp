@@ -0,0 +1,100 @@
+#include "PartyKel/ClothTile.hpp"
+#include "PartyKel/SceneConfig.hpp"
+#include "PartyKel/ThreadPool.hpp"
+#include "PartyKel/Forces.hpp"
+#include "PartyKel/Profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace PartyKel {
+
+ClothTile::ClothTile(const SceneConfig& scene, int rowBegin, int rowEnd):
+    m_nGridWidth(scene.grid.x), m_nGridHeight(scene.grid.y),
+    m_nRowBegin(rowBegin), m_nRowEnd(rowEnd),
+    m_nStoredBegin(std::max(rowBegin - HALO_ROWS, 0)), m_nStoredEnd(std::min(rowEnd + HALO_ROWS, scene.grid.y)) {
+    if (rowBegin < 0 || rowEnd > m_nGridHeight || rowEnd - rowBegin < HALO_ROWS)
+        throw std::out_of_range("ClothTile rows [" + std::to_string(rowBegin) + ", " + std::to_string(rowEnd) +
+                                ") do not fit a " + std::to_string(m_nGridHeight) + " rows grid");
+
+    gridRestLengths(scene.size, m_nGridWidth, m_nGridHeight, m_L0, m_fL1, m_L2);
+
+    // Même position de départ que Flag::reset, pour les rangées de la bande et du halo.
+    // Les tableaux sont remplis par le processus de la bande: ses pages sont placées sur son noeud mémoire
+    int storedCount = (m_nStoredEnd - m_nStoredBegin) * m_nGridWidth;
+    m_Positions.resize(storedCount);
+    m_Velocities.assign(storedCount, glm::vec3(0.f));
+    m_Forces.assign(storedCount, glm::vec3(0.f));
+
+    glm::vec3 origin(-0.5f * scene.size.x, 0.f, 0.f);
+    glm::vec3 scale(scene.size.x / (m_nGridWidth - 1), scene.size.y / (m_nGridHeight - 1), 1.f);
+    for (int j = m_nStoredBegin; j < m_nStoredEnd; ++j) {
+        for (int i = 0; i < m_nGridWidth; ++i)
+            m_Positions[index(i, j)] = origin + glm::vec3(i, j, origin.z) * scale;
+    }
+}
+
+void ClothTile::step(const SceneConfig& scene, float dt, const glm::vec3& wind, ThreadPool& pool) {
+    // La dernière rangée du drapeau est fixe
+    int forceEnd = std::min(m_nRowEnd, m_nGridHeight - 1);
+    GridSprings springs = { scene.K0, scene.K1, scene.K2, scene.V0, scene.V1, scene.V2, m_L0, m_fL1, m_L2 };
+
+    {
+        PK_SCOPED_TIMER(PROFILE_INTERNAL_FORCES);
+        pool.parallelFor(m_nRowBegin, forceEnd, 1, [&](int begin, int end) {
+            for (int j = begin; j < end; ++j) {
+                for (int i = 0; i < m_nGridWidth; ++i) {
+                    int currentK = index(i, j);
+                    const glm::vec3& position = m_Positions[currentK];
+                    const glm::vec3& velocity = m_Velocities[currentK];
+
+                    // Ordre de Flag: gravité, vent, ressorts puis sphères
+                    glm::vec3 force = scene.gravity;
+                    force += wind;
+
+                    forEachGridSpring(i, j, m_nGridWidth, m_nGridHeight, springs, [&](int x, int y, float K, float L, float V) {
+                        int k = index(x, y);
+                        force += hookForce(K, L, position, m_Positions[k]);
+                        force += brakeForce(V, dt, velocity, m_Velocities[k]);
+                    });
+
+                    if (scene.activeSpheres) {
+                        for (size_t s = 0; s < scene.spherePositions.size(); ++s) {
+                            float dist = glm::distance(scene.spherePositions[s], position);
+                            if (dist < scene.sphereRadius[s] + scene.radiusDelta)
+                                force += sphereCollisionForce(dist, scene.spherePositions[s], position) * scene.sphereCollisionMultiplier;
+                        }
+                    }
+
+                    m_Forces[currentK] = force;
+                }
+            }
+        });
+    }
+
+    // Comme Flag::update; Flag::reset donne une masse de 1 à chaque particule
+    {
+        PK_SCOPED_TIMER(PROFILE_INTEGRATION);
+        pool.parallelFor(m_nRowBegin, m_nRowEnd, 1, [&](int begin, int end) {
+            for (int k = index(0, begin); k < index(0, end); ++k) {
+                m_Velocities[k] += dt * m_Forces[k];
+                m_Positions[k] += dt * m_Velocities[k];
+                m_Forces[k] = glm::vec3(0);
+            }
+        });
+    }
+}
+
+void ClothTile::packRows(int row, int rowCount, glm::vec3* data) const {
+    size_t count = size_t(rowCount) * m_nGridWidth;
+    std::copy_n(&m_Positions[index(0, row)], count, data);
+    std::copy_n(&m_Velocities[index(0, row)], count, data + count);
+}
+
+void ClothTile::unpackRows(int row, int rowCount, const glm::vec3* data) {
+    size_t count = size_t(rowCount) * m_nGridWidth;
+    std::copy_n(data, count, &m_Positions[index(0, row)]);
+    std::copy_n(data + count, count, &m_Velocities[index(0, row)]);
+}
+
+}
@@ -0,0 +1,445 @@
+#include "PartyKel/ClothWorld.hpp"
+#include "PartyKel/Forces.hpp"
+#include "PartyKel/Random.hpp"
+#include "PartyKel/Profiler.hpp"
+#include "PartyKel/ThreadPool.hpp"
+#include "PartyKel/FrameArena.hpp"
+#include "PartyKel/SceneConfig.hpp"
+#include "PartyKel/renderer/Sphere.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace PartyKel {
+
+namespace {
+
+// Contact trouvé par un thread, ajouté au cache une fois la détection terminée
+struct ContactCandidate {
+    int particle, other;
+    glm::vec3 normal;
+    float penetration;
+};
+
+// Traite les lots dans l'ordre. Les contacts d'un lot coloré sont indépendants et répartis sur le pool;
+// le dernier lot (contacts qui n'ont pas pu être colorés) est traité séquentiellement
+template<typename F>
+void solveBatches(ThreadPool& pool, const std::vector<int>& offsets, F solveRange) {
+    static const int grain = 256;
+    int batchCount = offsets.size() - 1;
+    for (int batch = 0; batch < batchCount; ++batch) {
+        int begin = offsets[batch], end = offsets[batch + 1];
+        if (batch == batchCount - 1 || end - begin < 2 * grain)
+            solveRange(begin, end);
+        else
+            pool.parallelFor(begin, end, grain, solveRange);
+    }
+}
+
+}
+
+ClothWorld::ClothWorld():
+    m_SpringStart(1, 0), m_nFrame(0) {
+}
+
+int ClothWorld::addCloth(const glm::ivec2& grid, const glm::vec2& size, const glm::mat4& transform, const SceneConfig& scene) {
+    if (grid.x < 2 || grid.y < 2) {
+        throw std::runtime_error("A cloth needs at least 2 x 2 particles");
+    }
+
+    int index = m_Cloths.size();
+    Cloth cloth = { int(m_Positions.size()), grid.x, grid.y, size, transform };
+    m_Cloths.push_back(cloth);
+
+    size_t particleCount = m_Positions.size() + grid.x * grid.y;
+    m_Positions.resize(particleCount);
+    m_Velocities.resize(particleCount);
+    m_Forces.resize(particleCount, glm::vec3(0.f));
+    m_ContactVelocities.resize(particleCount, glm::vec3(0.f));
+    m_InvMasses.resize(particleCount);
+    m_ClothIndices.resize(particleCount, index);
+    m_ParticleColors.resize(particleCount, 0);
+    m_Winds.resize(m_Cloths.size());
+
+    // Mêmes ressorts que Flag::applyInternalForces; les longueurs à vide sont celles de la grille au repos
+    GridSprings springs = { scene.K0, scene.K1, scene.K2, scene.V0, scene.V1, scene.V2 };
+    gridRestLengths(size, grid.x, grid.y, springs.L0, springs.L1, springs.L2);
+
+    for (int j = 0; j < grid.y; ++j) {
+        for (int i = 0; i < grid.x; ++i) {
+            // Les particules fixes n'ont pas de ressorts
+            if (j < grid.y - 1) {
+                forEachGridSpring(i, j, grid.x, grid.y, springs, [&](int x, int y, float K, float L, float V) {
+                    Spring spring = { cloth.firstParticle + y * grid.x + x, K, L, V };
+                    m_Springs.push_back(spring);
+                });
+            }
+            m_SpringStart.push_back(m_Springs.size());
+        }
+    }
+
+    initCloth(index);
+    return index;
+}
+
+void ClothWorld::initCloth(int index) {
+    const Cloth& cloth = m_Cloths[index];
+    glm::vec3 origin(-0.5f * cloth.size.x, 0.f, 0.f);
+    glm::vec3 scale(cloth.size.x / (cloth.gridWidth - 1), cloth.size.y / (cloth.gridHeight - 1), 1.f);
+
+    for (int j = 0; j < cloth.gridHeight; ++j) {
+        for (int i = 0; i < cloth.gridWidth; ++i) {
+            int k = cloth.firstParticle + j * cloth.gridWidth + i;
+            glm::vec3 position = origin + glm::vec3(i, j, 0.f) * scale;
+            m_Positions[k] = glm::vec3(cloth.transform * glm::vec4(position, 1.f));
+            // Masse unitaire, comme Flag::reset()
+            m_InvMasses[k] = j == cloth.gridHeight - 1 ? 0.f : 1.f;
+        }
+    }
+
+    auto first = cloth.firstParticle, last = cloth.firstParticle + cloth.gridWidth * cloth.gridHeight;
+    std::fill(m_Velocities.begin() + first, m_Velocities.begin() + last, glm::vec3(0.f));
+    std::fill(m_Forces.begin() + first, m_Forces.begin() + last, glm::vec3(0.f));
+    std::fill(m_ContactVelocities.begin() + first, m_ContactVelocities.begin() + last, glm::vec3(0.f));
+}
+
+void ClothWorld::reset() {
+    for (int index = 0; index < getClothCount(); ++index)
+        initCloth(index);
+    m_SphereContacts.clear();
+    m_ParticleContacts.clear();
+    m_nFrame = 0;
+}
+
+int ClothWorld::step(float dt, const SceneConfig& scene, const SphereHandler& sphereHandler, ThreadPool& pool) {
+    pool.resetFrameArenas();
+
+    {
+        PK_SCOPED_TIMER(PROFILE_INTERNAL_FORCES);
+        applyForces(dt, scene, sphereHandler, pool);
+    }
+
+    detectCollisions(scene, sphereHandler, pool);
+
+    int iterations = 0;
+    if (scene.activeContactSolver) {
+        PK_SCOPED_TIMER(PROFILE_CONTACTS);
+        iterations = solveContacts(dt, scene.contactIterations, pool);
+    }
+
+    {
+        PK_SCOPED_TIMER(PROFILE_INTEGRATION);
+        integrate(dt, pool);
+    }
+
+    ++m_nFrame;
+    return iterations;
+}
+
+void ClothWorld::applyForces(float dt, const SceneConfig& scene, const SphereHandler& sphereHandler, ThreadPool& pool) {
+    // Le premier tissu reçoit le même vent que le drapeau de flag pour la même graine et la même frame
+    RandomStream wind(scene.seed, RANDOM_STREAM_WIND, m_nFrame);
+    for (auto& clothWind : m_Winds)
+        clothWind = wind.sphericalRand(scene.windVelocity);
+
+    // Avec le solveur, les contacts des sphères sont résolus par impulsions, sans force de pénalité
+    bool activeSpheres = scene.activeSpheres && !scene.activeContactSolver;
+    pool.parallelFor(0, getParticleCount(), 1024, [&](int begin, int end) {
+        for (int k = begin; k < end; ++k) {
+            if (m_InvMasses[k] == 0.f)
+                continue;
+
+            const glm::vec3& position = m_Positions[k];
+            const glm::vec3& velocity = m_Velocities[k];
+            glm::vec3 force = m_Forces[k] + scene.gravity + m_Winds[m_ClothIndices[k]];
+
+            for (int s = m_SpringStart[k]; s < m_SpringStart[k + 1]; ++s) {
+                const Spring& spring = m_Springs[s];
+                force += hookForce(spring.K, spring.L, position, m_Positions[spring.other]);
+                force += brakeForce(spring.V, dt, velocity, m_Velocities[spring.other]);
+            }
+
+            if (activeSpheres) {
+                for (size_t j = 0; j < sphereHandler.positions.size(); ++j) {
+                    float dist = glm::distance(sphereHandler.positions[j], position);
+                    if (dist < sphereHandler.radius[j] + scene.radiusDelta) {
+                        force += sphereCollisionForce(dist, sphereHandler.positions[j], position) * scene.sphereCollisionMultiplier;
+                    }
+                }
+            }
+
+            m_Forces[k] = force;
+        }
+    });
+    PK_COUNT(PROFILE_SPRINGS_EVALUATED, m_Springs.size());
+}
+
+bool ClothWorld::areNeighbors(int a, int b) const {
+    int cloth = m_ClothIndices[a];
+    if (cloth != m_ClothIndices[b])
+        return false;
+
+    int width = m_Cloths[cloth].gridWidth;
+    int first = m_Cloths[cloth].firstParticle;
+    a -= first;
+    b -= first;
+    return std::abs(a % width - b % width) <= 2 && std::abs(a / width - b / width) <= 2;
+}
+
+void ClothWorld::detectCollisions(const SceneConfig& scene, const SphereHandler& sphereHandler, ThreadPool& pool) {
+    int particleCount = getParticleCount();
+    float maxDst = scene.maxDstRepulseForce;
+    bool findContacts = scene.activeContactSolver;
+
+    {
+        PK_SCOPED_TIMER(PROFILE_OCTREE_BUILD);
+        m_SpatialHash.build(m_Positions.data(), particleCount, maxDst, &pool);
+    }
+
+    ArenaList<ContactCandidate>* pairs = pool.allocateThreadLists<ContactCandidate>();
+    ArenaList<ContactCandidate>* sphereHits = pool.allocateThreadLists<ContactCandidate>();
+
+    // Une seule passe sur la grille pour la répulsion et les contacts, entre particules d'un même tissu ou non
+    if (scene.activeAutoCollisions) {
+        PK_SCOPED_TIMER(PROFILE_REPULSION);
+        pool.parallelFor(0, particleCount, 512, [&](int begin, int end) {
+            ArenaList<ContactCandidate>& found = pairs[ThreadPool::getCurrentThreadIndex()];
+            for (int a = begin; a < end; ++a) {
+                const glm::vec3& position = m_Positions[a];
+                bool fixed = m_InvMasses[a] == 0.f;
+                glm::vec3 repulsion(0.f);
+
+                m_SpatialHash.forEachNear(position, [&](int b) {
+                    glm::vec3 d = position - m_Positions[b];
+                    float dist = glm::length(d);
+                    if (dist >= maxDst || dist <= 0.f)
+                        return;
+
+                    // Comme Flag::applyRepulseForces, la répulsion s'applique aussi entre voisins de la grille,
+                    // mais pas aux paires résolues par le solveur
+                    if (!findContacts || (fixed && m_InvMasses[b] == 0.f) || areNeighbors(a, b)) {
+                        repulsion += repulseForce(dist, position, m_Positions[b]);
+                        return;
+                    }
+
+                    // Chaque paire n'est ajoutée qu'une fois
+                    if (b > a)
+                        found.push_back(ContactCandidate{ a, b, d / dist, maxDst - dist });
+                });
+
+                if (!fixed)
+                    m_Forces[a] += repulsion * scene.multRepulseForce;
+            }
+        });
+    }
+
+    if (findContacts && scene.activeSpheres) {
+        PK_SCOPED_TIMER(PROFILE_CONTACTS);
+        for (size_t s = 0; s < sphereHandler.positions.size(); ++s) {
+            const glm::vec3& center = sphereHandler.positions[s];
+            float reach = sphereHandler.radius[s] + scene.radiusDelta;
+
+            auto test = [&](int k, ArenaList<ContactCandidate>& found) {
+                if (m_InvMasses[k] == 0.f)
+                    return;
+                glm::vec3 d = m_Positions[k] - center;
+                float dist = glm::length(d);
+                float penetration = reach - dist;
+                if (penetration > 0.f && dist > 0.f)
+                    found.push_back(ContactCandidate{ k, int(s), d / dist, penetration });
+            };
+
+            // Parcours des cellules couvertes par la sphère, sauf si elles sont plus nombreuses que les particules
+            glm::ivec3 minCell = m_SpatialHash.cellOf(center - glm::vec3(reach));
+            glm::ivec3 maxCell = m_SpatialHash.cellOf(center + glm::vec3(reach));
+            glm::ivec3 extent = maxCell - minCell + glm::ivec3(1);
+            if (double(extent.x) * extent.y * extent.z > particleCount) {
+                pool.parallelFor(0, particleCount, 1024, [&](int begin, int end) {
+                    ArenaList<ContactCandidate>& found = sphereHits[ThreadPool::getCurrentThreadIndex()];
+                    for (int k = begin; k < end; ++k)
+                        test(k, found);
+                });
+            } else {
+                pool.parallelFor(minCell.x, maxCell.x + 1, 1, [&](int xBegin, int xEnd) {
+                    ArenaList<ContactCandidate>& found = sphereHits[ThreadPool::getCurrentThreadIndex()];
+                    for (int x = xBegin; x < xEnd; ++x)
+                        for (int y = minCell.y; y <= maxCell.y; ++y)
+                            for (int z = minCell.z; z <= maxCell.z; ++z)
+                                m_SpatialHash.forEachInCell(glm::ivec3(x, y, z), [&](int k) { test(k, found); });
+                });
+            }
+        }
+    }
+
+    if (!findContacts) {
+        m_SphereContacts.clear();
+        m_ParticleContacts.clear();
+        return;
+    }
+
+    // L'ordre d'ajout est sans importance: endFrame() trie les contacts par clé
+    unsigned int threadCount = pool.getThreadCount();
+    if (scene.activeSpheres) {
+        m_SphereContacts.beginFrame();
+        for (unsigned int t = 0; t < threadCount; ++t) {
+            sphereHits[t].forEach([&](const ContactCandidate& c) {
+                m_SphereContacts.add(ContactCache::colliderKey(c.particle, c.other), c.particle, c.other, c.normal, c.penetration);
+            });
+        }
+        m_SphereContacts.endFrame();
+    } else {
+        m_SphereContacts.clear();
+    }
+
+    if (scene.activeAutoCollisions) {
+        m_ParticleContacts.beginFrame();
+        for (unsigned int t = 0; t < threadCount; ++t) {
+            pairs[t].forEach([&](const ContactCandidate& c) {
+                m_ParticleContacts.add(ContactCache::pairKey(c.particle, c.other), c.particle, c.other, c.normal, c.penetration);
+            });
+        }
+        m_ParticleContacts.endFrame();
+    } else {
+        m_ParticleContacts.clear();
+    }
+    PK_COUNT(PROFILE_CONTACTS_FOUND, m_SphereContacts.contacts().size() + m_ParticleContacts.contacts().size());
+}
+
+void ClothWorld::buildBatches(const std::vector<Contact>& contacts, bool pairs, Batches& batches) {
+    // Coloration gloutonne dans l'ordre des clés: chaque contact prend le premier lot
+    // qu'aucune de ses particules n'utilise encore
+    batches.colors.resize(contacts.size());
+    batches.order.resize(contacts.size());
+    batches.offsets.assign(MAX_BATCH_COLORS + 2, 0);
+
+    for (size_t c = 0; c < contacts.size(); ++c) {
+        const Contact& contact = contacts[c];
+        uint64_t used = m_ParticleColors[contact.particle] | (pairs ? m_ParticleColors[contact.other] : 0);
+        int color = 0;
+        while (color < MAX_BATCH_COLORS && (used >> color) & 1)
+            ++color;
+        if (color < MAX_BATCH_COLORS) {
+            m_ParticleColors[contact.particle] |= uint64_t(1) << color;
+            if (pairs)
+                m_ParticleColors[contact.other] |= uint64_t(1) << color;
+        }
+        batches.colors[c] = color;
+        ++batches.offsets[color + 1];
+    }
+
+    for (const Contact& contact : contacts) {
+        m_ParticleColors[contact.particle] = 0;
+        if (pairs)
+            m_ParticleColors[contact.other] = 0;
+    }
+
+    for (int color = 1; color <= MAX_BATCH_COLORS + 1; ++color)
+        batches.offsets[color] += batches.offsets[color - 1];
+
+    int cursor[MAX_BATCH_COLORS + 1];
+    std::copy(batches.offsets.begin(), batches.offsets.end() - 1, cursor);
+    for (size_t c = 0; c < contacts.size(); ++c)
+        batches.order[cursor[batches.colors[c]]++] = c;
+}
+
+int ClothWorld::getBatchCount() const {
+    int count = 0;
+    for (const Batches* batches : { &m_SphereBatches, &m_ParticleBatches }) {
+        for (size_t batch = 0; batch + 1 < batches->offsets.size(); ++batch)
+            count += batches->offsets[batch + 1] > batches->offsets[batch];
+    }
+    return count;
+}
+
+int ClothWorld::solveContacts(float dt, int maxIterations, ThreadPool& pool) {
+    // Mêmes paramètres que Flag::solveContacts
+    static const float beta = 0.2f;
+    static const float slop = 0.005f;
+    static const float tolerance = 0.00001f;
+
+    std::vector<Contact>& sphereContacts = m_SphereContacts.contacts();
+    std::vector<Contact>& particleContacts = m_ParticleContacts.contacts();
+    buildBatches(sphereContacts, false, m_SphereBatches);
+    buildBatches(particleContacts, true, m_ParticleBatches);
+
+    auto predictedVelocity = [&](int k) {
+        return m_Velocities[k] + dt * m_Forces[k] * m_InvMasses[k] + m_ContactVelocities[k];
+    };
+
+    // Warm-starting: applique les impulsions accumulées à la frame précédente
+    for (const auto& c : sphereContacts) {
+        m_ContactVelocities[c.particle] += c.impulse * m_InvMasses[c.particle] * c.normal;
+    }
+    for (const auto& c : particleContacts) {
+        m_ContactVelocities[c.particle] += c.impulse * m_InvMasses[c.particle] * c.normal;
+        m_ContactVelocities[c.other] -= c.impulse * m_InvMasses[c.other] * c.normal;
+    }
+
+    m_ThreadCorrections.resize(pool.getThreadCount());
+
+    auto solveSphereContacts = [&](int begin, int end) {
+        float& maxCorrection = m_ThreadCorrections[ThreadPool::getCurrentThreadIndex()];
+        for (int e = begin; e < end; ++e) {
+            Contact& c = sphereContacts[m_SphereBatches.order[e]];
+            float w = m_InvMasses[c.particle];
+            if (w == 0.f)
+                continue;
+
+            float vn = glm::dot(predictedVelocity(c.particle), c.normal);
+            float bias = beta * std::max(c.penetration - slop, 0.f) / dt;
+            float impulse = std::max(c.impulse + (bias - vn) / w, 0.f);
+            float delta = impulse - c.impulse;
+            c.impulse = impulse;
+
+            m_ContactVelocities[c.particle] += delta * w * c.normal;
+            maxCorrection = std::max(maxCorrection, std::abs(delta) * w);
+        }
+    };
+
+    auto solveParticleContacts = [&](int begin, int end) {
+        float& maxCorrection = m_ThreadCorrections[ThreadPool::getCurrentThreadIndex()];
+        for (int e = begin; e < end; ++e) {
+            Contact& c = particleContacts[m_ParticleBatches.order[e]];
+            float wA = m_InvMasses[c.particle], wB = m_InvMasses[c.other];
+            if (wA + wB == 0.f)
+                continue;
+
+            float vn = glm::dot(predictedVelocity(c.particle) - predictedVelocity(c.other), c.normal);
+            float bias = beta * std::max(c.penetration - slop, 0.f) / dt;
+            float impulse = std::max(c.impulse + (bias - vn) / (wA + wB), 0.f);
+            float delta = impulse - c.impulse;
+            c.impulse = impulse;
+
+            m_ContactVelocities[c.particle] += delta * wA * c.normal;
+            m_ContactVelocities[c.other] -= delta * wB * c.normal;
+            maxCorrection = std::max(maxCorrection, std::abs(delta) * (wA + wB));
+        }
+    };
+
+    int iteration = 0;
+    while (iteration < maxIterations) {
+        ++iteration;
+        std::fill(m_ThreadCorrections.begin(), m_ThreadCorrections.end(), 0.f);
+
+        solveBatches(pool, m_SphereBatches.offsets, solveSphereContacts);
+        solveBatches(pool, m_ParticleBatches.offsets, solveParticleContacts);
+
+        if (*std::max_element(m_ThreadCorrections.begin(), m_ThreadCorrections.end()) < tolerance)
+            break;
+    }
+
+    return iteration;
+}
+
+void ClothWorld::integrate(float dt, ThreadPool& pool) {
+    pool.parallelFor(0, getParticleCount(), 4096, [&](int begin, int end) {
+        for (int k = begin; k < end; ++k) {
+            m_Velocities[k] += m_ContactVelocities[k] + dt * m_Forces[k] * m_InvMasses[k];
+            m_Positions[k] += dt * m_Velocities[k];
+            m_Forces[k] = glm::vec3(0.f);
+            m_ContactVelocities[k] = glm::vec3(0.f);
+        }
+    });
+}
+
+}
@@ -0,0 +1,44 @@
+#include "PartyKel/ContactCache.hpp"
+
+#include <algorithm>
+
+namespace PartyKel {
+
+void ContactCache::beginFrame() {
+    std::swap(m_Contacts, m_PreviousContacts);
+    m_Contacts.clear();
+    m_nPersistentCount = 0;
+}
+
+void ContactCache::add(uint64_t key, int particle, int other, const glm::vec3& normal, float penetration) {
+    Contact contact = { key, particle, other, normal, penetration, 0.f, 0 };
+
+    // Recherche dichotomique dans les contacts (triés) de la frame précédente
+    auto it = std::lower_bound(m_PreviousContacts.begin(), m_PreviousContacts.end(), key,
+                               [](const Contact& c, uint64_t k) { return c.key < k; });
+    if (it != m_PreviousContacts.end() && it->key == key) {
+        contact.impulse = it->impulse;
+        ++m_nPersistentCount;
+    }
+
+    m_Contacts.push_back(contact);
+}
+
+void ContactCache::endFrame() {
+    std::sort(m_Contacts.begin(), m_Contacts.end(),
+              [](const Contact& a, const Contact& b) { return a.key < b.key; });
+}
+
+void ContactCache::clear() {
+    m_Contacts.clear();
+    m_PreviousContacts.clear();
+    m_nPersistentCount = 0;
+}
+
+void ContactCache::restore(const Contact* contacts, size_t count) {
+    m_Contacts.assign(contacts, contacts + count);
+    m_PreviousContacts.clear();
+    m_nPersistentCount = 0;
+}
+
+}
@@ -0,0 +1,488 @@
+#include "PartyKel/Flag.hpp"
+#include "PartyKel/Forces.hpp"
+#include "PartyKel/Checkpoint.hpp"
+#include "PartyKel/Profiler.hpp"
+#include "PartyKel/ThreadPool.hpp"
+#include "PartyKel/renderer/Sphere.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace PartyKel {
+
+const int Flag::SLEEP_TILE_SIZE;
+const int Flag::EXTERNAL_FORCE_FRAMES;
+
+Flag::Flag(float mass, float width, float height, int gridWidth, int gridHeight):
+    gridWidth(gridWidth), gridHeight(gridHeight), size(width, height), offset(0.f),
+    positionArray(gridWidth * gridHeight),
+    velocityArray(gridWidth * gridHeight, glm::vec3(0.f)),
+    massArray(gridWidth * gridHeight, mass / (gridWidth * gridHeight)),
+    forceArray(gridWidth * gridHeight, glm::vec3(0.f)),
+    contactVelocityArray(gridWidth * gridHeight, glm::vec3(0.f)) {
+
+    nbParticles = gridWidth * gridHeight;
+
+    tileCountX = (gridWidth + SLEEP_TILE_SIZE - 1) / SLEEP_TILE_SIZE;
+    tileCountY = (gridHeight + SLEEP_TILE_SIZE - 1) / SLEEP_TILE_SIZE;
+    awakeArray.resize(nbParticles);
+    tileAwakeArray.resize(tileCountX * tileCountY);
+    tileQuietFrameArray.resize(tileCountX * tileCountY);
+    tileEnergyArray.resize(tileCountX * tileCountY);
+    tileSleepForceArray.resize(tileCountX * tileCountY);
+    rowChangedArray.resize(gridHeight);
+    reset();
+
+    // Les longueurs à vide sont calculés à partir de la position initiale
+    // des points sur le drapeau
+    gridRestLengths(glm::vec2(width, height), gridWidth, gridHeight, L0, L1, L2);
+
+    // Paramètres à fixer pour avoir un système stable
+    K0 = 1;
+    K1 = 1;
+    K2 = 1;
+
+    V0 = 0.08;
+    V1 = 0.02;
+    V2 = 0.06;
+
+    sleepThreshold = 0.f;
+    sleepFrames = 30;
+    wakeForceDelta = 0.01f;
+}
+
+void Flag::reset() {
+    // glm::vec3 origin(-0.5f * width, -0.5f * height, 0.f);
+    glm::vec3 origin(-0.5f * size.x, 0.f, 0.f);
+    glm::vec3 scale(size.x / (gridWidth - 1), size.y / (gridHeight - 1), 1.f);
+
+    for (int j = 0; j < gridHeight; ++j) {
+        for (int i = 0; i < gridWidth; ++i) {
+            int k = i + j * gridWidth;
+            positionArray[k] = offset + origin + glm::vec3(i, j, origin.z) * scale;
+            massArray[k] = 1 - ( i / (2*(gridHeight*gridWidth)));
+        }
+    }
+
+    std::fill(velocityArray.begin(), velocityArray.end(), glm::vec3(0.f));
+    std::fill(forceArray.begin(), forceArray.end(), glm::vec3(0.f));
+    std::fill(contactVelocityArray.begin(), contactVelocityArray.end(), glm::vec3(0.f));
+    sphereContacts.clear();
+    selfContacts.clear();
+    wakeAll();
+}
+
+void Flag::applyInternalForces(float dt) {
+    GridSprings springs = { K0, K1, K2, V0, V1, V2, L0, L1, L2 };
+    uint64_t springCount = 0;
+    for (int i = 0; i < gridWidth; ++i) {
+        for (int j = 0; j < gridHeight-1; ++j) {
+            int currentK = j*gridWidth + i;
+            if (!awakeArray[currentK])
+                continue;
+
+            springCount += forEachGridSpring(i, j, gridWidth, gridHeight, springs, [&](int x, int y, float K, float L, float V) {
+                int k = y * gridWidth + x;
+                forceArray[currentK] += hookForce(K, L, positionArray[currentK], positionArray[k]);
+                forceArray[currentK] += brakeForce(V, dt, velocityArray[currentK], velocityArray[k]);
+            });
+        }
+    }
+    PK_COUNT(PROFILE_SPRINGS_EVALUATED, springCount);
+}
+
+void Flag::applyRepulseForces(Octree<int>& octree, float maxDst, float multRepulse, bool skipContactPairs) {
+    for (int i = 0; i < gridWidth; ++i) {
+        for (int j = 0; j < gridHeight-1; ++j) {
+            int k = j*gridWidth + i;
+            if (!awakeArray[k])
+                continue;
+            auto& pos = positionArray[k];
+
+            auto inSameVoxel = octree.get(pos);
+            assert(!inSameVoxel.empty());
+
+            if (inSameVoxel.size() < 2)
+                continue;
+
+            for (int other : inSameVoxel) {
+                auto& v = positionArray[other];
+                float dst = glm::distance(v, pos);
+                if (dst > maxDst || pos == v)
+                    continue;
+                if (skipContactPairs && !(std::abs(other % gridWidth - i) <= 2 && std::abs(other / gridWidth - j) <= 2))
+                    continue;
+
+                forceArray[k] += repulseForce(dst, pos, v) * multRepulse;
+            }
+        }
+    }
+}
+
+void Flag::applyExternalForce(const glm::vec3& F) {
+    externalForce += F;
+    for (int i = 0; i < nbParticles; ++i) {
+        // if (i % gridWidth == 0) continue;
+        if (i > nbParticles - gridWidth-1 || !awakeArray[i]) continue;
+        forceArray[i] += F;
+    }
+}
+
+void Flag::applySphereCollision(const SphereHandler& sphereHandler, float multiplier, float radiusDelta) {
+    for (int i = 0; i < nbParticles; ++i) {
+        // if (i % gridWidth == 0) continue;
+        if (i > nbParticles - gridWidth-1 || !awakeArray[i]) continue;
+
+        for (size_t j = 0; j < sphereHandler.positions.size(); ++j) {
+            float dist = glm::distance(sphereHandler.positions[j], positionArray[i]);
+            if (dist < sphereHandler.radius[j] + radiusDelta) {
+                forceArray[i] += sphereCollisionForce(dist, sphereHandler.positions[j], positionArray[i]) * multiplier;
+            }
+        }
+    }
+}
+
+void Flag::detectSphereContacts(const SphereHandler& sphereHandler, float radiusDelta) {
+    sphereContacts.beginFrame();
+    for (int i = 0; i < nbParticles; ++i) {
+        if (i > nbParticles - gridWidth-1) continue;
+
+        for (size_t j = 0; j < sphereHandler.positions.size(); ++j) {
+            glm::vec3 d = positionArray[i] - sphereHandler.positions[j];
+            float dist = glm::length(d);
+            float penetration = sphereHandler.radius[j] + radiusDelta - dist;
+            if (penetration > 0.f && dist > 0.f) {
+                sphereContacts.add(ContactCache::colliderKey(i, j), i, j, d / dist, penetration);
+            }
+        }
+    }
+    sphereContacts.endFrame();
+    PK_COUNT(PROFILE_CONTACTS_FOUND, sphereContacts.contacts().size());
+}
+
+void Flag::detectSelfContacts(Octree<int>& octree, float minDst, ThreadPool* pool) {
+    selfContacts.beginFrame();
+    if (!pool) {
+        for (int i = 0; i < gridWidth; ++i) {
+            for (int j = 0; j < gridHeight-1; ++j) {
+                int k = j*gridWidth + i;
+                auto& pos = positionArray[k];
+
+                for (int other : octree.get(pos)) {
+                    // Chaque paire n'est traitée qu'une fois
+                    if (other <= k)
+                        continue;
+                    if (std::abs(other % gridWidth - i) <= 2 && std::abs(other / gridWidth - j) <= 2)
+                        continue;
+
+                    glm::vec3 d = pos - positionArray[other];
+                    float dist = glm::length(d);
+                    if (dist >= minDst || dist <= 0.f)
+                        continue;
+
+                    selfContacts.add(ContactCache::pairKey(k, other), k, other, d / dist, minDst - dist);
+                }
+            }
+        }
+    } else {
+        // Paire trouvée par un thread, ajoutée au cache une fois la recherche terminée
+        struct Candidate {
+            int particle, other;
+            glm::vec3 normal;
+            float penetration;
+        };
+
+        // Une liste par thread: pas de synchronisation pendant la recherche
+        ArenaList<Candidate>* candidates = pool->allocateThreadLists<Candidate>();
+
+        pool->parallelFor(0, nbParticles - gridWidth, 1024, [&](int begin, int end) {
+            ArenaList<Candidate>& found = candidates[ThreadPool::getCurrentThreadIndex()];
+            for (int k = begin; k < end; ++k) {
+                int i = k % gridWidth, j = k / gridWidth;
+                auto& pos = positionArray[k];
+
+                for (int other : octree.get(pos)) {
+                    if (other <= k)
+                        continue;
+                    if (std::abs(other % gridWidth - i) <= 2 && std::abs(other / gridWidth - j) <= 2)
+                        continue;
+
+                    glm::vec3 d = pos - positionArray[other];
+                    float dist = glm::length(d);
+                    if (dist >= minDst || dist <= 0.f)
+                        continue;
+
+                    found.push_back(Candidate{ k, other, d / dist, minDst - dist });
+                }
+            }
+        });
+
+        // L'ordre d'ajout est sans importance: endFrame() trie les contacts par clé
+        for (unsigned int t = 0; t < pool->getThreadCount(); ++t) {
+            candidates[t].forEach([&](const Candidate& c) {
+                selfContacts.add(ContactCache::pairKey(c.particle, c.other), c.particle, c.other, c.normal, c.penetration);
+            });
+        }
+    }
+    selfContacts.endFrame();
+    PK_COUNT(PROFILE_CONTACTS_FOUND, selfContacts.contacts().size());
+}
+
+int Flag::solveContacts(float dt, int maxIterations) {
+    static const float beta = 0.2f;         // Part de la pénétration corrigée à chaque pas
+    static const float slop = 0.005f;       // Pénétration tolérée
+    static const float tolerance = 0.00001f;
+
+    // Les particules fixes et endormies sont immobiles
+    auto invMass = [&](int k) {
+        return k > nbParticles - gridWidth-1 || !awakeArray[k] ? 0.f : 1.f / massArray[k];
+    };
+    auto predictedVelocity = [&](int k) {
+        return velocityArray[k] + dt * (forceArray[k]/massArray[k]) + contactVelocityArray[k];
+    };
+
+    std::fill(contactVelocityArray.begin(), contactVelocityArray.end(), glm::vec3(0.f));
+
+    // Warm-starting: applique les impulsions accumulées à la frame précédente
+    for (auto& c : sphereContacts.contacts()) {
+        contactVelocityArray[c.particle] += c.impulse * invMass(c.particle) * c.normal;
+    }
+    for (auto& c : selfContacts.contacts()) {
+        contactVelocityArray[c.particle] += c.impulse * invMass(c.particle) * c.normal;
+        contactVelocityArray[c.other] -= c.impulse * invMass(c.other) * c.normal;
+    }
+
+    int iteration = 0;
+    while (iteration < maxIterations) {
+        ++iteration;
+        float maxCorrection = 0.f;
+
+        for (auto& c : sphereContacts.contacts()) {
+            float w = invMass(c.particle);
+            if (w == 0.f)
+                continue;
+
+            float vn = glm::dot(predictedVelocity(c.particle), c.normal);
+            float bias = beta * std::max(c.penetration - slop, 0.f) / dt;
+            float impulse = std::max(c.impulse + (bias - vn) / w, 0.f);
+            float delta = impulse - c.impulse;
+            c.impulse = impulse;
+
+            contactVelocityArray[c.particle] += delta * w * c.normal;
+            maxCorrection = std::max(maxCorrection, std::abs(delta) * w);
+        }
+
+        for (auto& c : selfContacts.contacts()) {
+            float wA = invMass(c.particle), wB = invMass(c.other);
+            if (wA + wB == 0.f)
+                continue;
+
+            float vn = glm::dot(predictedVelocity(c.particle) - predictedVelocity(c.other), c.normal);
+            float bias = beta * std::max(c.penetration - slop, 0.f) / dt;
+            float impulse = std::max(c.impulse + (bias - vn) / (wA + wB), 0.f);
+            float delta = impulse - c.impulse;
+            c.impulse = impulse;
+
+            contactVelocityArray[c.particle] += delta * wA * c.normal;
+            contactVelocityArray[c.other] -= delta * wB * c.normal;
+            maxCorrection = std::max(maxCorrection, std::abs(delta) * (wA + wB));
+        }
+
+        if (maxCorrection < tolerance)
+            break;
+    }
+
+    for (int i = 0; i < nbParticles; ++i) {
+        velocityArray[i] += contactVelocityArray[i];
+    }
+
+    return iteration;
+}
+
+void Flag::update(float dt) {
+    for (int i = 0; i < nbParticles ; ++i) {
+        if (!awakeArray[i])
+            continue;
+        velocityArray[i] += dt * (forceArray[i]/massArray[i]);
+        positionArray[i] += dt * velocityArray[i];
+        forceArray[i] = glm::vec3(0);
+    }
+    updateSleeping();
+}
+
+void Flag::updateSleeping() {
+    int tileCount = tileCountX * tileCountY;
+    if (sleepThreshold <= 0.f) {
+        if (getSleepingTileCount())
+            wakeAll();
+        else
+            std::fill(rowChangedArray.begin(), rowChangedArray.end(), 1);
+        externalForce = glm::vec3(0.f);
+        return;
+    }
+
+    // Moyenne cumulée sur les premiers pas, puis moyenne exponentielle
+    externalForceFrames = std::min(externalForceFrames + 1, EXTERNAL_FORCE_FRAMES);
+    meanExternalForce += (externalForce - meanExternalForce) / float(externalForceFrames);
+
+    auto tileOf = [&](int k) {
+        return (k / gridWidth / SLEEP_TILE_SIZE) * tileCountX + (k % gridWidth) / SLEEP_TILE_SIZE;
+    };
+
+    // Seules les rangées des tuiles éveillées ont été intégrées
+    for (int ty = 0; ty < tileCountY; ++ty) {
+        uint8_t changed = 0;
+        for (int tx = 0; tx < tileCountX; ++tx)
+            changed |= tileAwakeArray[ty * tileCountX + tx];
+        for (int j = ty * SLEEP_TILE_SIZE; j < std::min((ty + 1) * SLEEP_TILE_SIZE, gridHeight); ++j)
+            rowChangedArray[j] = changed;
+    }
+
+    // Énergie cinétique moyenne des tuiles éveillées
+    std::fill(tileEnergyArray.begin(), tileEnergyArray.end(), 0.f);
+    for (int k = 0; k < nbParticles; ++k) {
+        if (awakeArray[k])
+            tileEnergyArray[tileOf(k)] += 0.5f * massArray[k] * glm::dot(velocityArray[k], velocityArray[k]);
+    }
+    for (int tile = 0; tile < tileCount; ++tile) {
+        int width = std::min(SLEEP_TILE_SIZE, gridWidth - (tile % tileCountX) * SLEEP_TILE_SIZE);
+        int height = std::min(SLEEP_TILE_SIZE, gridHeight - (tile / tileCountX) * SLEEP_TILE_SIZE);
+        tileEnergyArray[tile] /= width * height;
+    }
+
+    // Réveils: contacts apparus ou disparus, forces externes modifiées, tuile voisine en mouvement
+    sphereContacts.forEachChangedContact([&](const Contact& c) {
+        wakeParticle(c.particle);
+    });
+    selfContacts.forEachChangedContact([&](const Contact& c) {
+        wakeParticle(c.particle);
+        wakeParticle(c.other);
+    });
+
+    for (int tile = 0; tile < tileCount; ++tile) {
+        if (tileAwakeArray[tile])
+            continue;
+        bool wake = glm::distance(meanExternalForce, tileSleepForceArray[tile]) > wakeForceDelta;
+        int tx = tile % tileCountX, ty = tile / tileCountX;
+        for (int y = std::max(ty - 1, 0); y <= std::min(ty + 1, tileCountY - 1) && !wake; ++y) {
+            for (int x = std::max(tx - 1, 0); x <= std::min(tx + 1, tileCountX - 1) && !wake; ++x) {
+                int neighbor = y * tileCountX + x;
+                wake = tileAwakeArray[neighbor] && tileEnergyArray[neighbor] > sleepThreshold;
+            }
+        }
+        if (wake)
+            setTileAwake(tile, true);
+    }
+
+    // Endormissements
+    for (int tile = 0; tile < tileCount; ++tile) {
+        if (!tileAwakeArray[tile])
+            continue;
+        if (tileEnergyArray[tile] >= sleepThreshold) {
+            tileQuietFrameArray[tile] = 0;
+        } else if (++tileQuietFrameArray[tile] >= sleepFrames) {
+            setTileAwake(tile, false);
+            tileSleepForceArray[tile] = meanExternalForce;
+        }
+    }
+
+    externalForce = glm::vec3(0.f);
+}
+
+void Flag::wakeAll() {
+    std::fill(awakeArray.begin(), awakeArray.end(), 1);
+    std::fill(tileAwakeArray.begin(), tileAwakeArray.end(), 1);
+    std::fill(tileQuietFrameArray.begin(), tileQuietFrameArray.end(), 0);
+    std::fill(tileEnergyArray.begin(), tileEnergyArray.end(), 0.f);
+    std::fill(rowChangedArray.begin(), rowChangedArray.end(), 1);
+    externalForce = glm::vec3(0.f);
+    meanExternalForce = glm::vec3(0.f);
+    externalForceFrames = 0;
+}
+
+void Flag::wakeParticle(int k) {
+    int tile = (k / gridWidth / SLEEP_TILE_SIZE) * tileCountX + (k % gridWidth) / SLEEP_TILE_SIZE;
+    if (!tileAwakeArray[tile])
+        setTileAwake(tile, true);
+}
+
+void Flag::setTileAwake(int tile, bool awake) {
+    tileAwakeArray[tile] = awake;
+    tileQuietFrameArray[tile] = 0;
+    tileEnergyArray[tile] = 0.f;
+    int i0 = (tile % tileCountX) * SLEEP_TILE_SIZE, j0 = (tile / tileCountX) * SLEEP_TILE_SIZE;
+    for (int j = j0; j < std::min(j0 + SLEEP_TILE_SIZE, gridHeight); ++j) {
+        for (int i = i0; i < std::min(i0 + SLEEP_TILE_SIZE, gridWidth); ++i) {
+            awakeArray[j * gridWidth + i] = awake;
+            if (!awake)
+                velocityArray[j * gridWidth + i] = glm::vec3(0.f);
+        }
+    }
+}
+
+int Flag::getSleepingTileCount() const {
+    return std::count(tileAwakeArray.begin(), tileAwakeArray.end(), 0);
+}
+
+void Flag::save(CheckpointWriter& checkpoint) const {
+    float parameters[] = { L0.x, L0.y, L1, L2.x, L2.y, K0, K1, K2, V0, V1, V2 };
+
+    checkpoint.write(checkpointTag("GRID"), glm::ivec2(gridWidth, gridHeight));
+    checkpoint.write(checkpointTag("POSI"), positionArray);
+    checkpoint.write(checkpointTag("VELO"), velocityArray);
+    checkpoint.write(checkpointTag("MASS"), massArray);
+    checkpoint.write(checkpointTag("FORC"), forceArray);
+    checkpoint.write(checkpointTag("CVEL"), contactVelocityArray);
+    checkpoint.write(checkpointTag("PARM"), parameters, sizeof(parameters));
+    checkpoint.write(checkpointTag("SCON"), sphereContacts.contacts());
+    checkpoint.write(checkpointTag("ACON"), selfContacts.contacts());
+}
+
+void Flag::load(const CheckpointReader& checkpoint) {
+    glm::ivec2 grid;
+    checkpoint.read(checkpointTag("GRID"), grid);
+    if (grid != glm::ivec2(gridWidth, gridHeight)) {
+        throw std::runtime_error("Checkpoint grid size does not match the flag");
+    }
+
+    size_t positionCount, velocityCount, massCount, forceCount, contactVelocityCount, parameterCount;
+    const glm::vec3* positions = checkpoint.array<glm::vec3>(checkpointTag("POSI"), positionCount);
+    const glm::vec3* velocities = checkpoint.array<glm::vec3>(checkpointTag("VELO"), velocityCount);
+    const float* masses = checkpoint.array<float>(checkpointTag("MASS"), massCount);
+    const glm::vec3* forces = checkpoint.array<glm::vec3>(checkpointTag("FORC"), forceCount);
+    const glm::vec3* contactVelocities = checkpoint.array<glm::vec3>(checkpointTag("CVEL"), contactVelocityCount);
+    const float* parameters = checkpoint.array<float>(checkpointTag("PARM"), parameterCount);
+
+    size_t n = nbParticles;
+    if (positionCount != n || velocityCount != n || massCount != n || forceCount != n ||
+        contactVelocityCount != n || parameterCount != 11) {
+        throw std::runtime_error("Checkpoint arrays do not match the flag");
+    }
+
+    // Tous les contrôles sont faits: le drapeau n'est modifié qu'à partir d'ici
+    std::copy(positions, positions + n, positionArray.begin());
+    std::copy(velocities, velocities + n, velocityArray.begin());
+    std::copy(masses, masses + n, massArray.begin());
+    std::copy(forces, forces + n, forceArray.begin());
+    std::copy(contactVelocities, contactVelocities + n, contactVelocityArray.begin());
+
+    L0 = glm::vec2(parameters[0], parameters[1]);
+    L1 = parameters[2];
+    L2 = glm::vec2(parameters[3], parameters[4]);
+    K0 = parameters[5];
+    K1 = parameters[6];
+    K2 = parameters[7];
+    V0 = parameters[8];
+    V1 = parameters[9];
+    V2 = parameters[10];
+
+    size_t contactCount;
+    const Contact* contacts = checkpoint.array<Contact>(checkpointTag("SCON"), contactCount);
+    sphereContacts.restore(contacts, contactCount);
+    contacts = checkpoint.array<Contact>(checkpointTag("ACON"), contactCount);
+    selfContacts.restore(contacts, contactCount);
+    wakeAll();
+}
+
+}
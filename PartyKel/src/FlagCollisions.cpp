@@ -0,0 +1,234 @@
+#include "PartyKel/FlagCollisions.hpp"
+#include "PartyKel/Flag.hpp"
+#include "PartyKel/Forces.hpp"
+#include "PartyKel/Profiler.hpp"
+#include "PartyKel/ThreadPool.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace PartyKel {
+
+namespace {
+
+// Paire de particules (numérotation commune à tous les drapeaux) trouvée par un thread
+struct PairCandidate {
+    int particle, other;
+    glm::vec3 normal;
+    float penetration;
+};
+
+bool isFixed(const Flag& flag, int k) {
+    return k > flag.nbParticles - flag.gridWidth - 1;
+}
+
+}
+
+void FlagCollisions::detect(const std::vector<Flag*>& flags, float maxDst, float multRepulse, bool findContacts, ThreadPool& pool) {
+    int flagCount = flags.size();
+    m_FirstParticles.resize(flagCount + 1);
+    m_FirstParticles[0] = 0;
+    for (int f = 0; f < flagCount; ++f)
+        m_FirstParticles[f + 1] = m_FirstParticles[f] + flags[f]->nbParticles;
+
+    int particleCount = m_FirstParticles[flagCount];
+    m_Positions.resize(particleCount);
+    m_FlagIndices.resize(particleCount);
+    m_Boxes.resize(flagCount);
+
+    // Boîte de chaque drapeau, élargie de maxDst / 2: deux particules à moins de maxDst
+    // appartiennent à des drapeaux dont les boîtes se recouvrent
+    pool.parallelFor(0, flagCount, 1, [&](int begin, int end) {
+        for (int f = begin; f < end; ++f) {
+            const Flag& flag = *flags[f];
+            int first = m_FirstParticles[f];
+            Box box = { glm::vec3(std::numeric_limits<float>::max()), glm::vec3(-std::numeric_limits<float>::max()) };
+            for (int k = 0; k < flag.nbParticles; ++k) {
+                const glm::vec3& position = flag.positionArray[k];
+                box.min = glm::min(box.min, position);
+                box.max = glm::max(box.max, position);
+                m_Positions[first + k] = position;
+                m_FlagIndices[first + k] = f;
+            }
+            box.min -= glm::vec3(0.5f * maxDst);
+            box.max += glm::vec3(0.5f * maxDst);
+            m_Boxes[f] = box;
+        }
+    });
+
+    m_Overlaps.assign(flagCount * flagCount, 0);
+    m_nOverlappingPairs = 0;
+    for (int a = 0; a < flagCount; ++a) {
+        m_Overlaps[a * flagCount + a] = 1;
+        for (int b = a + 1; b < flagCount; ++b) {
+            const Box& A = m_Boxes[a];
+            const Box& B = m_Boxes[b];
+            bool overlapping = glm::all(glm::lessThanEqual(A.min, B.max)) && glm::all(glm::lessThanEqual(B.min, A.max));
+            m_Overlaps[a * flagCount + b] = m_Overlaps[b * flagCount + a] = overlapping;
+            m_nOverlappingPairs += overlapping;
+        }
+    }
+
+    {
+        PK_SCOPED_TIMER(PROFILE_OCTREE_BUILD);
+        m_SpatialHash.build(m_Positions.data(), particleCount, maxDst, &pool);
+    }
+
+    // Une seule passe pour la répulsion (comme Flag::applyRepulseForces) et les contacts
+    // (comme Flag::detectSelfContacts), d'un même drapeau ou de deux drapeaux
+    ArenaList<PairCandidate>* candidates = pool.allocateThreadLists<PairCandidate>();
+    pool.parallelFor(0, particleCount, 512, [&](int begin, int end) {
+        ArenaList<PairCandidate>& found = candidates[ThreadPool::getCurrentThreadIndex()];
+        for (int a = begin; a < end; ++a) {
+            int flagA = m_FlagIndices[a];
+            Flag& flag = *flags[flagA];
+            int k = a - m_FirstParticles[flagA];
+            bool fixed = isFixed(flag, k);
+            const glm::vec3& position = m_Positions[a];
+            glm::vec3 repulsion(0.f);
+
+            m_SpatialHash.forEachNear(position, [&](int b) {
+                // Drapeaux éloignés: écartés sans calcul de distance
+                int flagB = m_FlagIndices[b];
+                if (!overlap(flagA, flagB))
+                    return;
+
+                glm::vec3 d = position - m_Positions[b];
+                float dist = glm::length(d);
+                if (dist > maxDst || dist <= 0.f)
+                    return;
+
+                // Paire résolue par le solveur: elle ne reçoit pas de force de répulsion
+                int other = b - m_FirstParticles[flagB];
+                bool contact = findContacts && dist < maxDst;
+                if (flagB == flagA) {
+                    int width = flag.gridWidth;
+                    if (fixed || (std::abs(other % width - k % width) <= 2 && std::abs(other / width - k / width) <= 2))
+                        contact = false;
+                } else if (fixed && isFixed(*flags[flagB], other)) {
+                    contact = false;
+                }
+                if (!contact) {
+                    repulsion += repulseForce(dist, position, m_Positions[b]);
+                    return;
+                }
+
+                // Chaque paire n'est ajoutée qu'une fois
+                if (b <= a)
+                    return;
+                found.push_back(PairCandidate{ a, b, d / dist, maxDst - dist });
+            });
+
+            if (!fixed && flag.awakeArray[k])
+                flag.forceArray[k] += repulsion * multRepulse;
+        }
+    });
+
+    if (!findContacts) {
+        for (Flag* flag : flags)
+            flag->selfContacts.clear();
+        m_MutualContacts.clear();
+        return;
+    }
+
+    // L'ordre d'ajout est sans importance: endFrame() trie les contacts par clé
+    for (Flag* flag : flags)
+        flag->selfContacts.beginFrame();
+    m_MutualContacts.beginFrame();
+    for (unsigned int t = 0; t < pool.getThreadCount(); ++t) {
+        candidates[t].forEach([&](const PairCandidate& c) {
+            int flagA = m_FlagIndices[c.particle], flagB = m_FlagIndices[c.other];
+            if (flagA == flagB) {
+                int k = c.particle - m_FirstParticles[flagA], other = c.other - m_FirstParticles[flagA];
+                flags[flagA]->selfContacts.add(ContactCache::pairKey(k, other), k, other, c.normal, c.penetration);
+            } else {
+                m_MutualContacts.add(ContactCache::pairKey(c.particle, c.other), c.particle, c.other, c.normal, c.penetration);
+            }
+        });
+    }
+
+    size_t contactCount = m_MutualContacts.contacts().size();
+    for (Flag* flag : flags) {
+        flag->selfContacts.endFrame();
+        contactCount += flag->selfContacts.contacts().size();
+    }
+    m_MutualContacts.endFrame();
+
+    // Un contact apparu ou disparu entre deux drapeaux réveille les tuiles concernées
+    auto wake = [&](int p) {
+        flags[m_FlagIndices[p]]->wakeParticle(p - m_FirstParticles[m_FlagIndices[p]]);
+    };
+    m_MutualContacts.forEachChangedContact([&](const Contact& c) {
+        wake(c.particle);
+        wake(c.other);
+    });
+    PK_COUNT(PROFILE_CONTACTS_FOUND, contactCount);
+}
+
+int FlagCollisions::solveContacts(const std::vector<Flag*>& flags, float dt, int maxIterations) {
+    // Mêmes paramètres que Flag::solveContacts
+    static const float beta = 0.2f;
+    static const float slop = 0.005f;
+    static const float tolerance = 0.00001f;
+
+    // Drapeaux séparés: rien à faire
+    std::vector<Contact>& contacts = m_MutualContacts.contacts();
+    if (contacts.empty())
+        return 0;
+
+    m_ContactVelocities.assign(m_Positions.size(), glm::vec3(0.f));
+
+    auto invMass = [&](int p) {
+        const Flag& flag = *flags[m_FlagIndices[p]];
+        int k = p - m_FirstParticles[m_FlagIndices[p]];
+        return isFixed(flag, k) || !flag.awakeArray[k] ? 0.f : 1.f / flag.massArray[k];
+    };
+    // Les vitesses des drapeaux comprennent déjà les corrections de leurs propres contacts
+    auto predictedVelocity = [&](int p) {
+        const Flag& flag = *flags[m_FlagIndices[p]];
+        int k = p - m_FirstParticles[m_FlagIndices[p]];
+        return flag.velocityArray[k] + dt * (flag.forceArray[k] / flag.massArray[k]) + m_ContactVelocities[p];
+    };
+
+    // Warm-starting: applique les impulsions accumulées à la frame précédente
+    for (const auto& c : contacts) {
+        m_ContactVelocities[c.particle] += c.impulse * invMass(c.particle) * c.normal;
+        m_ContactVelocities[c.other] -= c.impulse * invMass(c.other) * c.normal;
+    }
+
+    int iteration = 0;
+    while (iteration < maxIterations) {
+        ++iteration;
+        float maxCorrection = 0.f;
+
+        for (auto& c : contacts) {
+            float wA = invMass(c.particle), wB = invMass(c.other);
+            if (wA + wB == 0.f)
+                continue;
+
+            float vn = glm::dot(predictedVelocity(c.particle) - predictedVelocity(c.other), c.normal);
+            float bias = beta * std::max(c.penetration - slop, 0.f) / dt;
+            float impulse = std::max(c.impulse + (bias - vn) / (wA + wB), 0.f);
+            float delta = impulse - c.impulse;
+            c.impulse = impulse;
+
+            m_ContactVelocities[c.particle] += delta * wA * c.normal;
+            m_ContactVelocities[c.other] -= delta * wB * c.normal;
+            maxCorrection = std::max(maxCorrection, std::abs(delta) * (wA + wB));
+        }
+
+        if (maxCorrection < tolerance)
+            break;
+    }
+
+    for (size_t f = 0; f < flags.size(); ++f) {
+        Flag& flag = *flags[f];
+        const glm::vec3* velocities = m_ContactVelocities.data() + m_FirstParticles[f];
+        for (int k = 0; k < flag.nbParticles; ++k)
+            flag.velocityArray[k] += velocities[k];
+    }
+
+    return iteration;
+}
+
+}
@@ -0,0 +1,65 @@
+#include "PartyKel/FrameArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace PartyKel {
+
+FrameArena::FrameArena(size_t initialCapacity):
+    m_nInitialCapacity(std::max(initialCapacity, size_t(1024))), m_nOffset(0), m_nUsedBytes(0), m_nFrameBytes(0) {
+    // Les blocs ne sont alloués qu'à la première allocation: une arène inutilisée ne coûte rien
+}
+
+FrameArena::~FrameArena() {
+    for (const Block& block : m_Blocks)
+        ::operator delete(block.data);
+}
+
+void FrameArena::addBlock(size_t minimumSize) {
+    size_t size = std::max(minimumSize, m_Blocks.empty() ? m_nInitialCapacity : 2 * m_Blocks.back().size);
+    Block block = { static_cast<char*>(::operator new(size)), size };
+    m_Blocks.push_back(block);
+    m_nOffset = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    if (!m_Blocks.empty()) {
+        const Block& block = m_Blocks.back();
+        uintptr_t address = reinterpret_cast<uintptr_t>(block.data) + m_nOffset;
+        size_t padding = (alignment - address % alignment) % alignment;
+        if (m_nOffset + padding + size <= block.size) {
+            m_nOffset += padding + size;
+            m_nUsedBytes += size;
+            m_nFrameBytes += padding + size;
+            return block.data + m_nOffset - size;
+        }
+        // La fin du bloc courant est perdue pour ce pas
+        m_nFrameBytes += block.size - m_nOffset;
+    }
+
+    addBlock(size + alignment);
+    return allocate(size, alignment);
+}
+
+void FrameArena::reset() {
+    // Plusieurs blocs: le pas n'a pas tenu dans le premier, un bloc unique les remplace
+    if (m_Blocks.size() > 1) {
+        size_t capacity = getCapacity();
+        for (const Block& block : m_Blocks)
+            ::operator delete(block.data);
+        m_Blocks.clear();
+        addBlock(std::max(capacity, m_nFrameBytes));
+    }
+    m_nOffset = 0;
+    m_nUsedBytes = 0;
+    m_nFrameBytes = 0;
+}
+
+size_t FrameArena::getCapacity() const {
+    size_t capacity = 0;
+    for (const Block& block : m_Blocks)
+        capacity += block.size;
+    return capacity;
+}
+
+}
@@ -0,0 +1,97 @@
+#include "PartyKel/GridMesh.hpp"
+#include "PartyKel/ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace PartyKel {
+
+static inline glm::vec3 triangleNormal(const glm::vec3& A, const glm::vec3& B, const glm::vec3& C) {
+    glm::vec3 N = glm::cross(B - A, C - A);
+    float l = glm::length(N);
+    return l > 0.0001f ? N / l : glm::vec3(0.f);
+}
+
+void computeGridFaceNormals(const glm::vec3* positionArray, int gridWidth, int gridHeight,
+                            glm::vec3* faceNormalArray, int rowBegin, int rowEnd) {
+    rowEnd = std::min(rowEnd, gridHeight - 1);
+    for (int j = rowBegin; j < rowEnd; ++j) {
+        const glm::vec3* row = positionArray + j * gridWidth;
+        const glm::vec3* nextRow = row + gridWidth;
+        glm::vec3* faces = faceNormalArray + 2 * j * (gridWidth - 1);
+
+        for (int i = 0; i < gridWidth - 1; ++i) {
+            faces[2 * i] = triangleNormal(row[i], row[i + 1], nextRow[i + 1]);
+            faces[2 * i + 1] = triangleNormal(row[i], nextRow[i + 1], nextRow[i]);
+        }
+    }
+}
+
+void gatherGridVertexNormals(const glm::vec3* faceNormalArray, int gridWidth, int gridHeight,
+                             glm::vec3* normalArray, int rowBegin, int rowEnd) {
+    int quadRowSize = 2 * (gridWidth - 1);
+
+    for (int j = rowBegin; j < rowEnd; ++j) {
+        // Quads au-dessus (j) et au-dessous (j - 1) de la ligne de sommets
+        const glm::vec3* upper = j < gridHeight - 1 ? faceNormalArray + j * quadRowSize : nullptr;
+        const glm::vec3* lower = j > 0 ? faceNormalArray + (j - 1) * quadRowSize : nullptr;
+        glm::vec3* normals = normalArray + j * gridWidth;
+
+        for (int i = 0; i < gridWidth; ++i) {
+            glm::vec3 N(0.f);
+
+            if (upper) {
+                // Sommet inférieur gauche du quad (i, j): deux triangles; inférieur droit du quad (i-1, j): un triangle
+                if (i < gridWidth - 1)
+                    N += upper[2 * i] + upper[2 * i + 1];
+                if (i > 0)
+                    N += upper[2 * (i - 1)];
+            }
+            if (lower) {
+                // Sommet supérieur droit du quad (i-1, j-1): deux triangles; supérieur gauche du quad (i, j-1): un triangle
+                if (i > 0)
+                    N += lower[2 * (i - 1)] + lower[2 * (i - 1) + 1];
+                if (i < gridWidth - 1)
+                    N += lower[2 * i + 1];
+            }
+
+            float l = glm::length(N);
+            normals[i] = l > 0.f ? N / l : glm::vec3(0.f);
+        }
+    }
+}
+
+void buildGridIndices(int gridWidth, int gridHeight, std::vector<uint32_t>& indexArray) {
+    indexArray.clear();
+    indexArray.reserve(6 * (gridWidth - 1) * (gridHeight - 1));
+    for (int j = 0; j < gridHeight - 1; ++j) {
+        for (int i = 0; i < gridWidth - 1; ++i) {
+            indexArray.push_back(i + j * gridWidth);
+            indexArray.push_back((i + 1) + j * gridWidth);
+            indexArray.push_back((i + 1) + (j + 1) * gridWidth);
+            indexArray.push_back(i + j * gridWidth);
+            indexArray.push_back((i + 1) + (j + 1) * gridWidth);
+            indexArray.push_back(i + (j + 1) * gridWidth);
+        }
+    }
+}
+
+void computeGridNormals(const glm::vec3* positionArray, int gridWidth, int gridHeight,
+                        glm::vec3* faceNormalArray, glm::vec3* normalArray, ThreadPool* pool) {
+    if (!pool) {
+        computeGridFaceNormals(positionArray, gridWidth, gridHeight, faceNormalArray, 0, gridHeight - 1);
+        gatherGridVertexNormals(faceNormalArray, gridWidth, gridHeight, normalArray, 0, gridHeight);
+        return;
+    }
+
+    // Environ 4096 sommets par bloc
+    int grain = std::max(1, 4096 / std::max(gridWidth, 1));
+
+    pool->parallelFor(0, gridHeight - 1, grain, [&](int rowBegin, int rowEnd) {
+        computeGridFaceNormals(positionArray, gridWidth, gridHeight, faceNormalArray, rowBegin, rowEnd);
+    });
+    pool->parallelFor(0, gridHeight, grain, [&](int rowBegin, int rowEnd) {
+        gatherGridVertexNormals(faceNormalArray, gridWidth, gridHeight, normalArray, rowBegin, rowEnd);
+    });
+}
+
+}
@@ -0,0 +1,259 @@
+#include "PartyKel/HeadlessRenderer.hpp"
+
+#ifdef PARTYKEL_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace PartyKel {
+
+// Nombre maximal d'images en attente d'encodage avant de bloquer le rendu
+static const size_t MAX_PENDING_FRAMES = 8;
+
+HeadlessRenderer::HeadlessRenderer(uint32_t width, uint32_t height, const std::string& outputDirectory):
+    m_nWidth(width), m_nHeight(height), m_OutputDirectory(outputDirectory),
+    m_pDisplay(nullptr), m_pContext(nullptr),
+    m_nFrameCount(0), m_bStop(false) {
+
+    createContext();
+
+    if (::mkdir(m_OutputDirectory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Unable to create output directory " + m_OutputDirectory);
+    }
+
+    // FBO dans lequel les renderers dessinent
+    glGenRenderbuffers(1, &m_ColorRBOID);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_ColorRBOID);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &m_DepthRBOID);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_DepthRBOID);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_FBOID);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_FBOID);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColorRBOID);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_DepthRBOID);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        throw std::runtime_error("Unable to create the offscreen framebuffer");
+    }
+    glViewport(0, 0, width, height);
+
+    // PBO de relecture asynchrone
+    glGenBuffers(PBO_COUNT, m_PBOIDs);
+    for (int i = 0; i < PBO_COUNT; ++i) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PBOIDs[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, nullptr, GL_STREAM_READ);
+        m_PBOFences[i] = 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_EncoderThread = std::thread(&HeadlessRenderer::encoderLoop, this);
+}
+
+HeadlessRenderer::~HeadlessRenderer() {
+    // Récupère les frames dont la relecture est encore en cours
+    uint32_t first = m_nFrameCount > PBO_COUNT ? m_nFrameCount - PBO_COUNT : 0;
+    for (uint32_t index = first; index < m_nFrameCount; ++index) {
+        collectFrame(index);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_bStop = true;
+    }
+    m_Condition.notify_all();
+    m_EncoderThread.join();
+
+    glDeleteBuffers(PBO_COUNT, m_PBOIDs);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &m_FBOID);
+    glDeleteRenderbuffers(1, &m_ColorRBOID);
+    glDeleteRenderbuffers(1, &m_DepthRBOID);
+
+    destroyContext();
+}
+
+void HeadlessRenderer::endFrame() {
+    int slot = m_nFrameCount % PBO_COUNT;
+
+    // Le PBO va être réutilisé: la frame qu'il contient doit être récupérée
+    if (m_nFrameCount >= PBO_COUNT) {
+        collectFrame(m_nFrameCount - PBO_COUNT);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_FBOID);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PBOIDs[slot]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_nWidth, m_nHeight, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_PBOFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    ++m_nFrameCount;
+}
+
+void HeadlessRenderer::collectFrame(uint32_t index) {
+    int slot = index % PBO_COUNT;
+
+    if (m_PBOFences[slot]) {
+        while (glClientWaitSync(m_PBOFences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(m_PBOFences[slot]);
+        m_PBOFences[slot] = 0;
+    }
+
+    Frame frame;
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        // Le thread d'encodage est en retard: on l'attend plutôt que d'accumuler des images
+        m_Condition.wait(lock, [this]() { return m_PendingFrames.size() < MAX_PENDING_FRAMES; });
+        if (!m_FreeFrames.empty()) {
+            frame = std::move(m_FreeFrames.back());
+            m_FreeFrames.pop_back();
+        }
+    }
+    frame.index = index;
+    frame.pixels.resize(m_nWidth * m_nHeight * 4);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PBOIDs[slot]);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame.pixels.size(), GL_MAP_READ_BIT);
+    if (data) {
+        std::memcpy(frame.pixels.data(), data, frame.pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_PendingFrames.push_back(std::move(frame));
+    }
+    m_Condition.notify_all();
+}
+
+void HeadlessRenderer::encoderLoop() {
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_bStop || !m_PendingFrames.empty(); });
+            if (m_PendingFrames.empty())
+                return;
+
+            frame = std::move(m_PendingFrames.front());
+            m_PendingFrames.pop_front();
+        }
+        m_Condition.notify_all();
+
+        writeFrame(frame);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_FreeFrames.push_back(std::move(frame));
+    }
+}
+
+void HeadlessRenderer::writeFrame(const Frame& frame) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/frame_%05u.ppm", frame.index);
+    std::string path = m_OutputDirectory + name;
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::fprintf(stderr, "Unable to write %s\n", path.c_str());
+        return;
+    }
+    std::fprintf(file, "P6\n%u %u\n255\n", m_nWidth, m_nHeight);
+
+    // RGBA vers RGB, en retournant l'image (l'origine OpenGL est en bas à gauche)
+    std::vector<uint8_t> row(m_nWidth * 3);
+    for (uint32_t y = 0; y < m_nHeight; ++y) {
+        const uint8_t* src = frame.pixels.data() + (m_nHeight - 1 - y) * m_nWidth * 4;
+        for (uint32_t x = 0; x < m_nWidth; ++x) {
+            row[3 * x] = src[4 * x];
+            row[3 * x + 1] = src[4 * x + 1];
+            row[3 * x + 2] = src[4 * x + 2];
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+    std::fclose(file);
+}
+
+#ifdef PARTYKEL_HAS_EGL
+
+void HeadlessRenderer::createContext() {
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    // Plateforme surfaceless de Mesa: aucun serveur d'affichage n'est nécessaire
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        throw std::runtime_error("Unable to initialize EGL");
+    }
+    m_pDisplay = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        throw std::runtime_error("Unable to bind the OpenGL API with EGL");
+    }
+
+    // Profil compatibilité (utilisé par AntTweakBar) si possible, core sinon
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLint profiles[] = { EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT };
+    for (EGLint profile : profiles) {
+        EGLint attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, profile,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+        if (context != EGL_NO_CONTEXT)
+            break;
+    }
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        throw std::runtime_error("Unable to create a surfaceless OpenGL 3.3 context");
+    }
+    m_pContext = context;
+
+    glewExperimental = GL_TRUE;
+    GLenum error = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLEW compilé pour GLX échoue sur l'initialisation de GLX, sans conséquence ici
+    if (error == GLEW_ERROR_NO_GLX_DISPLAY) {
+        error = GLEW_OK;
+    }
+#endif
+    if (error != GLEW_OK) {
+        throw std::runtime_error("Unable to init GLEW: " + std::string((const char*) glewGetErrorString(error)));
+    }
+    glGetError(); // glewInit peut laisser une erreur GL_INVALID_ENUM
+}
+
+void HeadlessRenderer::destroyContext() {
+    eglMakeCurrent(m_pDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(m_pDisplay, m_pContext);
+    eglTerminate(m_pDisplay);
+}
+
+#else
+
+void HeadlessRenderer::createContext() {
+    throw std::runtime_error("Headless rendering requires EGL");
+}
+
+void HeadlessRenderer::destroyContext() {
+}
+
+#endif
+
+}
@@ -0,0 +1,281 @@
+#include "PartyKel/MeshCloth.hpp"
+#include "PartyKel/Forces.hpp"
+#include "PartyKel/renderer/Sphere.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
+
+namespace PartyKel {
+
+static const uint32_t UNUSED_VERTEX = 0xFFFFFFFF;
+
+// Deux arêtes consécutives sont considérées alignées si l'angle entre elles est inférieur à environ 25 degrés
+static const float BEND_ALIGNMENT = 0.9f;
+
+// Intercale les bits de x, y et z (10 bits chacun) pour former un code de Morton sur 30 bits
+static uint32_t mortonCode(uint32_t x, uint32_t y, uint32_t z) {
+    auto spread = [](uint32_t v) {
+        v = (v | (v << 16)) & 0x030000FF;
+        v = (v | (v << 8)) & 0x0300F00F;
+        v = (v | (v << 4)) & 0x030C30C3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1) | (spread(z) << 2);
+}
+
+static inline uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+static void sortSprings(std::vector<Spring>& springs) {
+    std::sort(springs.begin(), springs.end(), [](const Spring& s1, const Spring& s2) {
+        return edgeKey(s1.a, s1.b) < edgeKey(s2.a, s2.b);
+    });
+}
+
+MeshCloth::MeshCloth(const TriangleMesh& mesh, float particleMass) {
+    reorderVertices(mesh);
+    if (indexArray.empty()) {
+        throw std::runtime_error("Cloth mesh has no valid triangle");
+    }
+
+    nbParticles = positionArray.size();
+    velocityArray.assign(nbParticles, glm::vec3(0.f));
+    massArray.assign(nbParticles, particleMass);
+    forceArray.assign(nbParticles, glm::vec3(0.f));
+    fixedArray.assign(nbParticles, 0);
+
+    buildSprings();
+
+    // Mêmes paramètres par défaut que le drapeau
+    K0 = 1;
+    K1 = 1;
+    K2 = 1;
+
+    V0 = 0.08;
+    V1 = 0.02;
+    V2 = 0.06;
+}
+
+void MeshCloth::reorderVertices(const TriangleMesh& mesh) {
+    uint32_t vertexCount = mesh.getVertexCount();
+
+    // Seuls les sommets d'au moins un triangle non dégénéré deviennent des particules
+    std::vector<uint32_t> triangles;
+    triangles.reserve(mesh.indices.size());
+    std::vector<uint8_t> used(vertexCount, 0);
+    for (uint32_t t = 0; t < mesh.getTriangleCount(); ++t) {
+        uint32_t a = mesh.indices[3 * t], b = mesh.indices[3 * t + 1], c = mesh.indices[3 * t + 2];
+        if (a >= vertexCount || b >= vertexCount || c >= vertexCount) {
+            throw std::out_of_range("Cloth mesh triangle references a missing vertex");
+        }
+        if (a == b || b == c || a == c)
+            continue;
+        triangles.insert(triangles.end(), { a, b, c });
+        used[a] = used[b] = used[c] = 1;
+    }
+
+    std::vector<uint32_t> order;
+    glm::vec3 minPosition(std::numeric_limits<float>::max()), maxPosition(-std::numeric_limits<float>::max());
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        if (!used[v])
+            continue;
+        order.push_back(v);
+        minPosition = glm::min(minPosition, mesh.positions[v]);
+        maxPosition = glm::max(maxPosition, mesh.positions[v]);
+    }
+
+    // Tri des sommets selon le code de Morton de leur position quantifiée sur 10 bits par axe
+    glm::vec3 scale = 1023.f / glm::max(maxPosition - minPosition, glm::vec3(0.000001f));
+    std::vector<uint32_t> codes(vertexCount, 0);
+    for (uint32_t v : order) {
+        glm::vec3 q = glm::clamp((mesh.positions[v] - minPosition) * scale, glm::vec3(0.f), glm::vec3(1023.f));
+        codes[v] = mortonCode(uint32_t(q.x), uint32_t(q.y), uint32_t(q.z));
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t v1, uint32_t v2) {
+        return codes[v1] < codes[v2];
+    });
+
+    vertexRemap.assign(vertexCount, UNUSED_VERTEX);
+    positionArray.resize(order.size());
+    for (uint32_t k = 0; k < order.size(); ++k) {
+        vertexRemap[order[k]] = k;
+        positionArray[k] = mesh.positions[order[k]];
+    }
+
+    // Les triangles sont triés par leur plus petit indice: leurs sommets sont lus dans l'ordre de la mémoire
+    for (uint32_t& v : triangles)
+        v = vertexRemap[v];
+
+    uint32_t triangleCount = triangles.size() / 3;
+    std::vector<uint32_t> triangleOrder(triangleCount);
+    std::iota(triangleOrder.begin(), triangleOrder.end(), 0);
+    auto minIndex = [&](uint32_t t) {
+        return std::min(triangles[3 * t], std::min(triangles[3 * t + 1], triangles[3 * t + 2]));
+    };
+    std::stable_sort(triangleOrder.begin(), triangleOrder.end(), [&](uint32_t t1, uint32_t t2) {
+        return minIndex(t1) < minIndex(t2);
+    });
+
+    indexArray.resize(triangles.size());
+    for (uint32_t k = 0; k < triangleCount; ++k) {
+        std::copy(triangles.begin() + 3 * triangleOrder[k], triangles.begin() + 3 * triangleOrder[k] + 3, indexArray.begin() + 3 * k);
+    }
+}
+
+void MeshCloth::buildSprings() {
+    auto makeSpring = [&](uint32_t a, uint32_t b) {
+        Spring spring;
+        spring.a = std::min(a, b);
+        spring.b = std::max(a, b);
+        spring.restLength = glm::distance(positionArray[a], positionArray[b]);
+        return spring;
+    };
+
+    // Chaque arête de chaque triangle, avec le sommet opposé du triangle
+    struct HalfEdge {
+        uint64_t key;
+        uint32_t opposite;
+    };
+    std::vector<HalfEdge> halfEdges;
+    halfEdges.reserve(indexArray.size());
+    for (size_t t = 0; t < indexArray.size(); t += 3) {
+        for (int e = 0; e < 3; ++e) {
+            uint32_t a = indexArray[t + e], b = indexArray[t + (e + 1) % 3], c = indexArray[t + (e + 2) % 3];
+            halfEdges.push_back({ edgeKey(a, b), c });
+        }
+    }
+    std::sort(halfEdges.begin(), halfEdges.end(), [](const HalfEdge& e1, const HalfEdge& e2) {
+        return e1.key < e2.key || (e1.key == e2.key && e1.opposite < e2.opposite);
+    });
+
+    // Structure: une arête par groupe de demi-arêtes de même clé.
+    // Cisaillement: sommets opposés d'une arête partagée par exactement deux triangles (les arêtes non
+    // manifold, partagées par plus de deux triangles, n'ont pas de quadrilatère bien défini)
+    std::vector<uint64_t> edgeKeys;
+    for (size_t begin = 0; begin < halfEdges.size(); ) {
+        size_t end = begin + 1;
+        while (end < halfEdges.size() && halfEdges[end].key == halfEdges[begin].key)
+            ++end;
+
+        uint64_t key = halfEdges[begin].key;
+        edgeKeys.push_back(key);
+        structuralSprings.push_back(makeSpring(uint32_t(key >> 32), uint32_t(key)));
+
+        if (end - begin == 2 && halfEdges[begin].opposite != halfEdges[begin + 1].opposite)
+            shearSprings.push_back(makeSpring(halfEdges[begin].opposite, halfEdges[begin + 1].opposite));
+
+        begin = end;
+    }
+
+    auto isEdge = [&](uint32_t a, uint32_t b) {
+        return std::binary_search(edgeKeys.begin(), edgeKeys.end(), edgeKey(a, b));
+    };
+    auto removeDuplicates = [&](std::vector<Spring>& springs) {
+        sortSprings(springs);
+        springs.erase(std::unique(springs.begin(), springs.end(), [](const Spring& s1, const Spring& s2) {
+            return s1.a == s2.a && s1.b == s2.b;
+        }), springs.end());
+    };
+
+    // Deux triangles voisins peuvent déjà être reliés par une arête entre leurs sommets opposés
+    shearSprings.erase(std::remove_if(shearSprings.begin(), shearSprings.end(), [&](const Spring& s) {
+        return isEdge(s.a, s.b);
+    }), shearSprings.end());
+    removeDuplicates(shearSprings);
+
+    // Voisins de chaque sommet par les arêtes (format compressé)
+    std::vector<uint32_t> neighborOffsets(nbParticles + 1, 0), neighbors(2 * structuralSprings.size());
+    for (const Spring& s : structuralSprings) {
+        ++neighborOffsets[s.a + 1];
+        ++neighborOffsets[s.b + 1];
+    }
+    for (int v = 0; v < nbParticles; ++v)
+        neighborOffsets[v + 1] += neighborOffsets[v];
+    std::vector<uint32_t> cursor(neighborOffsets.begin(), neighborOffsets.end() - 1);
+    for (const Spring& s : structuralSprings) {
+        neighbors[cursor[s.a]++] = s.b;
+        neighbors[cursor[s.b]++] = s.a;
+    }
+
+    // Courbure: pour chaque arête (a, v), l'arête (v, b) qui la prolonge le mieux
+    for (int v = 0; v < nbParticles; ++v) {
+        for (uint32_t i = neighborOffsets[v]; i < neighborOffsets[v + 1]; ++i) {
+            uint32_t a = neighbors[i];
+            glm::vec3 incoming = glm::normalize(positionArray[v] - positionArray[a]);
+
+            uint32_t best = UNUSED_VERTEX;
+            float bestAlignment = BEND_ALIGNMENT;
+            for (uint32_t j = neighborOffsets[v]; j < neighborOffsets[v + 1]; ++j) {
+                uint32_t b = neighbors[j];
+                if (b == a)
+                    continue;
+                float alignment = glm::dot(incoming, glm::normalize(positionArray[b] - positionArray[v]));
+                if (alignment > bestAlignment) {
+                    bestAlignment = alignment;
+                    best = b;
+                }
+            }
+
+            if (best != UNUSED_VERTEX && !isEdge(a, best))
+                bendSprings.push_back(makeSpring(a, best));
+        }
+    }
+    removeDuplicates(bendSprings);
+}
+
+void MeshCloth::fixAbove(float y) {
+    for (int i = 0; i < nbParticles; ++i) {
+        fixedArray[i] = positionArray[i].y >= y;
+    }
+}
+
+void MeshCloth::applySprings(const std::vector<Spring>& springs, float K, float V, float dt) {
+    for (const Spring& s : springs) {
+        glm::vec3 F = hookForce(K, s.restLength, positionArray[s.a], positionArray[s.b]) +
+                      brakeForce(V, dt, velocityArray[s.a], velocityArray[s.b]);
+        forceArray[s.a] += F;
+        forceArray[s.b] -= F;
+    }
+}
+
+void MeshCloth::applyInternalForces(float dt) {
+    applySprings(structuralSprings, K0, V0, dt);
+    applySprings(shearSprings, K1, V1, dt);
+    applySprings(bendSprings, K2, V2, dt);
+}
+
+void MeshCloth::applyExternalForce(const glm::vec3& F) {
+    for (int i = 0; i < nbParticles; ++i) {
+        if (fixedArray[i]) continue;
+        forceArray[i] += F;
+    }
+}
+
+void MeshCloth::applySphereCollision(const SphereHandler& sphereHandler, float multiplier, float radiusDelta) {
+    for (int i = 0; i < nbParticles; ++i) {
+        if (fixedArray[i]) continue;
+
+        for (size_t j = 0; j < sphereHandler.positions.size(); ++j) {
+            float dist = glm::distance(sphereHandler.positions[j], positionArray[i]);
+            if (dist < sphereHandler.radius[j] + radiusDelta) {
+                forceArray[i] += sphereCollisionForce(dist, sphereHandler.positions[j], positionArray[i]) * multiplier;
+            }
+        }
+    }
+}
+
+void MeshCloth::update(float dt) {
+    for (int i = 0; i < nbParticles; ++i) {
+        if (!fixedArray[i]) {
+            velocityArray[i] += dt * (forceArray[i]/massArray[i]);
+            positionArray[i] += dt * velocityArray[i];
+        }
+        forceArray[i] = glm::vec3(0);
+    }
+}
+
+}
@@ -0,0 +1,221 @@
+#include "PartyKel/MeshSequenceExporter.hpp"
+
+#include <sys/stat.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace PartyKel {
+
+// Les fichiers PLY binaires sont déclarés little endian: les données sont écrites dans l'ordre de la machine
+static const char* PLY_FORMAT = "binary_little_endian";
+
+MeshSequenceExporter::MeshSequenceExporter(const std::string& outputDirectory, uint32_t vertexCount,
+                                           const std::vector<uint32_t>& triangleIndices, const glm::vec3* referencePositions,
+                                           Format format, uint32_t bufferCount, Backpressure backpressure, bool embedTopology):
+    m_OutputDirectory(outputDirectory), m_nVertexCount(vertexCount),
+    m_nTriangleCount(uint32_t(triangleIndices.size() / 3)), m_Format(format),
+    m_Backpressure(backpressure), m_bEmbedTopology(embedTopology),
+    m_Frames(bufferCount ? bufferCount : 1), m_pWritingFrame(nullptr), m_nNextIndex(0), m_bStop(false) {
+
+    if (::mkdir(m_OutputDirectory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Unable to create output directory " + m_OutputDirectory);
+    }
+
+    std::memset(&m_Stats, 0, sizeof(m_Stats));
+
+    // Sérialisation unique de la topologie
+    if (m_Format == Format::BinaryPLY) {
+        m_Topology.resize(size_t(m_nTriangleCount) * (1 + 3 * sizeof(int32_t)));
+        char* dst = m_Topology.data();
+        for (uint32_t t = 0; t < m_nTriangleCount; ++t) {
+            *dst++ = 3;
+            for (int v = 0; v < 3; ++v) {
+                int32_t index = int32_t(triangleIndices[3 * t + v]);
+                std::memcpy(dst, &index, sizeof(index));
+                dst += sizeof(index);
+            }
+        }
+    } else {
+        char line[64];
+        for (uint32_t t = 0; t < m_nTriangleCount; ++t) {
+            // Les indices OBJ commencent à 1
+            int length = std::snprintf(line, sizeof(line), "f %u %u %u\n", triangleIndices[3 * t] + 1,
+                                       triangleIndices[3 * t + 1] + 1, triangleIndices[3 * t + 2] + 1);
+            m_Topology.insert(m_Topology.end(), line, line + length);
+        }
+    }
+
+    if (!m_bEmbedTopology) {
+        writeTopology(referencePositions);
+    }
+
+    // Tampons préalloués: aucune allocation par frame
+    for (auto& frame : m_Frames) {
+        frame.positions.resize(m_nVertexCount);
+        m_FreeFrames.push_back(&frame);
+    }
+    m_VertexBuffer.reserve(m_Format == Format::BinaryPLY ? m_nVertexCount * sizeof(glm::vec3) : m_nVertexCount * 48);
+
+    m_WriterThread = std::thread(&MeshSequenceExporter::writerLoop, this);
+}
+
+MeshSequenceExporter::~MeshSequenceExporter() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_bStop = true;
+    }
+    m_Condition.notify_all();
+    m_WriterThread.join();
+}
+
+bool MeshSequenceExporter::submit(const glm::vec3* positionArray) {
+    Frame* frame = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        uint32_t index = m_nNextIndex++;
+
+        if (m_FreeFrames.empty()) {
+            if (m_Backpressure == Backpressure::Drop) {
+                ++m_Stats.droppedFrames;
+                return false;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            m_Condition.wait(lock, [this]() { return !m_FreeFrames.empty(); });
+            m_Stats.blockedMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        frame = m_FreeFrames.back();
+        m_FreeFrames.pop_back();
+        frame->index = index;
+    }
+
+    std::copy(positionArray, positionArray + m_nVertexCount, frame->positions.begin());
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_PendingFrames.push_back(frame);
+        ++m_Stats.submittedFrames;
+        m_Stats.maxPendingFrames = std::max(m_Stats.maxPendingFrames, uint32_t(m_PendingFrames.size()));
+    }
+    m_Condition.notify_all();
+    return true;
+}
+
+void MeshSequenceExporter::flush() {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Condition.wait(lock, [this]() { return m_PendingFrames.empty() && !m_pWritingFrame; });
+}
+
+MeshSequenceExporter::Stats MeshSequenceExporter::getStats() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Stats stats = m_Stats;
+    stats.pendingFrames = uint32_t(m_PendingFrames.size()) + (m_pWritingFrame ? 1 : 0);
+    return stats;
+}
+
+bool MeshSequenceExporter::isFallingBehind() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats.droppedFrames > 0 || m_Stats.blockedMilliseconds > 0.;
+}
+
+void MeshSequenceExporter::writerLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_bStop || !m_PendingFrames.empty(); });
+            if (m_PendingFrames.empty())
+                return;
+
+            m_pWritingFrame = m_PendingFrames.front();
+            m_PendingFrames.pop_front();
+        }
+
+        writeFrame(*m_pWritingFrame);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_FreeFrames.push_back(m_pWritingFrame);
+            m_pWritingFrame = nullptr;
+        }
+        m_Condition.notify_all();
+    }
+}
+
+void MeshSequenceExporter::writeFrame(const Frame& frame) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/frame_%05u.%s", frame.index, m_Format == Format::BinaryPLY ? "ply" : "obj");
+    std::string path = m_OutputDirectory + name;
+
+    bool failed = false;
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file) {
+        uint32_t triangleCount = m_bEmbedTopology ? m_nTriangleCount : 0;
+        m_VertexBuffer.clear();
+
+        if (m_Format == Format::BinaryPLY) {
+            std::fprintf(file, "ply\nformat %s 1.0\nelement vertex %u\n"
+                               "property float x\nproperty float y\nproperty float z\n"
+                               "element face %u\nproperty list uchar int vertex_indices\nend_header\n",
+                         PLY_FORMAT, m_nVertexCount, triangleCount);
+            const char* vertices = reinterpret_cast<const char*>(glm::value_ptr(frame.positions[0]));
+            failed |= std::fwrite(vertices, sizeof(glm::vec3), m_nVertexCount, file) != m_nVertexCount;
+        } else {
+            std::fprintf(file, "# frame %u\n", frame.index);
+            char line[64];
+            for (const auto& p : frame.positions) {
+                int length = std::snprintf(line, sizeof(line), "v %.6g %.6g %.6g\n", p.x, p.y, p.z);
+                m_VertexBuffer.insert(m_VertexBuffer.end(), line, line + length);
+            }
+            failed |= std::fwrite(m_VertexBuffer.data(), 1, m_VertexBuffer.size(), file) != m_VertexBuffer.size();
+        }
+
+        if (triangleCount) {
+            failed |= std::fwrite(m_Topology.data(), 1, m_Topology.size(), file) != m_Topology.size();
+        }
+        failed |= std::fclose(file) != 0;
+    } else {
+        failed = true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (failed) {
+        ++m_Stats.failedFrames;
+    } else {
+        ++m_Stats.writtenFrames;
+    }
+}
+
+void MeshSequenceExporter::writeTopology(const glm::vec3* referencePositions) {
+    std::string path = m_OutputDirectory + (m_Format == Format::BinaryPLY ? "/topology.ply" : "/topology.obj");
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Unable to write " + path);
+    }
+
+    // Maillage complet, lisible seul: sommets de référence puis faces. Les frames remplacent les sommets
+    bool failed = false;
+    if (m_Format == Format::BinaryPLY) {
+        std::fprintf(file, "ply\nformat %s 1.0\nelement vertex %u\n"
+                           "property float x\nproperty float y\nproperty float z\n"
+                           "element face %u\nproperty list uchar int vertex_indices\nend_header\n",
+                     PLY_FORMAT, m_nVertexCount, m_nTriangleCount);
+        failed |= std::fwrite(glm::value_ptr(referencePositions[0]), sizeof(glm::vec3), m_nVertexCount, file) != m_nVertexCount;
+    } else {
+        std::fprintf(file, "# reference pose, frame_*.obj give the vertices of each frame\n");
+        for (uint32_t v = 0; v < m_nVertexCount; ++v) {
+            const glm::vec3& p = referencePositions[v];
+            std::fprintf(file, "v %.6g %.6g %.6g\n", p.x, p.y, p.z);
+        }
+    }
+    failed |= std::fwrite(m_Topology.data(), 1, m_Topology.size(), file) != m_Topology.size();
+    failed |= std::fclose(file) != 0;
+    if (failed) {
+        throw std::runtime_error("Unable to write " + path);
+    }
+}
+
+}
@@ -0,0 +1,104 @@
+#include "PartyKel/PerfCounters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#include <algorithm>
+#include <cstring>
+
+namespace PartyKel {
+
+#ifdef __linux__
+
+static const uint64_t COUNTER_CONFIGS[HARDWARE_COUNTER_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+PerfCounters::PerfCounters():
+    m_nGroupFd(-1) {
+    std::fill(m_Fds, m_Fds + HARDWARE_COUNTER_COUNT, -1);
+
+    for (int counter = 0; counter < HARDWARE_COUNTER_COUNT; ++counter) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = COUNTER_CONFIGS[counter];
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // Le groupe est démarré une fois tous ses compteurs créés
+        attr.disabled = counter == 0;
+
+        // Thread appelant (pid 0), sur n'importe quel processeur
+        int fd = syscall(__NR_perf_event_open, &attr, 0, -1, counter == 0 ? -1 : m_Fds[0], 0);
+        if (fd < 0) {
+            m_Error = std::string("perf_event_open failed for ") + getCounterName(HardwareCounter(counter)) + ": " + std::strerror(errno);
+            for (int k = 0; k < counter; ++k)
+                ::close(m_Fds[k]);
+            std::fill(m_Fds, m_Fds + HARDWARE_COUNTER_COUNT, -1);
+            return;
+        }
+        m_Fds[counter] = fd;
+    }
+
+    ioctl(m_Fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(m_Fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    m_nGroupFd = m_Fds[0];
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : m_Fds) {
+        if (fd >= 0)
+            ::close(fd);
+    }
+}
+
+bool PerfCounters::read(uint64_t values[HARDWARE_COUNTER_COUNT]) const {
+    if (m_nGroupFd < 0)
+        return false;
+
+    // Format PERF_FORMAT_GROUP: nombre de compteurs, temps activé, temps compté, puis les valeurs
+    uint64_t data[3 + HARDWARE_COUNTER_COUNT];
+    if (::read(m_nGroupFd, data, sizeof(data)) != ssize_t(sizeof(data)) || data[0] != HARDWARE_COUNTER_COUNT)
+        return false;
+
+    // Lorsque le processeur a trop peu de compteurs, le groupe n'est compté qu'une partie du temps
+    uint64_t enabled = data[1], running = data[2];
+    for (int counter = 0; counter < HARDWARE_COUNTER_COUNT; ++counter) {
+        values[counter] = running && running < enabled ? uint64_t(double(data[3 + counter]) * enabled / running) : data[3 + counter];
+    }
+    return true;
+}
+
+#else
+
+PerfCounters::PerfCounters():
+    m_nGroupFd(-1), m_Error("Hardware counters are only supported on Linux") {
+    std::fill(m_Fds, m_Fds + HARDWARE_COUNTER_COUNT, -1);
+}
+
+PerfCounters::~PerfCounters() {
+}
+
+bool PerfCounters::read(uint64_t*) const {
+    return false;
+}
+
+#endif
+
+const char* PerfCounters::getCounterName(HardwareCounter counter) {
+    static const char* NAMES[HARDWARE_COUNTER_COUNT] = {
+        "cycles", "instructions", "LLC misses", "branch misses"
+    };
+    return NAMES[counter];
+}
+
+}
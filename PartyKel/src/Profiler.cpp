@@ -0,0 +1,126 @@
+#include "PartyKel/Profiler.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+namespace PartyKel {
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void addProfileCount(ProfileCounter counter, uint64_t count) {
+    Profiler::instance().addCount(counter, count);
+}
+
+Profiler::Profiler():
+    m_nHistoryCount(0), m_nHistoryIndex(0), m_nParticleCount(0), m_FrameStart(std::chrono::steady_clock::now()) {
+    for (auto& time : m_CurrentTimes)
+        time.store(0, std::memory_order_relaxed);
+    for (auto& counter : m_CurrentCounters)
+        counter.store(0, std::memory_order_relaxed);
+    std::memset(m_LastCounters, 0, sizeof(m_LastCounters));
+    std::memset(m_History, 0, sizeof(m_History));
+    std::memset(m_CurrentHardwareCounts, 0, sizeof(m_CurrentHardwareCounts));
+    std::memset(m_HardwareHistory, 0, sizeof(m_HardwareHistory));
+}
+
+bool Profiler::enableHardwareCounters(std::string& error) {
+    if (m_pPerfCounters)
+        return true;
+
+    std::unique_ptr<PerfCounters> counters(new PerfCounters);
+    uint64_t values[HARDWARE_COUNTER_COUNT];
+    if (!counters->isOpen() || !counters->read(values)) {
+        error = counters->isOpen() ? "Unable to read hardware counters" : counters->getError();
+        return false;
+    }
+    m_pPerfCounters = std::move(counters);
+    m_HardwareThread = std::this_thread::get_id();
+    return true;
+}
+
+void Profiler::endFrame() {
+    auto frameEnd = std::chrono::steady_clock::now();
+    Tracer& tracer = Tracer::instance();
+    if (tracer.isRecording())
+        tracer.record("Frame", "frame", m_FrameStart, frameEnd);
+    m_FrameStart = frameEnd;
+
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase) {
+        m_History[phase][m_nHistoryIndex] = m_CurrentTimes[phase].exchange(0, std::memory_order_relaxed);
+
+        for (int counter = 0; counter < HARDWARE_COUNTER_COUNT; ++counter) {
+            m_HardwareHistory[phase][counter][m_nHistoryIndex] = m_CurrentHardwareCounts[phase][counter];
+            m_CurrentHardwareCounts[phase][counter] = 0;
+        }
+    }
+    m_nHistoryIndex = (m_nHistoryIndex + 1) % HISTORY_SIZE;
+    m_nHistoryCount = std::min(m_nHistoryCount + 1, int(HISTORY_SIZE));
+
+    for (int counter = 0; counter < PROFILE_COUNTER_COUNT; ++counter)
+        m_LastCounters[counter] = m_CurrentCounters[counter].exchange(0, std::memory_order_relaxed);
+}
+
+Profiler::Stats Profiler::getStats(ProfilePhase phase) const {
+    Stats stats = { 0.f, 0.f, 0.f };
+    if (!m_nHistoryCount)
+        return stats;
+
+    // Les frames sont dans l'ordre du tampon circulaire: l'ordre n'importe pas pour ces statistiques
+    uint64_t times[HISTORY_SIZE];
+    std::copy(m_History[phase], m_History[phase] + m_nHistoryCount, times);
+
+    uint64_t sum = 0;
+    for (int k = 0; k < m_nHistoryCount; ++k)
+        sum += times[k];
+
+    int p99 = std::min(m_nHistoryCount - 1, (99 * m_nHistoryCount) / 100);
+    std::nth_element(times, times + p99, times + m_nHistoryCount);
+
+    stats.min = *std::min_element(times, times + m_nHistoryCount) * 1e-6f;
+    stats.avg = float(sum) / m_nHistoryCount * 1e-6f;
+    stats.p99 = times[p99] * 1e-6f;
+    return stats;
+}
+
+Profiler::HardwareStats Profiler::getHardwareStats(ProfilePhase phase) const {
+    HardwareStats stats = { 0.f, 0.f, 0.f };
+    if (!m_nHistoryCount)
+        return stats;
+
+    // Sommes sur l'historique: l'IPC est pondéré par la durée de chaque frame
+    uint64_t sums[HARDWARE_COUNTER_COUNT];
+    for (int counter = 0; counter < HARDWARE_COUNTER_COUNT; ++counter) {
+        const uint64_t* history = m_HardwareHistory[phase][counter];
+        sums[counter] = std::accumulate(history, history + m_nHistoryCount, uint64_t(0));
+    }
+
+    if (sums[HARDWARE_CYCLES])
+        stats.ipc = float(double(sums[HARDWARE_INSTRUCTIONS]) / sums[HARDWARE_CYCLES]);
+    if (m_nParticleCount) {
+        double particleFrames = double(m_nHistoryCount) * m_nParticleCount;
+        stats.cacheMissesPerParticle = float(sums[HARDWARE_CACHE_MISSES] / particleFrames);
+        stats.branchMissesPerParticle = float(sums[HARDWARE_BRANCH_MISSES] / particleFrames);
+    }
+    return stats;
+}
+
+const char* Profiler::getPhaseName(ProfilePhase phase) {
+    static const char* NAMES[PROFILE_PHASE_COUNT] = {
+        "External forces", "Internal forces", "Sphere collision", "Octree build", "Repulsion",
+        "Contacts", "Integration", "Normals", "Upload", "GUI"
+    };
+    return NAMES[phase];
+}
+
+const char* Profiler::getCounterName(ProfileCounter counter) {
+    static const char* NAMES[PROFILE_COUNTER_COUNT] = {
+        "Springs evaluated", "Contacts found", "Octree nodes allocated", "Step heap allocations"
+    };
+    return NAMES[counter];
+}
+
+}
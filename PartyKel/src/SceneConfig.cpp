@@ -0,0 +1,269 @@
+#include "PartyKel/SceneConfig.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <limits>
+
+namespace PartyKel {
+
+namespace {
+
+struct FloatKey { const char* name; float SceneConfig::* member; };
+struct IntKey { const char* name; int SceneConfig::* member; };
+struct BoolKey { const char* name; bool SceneConfig::* member; };
+struct Vec2Key { const char* name; glm::vec2 SceneConfig::* member; };
+struct IVec2Key { const char* name; glm::ivec2 SceneConfig::* member; };
+struct Vec3Key { const char* name; glm::vec3 SceneConfig::* member; };
+
+const FloatKey FLOAT_KEYS[] = {
+    { "mass", &SceneConfig::mass },
+    { "K0", &SceneConfig::K0 }, { "K1", &SceneConfig::K1 }, { "K2", &SceneConfig::K2 },
+    { "V0", &SceneConfig::V0 }, { "V1", &SceneConfig::V1 }, { "V2", &SceneConfig::V2 },
+    { "windVelocity", &SceneConfig::windVelocity },
+    { "sphereCollisionMultiplier", &SceneConfig::sphereCollisionMultiplier },
+    { "radiusDelta", &SceneConfig::radiusDelta },
+    { "maxDstRepulseForce", &SceneConfig::maxDstRepulseForce },
+    { "multRepulseForce", &SceneConfig::multRepulseForce },
+    { "sleepThreshold", &SceneConfig::sleepThreshold },
+    { "wakeForceDelta", &SceneConfig::wakeForceDelta }
+};
+
+const IntKey INT_KEYS[] = {
+    { "octreeDepth", &SceneConfig::octreeDepth },
+    { "contactIterations", &SceneConfig::contactIterations },
+    { "seed", &SceneConfig::seed },
+    { "sleepFrames", &SceneConfig::sleepFrames }
+};
+
+const BoolKey BOOL_KEYS[] = {
+    { "activeSpheres", &SceneConfig::activeSpheres },
+    { "activeAutoCollisions", &SceneConfig::activeAutoCollisions },
+    { "activeContactSolver", &SceneConfig::activeContactSolver }
+};
+
+const Vec2Key VEC2_KEYS[] = {
+    { "size", &SceneConfig::size }
+};
+
+const IVec2Key IVEC2_KEYS[] = {
+    { "grid", &SceneConfig::grid }
+};
+
+const Vec3Key VEC3_KEYS[] = {
+    { "gravity", &SceneConfig::gravity },
+    { "octreeCenter", &SceneConfig::octreeCenter },
+    { "octreeSize", &SceneConfig::octreeSize }
+};
+
+template<typename Key, size_t N>
+const Key* findKey(const Key (&keys)[N], const char* name) {
+    for (const Key& key : keys) {
+        if (std::strcmp(key.name, name) == 0)
+            return &key;
+    }
+    return nullptr;
+}
+
+// Lit au plus maxCount nombres séparés par des espaces; renvoit le nombre de valeurs lues, -1 si la valeur est invalide
+int parseFloats(const char* value, float* result, int maxCount) {
+    int count = 0;
+    while (true) {
+        while (*value == ' ' || *value == '\t')
+            ++value;
+        if (!*value)
+            return count;
+        if (count == maxCount)
+            return -1;
+
+        char* end;
+        result[count++] = std::strtof(value, &end);
+        if (end == value)
+            return -1;
+        value = end;
+    }
+}
+
+// Comme parseFloats pour des entiers (strtoll): refuse les décimales, les exposants, les caractères collés
+// au nombre et les valeurs hors de l'intervalle d'un int, plutôt que de les arrondir
+int parseInts(const char* value, int* result, int maxCount) {
+    int count = 0;
+    while (true) {
+        while (*value == ' ' || *value == '\t')
+            ++value;
+        if (!*value)
+            return count;
+        if (count == maxCount)
+            return -1;
+
+        char* end;
+        errno = 0;
+        long long n = std::strtoll(value, &end, 10);
+        if (end == value || (*end && *end != ' ' && *end != '\t'))
+            return -1;
+        if (errno == ERANGE || n < std::numeric_limits<int>::min() || n > std::numeric_limits<int>::max())
+            return -1;
+        result[count++] = int(n);
+        value = end;
+    }
+}
+
+void trim(const char*& begin, const char*& end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+        ++begin;
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        --end;
+}
+
+}
+
+// Applique key = value; renvoit un message d'erreur, nullptr en cas de succès
+static const char* apply(SceneConfig& config, bool& defaultSpheres, const char* key, const char* value) {
+    float v[7];
+    int count = parseFloats(value, v, 7);
+
+    if (auto k = findKey(FLOAT_KEYS, key)) {
+        if (count != 1)
+            return "expected a number";
+        config.*(k->member) = v[0];
+    } else if (auto k = findKey(INT_KEYS, key)) {
+        int n;
+        if (parseInts(value, &n, 1) != 1)
+            return "expected an integer";
+        config.*(k->member) = n;
+    } else if (auto k = findKey(BOOL_KEYS, key)) {
+        if (std::strcmp(value, "true") == 0 || std::strcmp(value, "1") == 0)
+            config.*(k->member) = true;
+        else if (std::strcmp(value, "false") == 0 || std::strcmp(value, "0") == 0)
+            config.*(k->member) = false;
+        else
+            return "expected true or false";
+    } else if (auto k = findKey(VEC2_KEYS, key)) {
+        if (count != 2)
+            return "expected 2 numbers";
+        config.*(k->member) = glm::vec2(v[0], v[1]);
+    } else if (auto k = findKey(IVEC2_KEYS, key)) {
+        int n[2];
+        if (parseInts(value, n, 2) != 2 || n[0] < 2 || n[1] < 2)
+            return "expected 2 integers greater than 1";
+        config.*(k->member) = glm::ivec2(n[0], n[1]);
+    } else if (auto k = findKey(VEC3_KEYS, key)) {
+        if (count != 3)
+            return "expected 3 numbers";
+        config.*(k->member) = glm::vec3(v[0], v[1], v[2]);
+    } else if (std::strcmp(key, "sphere") == 0) {
+        if (count != 4 && count != 7)
+            return "expected a position, a radius and an optional color";
+        if (defaultSpheres) {
+            config.spherePositions.clear();
+            config.sphereRadius.clear();
+            config.sphereColors.clear();
+            defaultSpheres = false;
+        }
+        config.spherePositions.push_back(glm::vec3(v[0], v[1], v[2]));
+        config.sphereRadius.push_back(v[3]);
+        config.sphereColors.push_back(count == 7 ? glm::vec3(v[4], v[5], v[6]) : glm::vec3(1.f));
+    } else if (std::strcmp(key, "spheres") == 0) {
+        if (std::strcmp(value, "none") != 0)
+            return "expected none";
+        config.spherePositions.clear();
+        config.sphereRadius.clear();
+        config.sphereColors.clear();
+        defaultSpheres = false;
+    } else {
+        return "unknown key";
+    }
+    return nullptr;
+}
+
+void SceneConfig::loadFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open scene " + path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Unable to read scene " + path);
+    }
+    if (info.st_size == 0) {
+        ::close(fd);
+        return;
+    }
+
+    void* data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Unable to read scene " + path);
+    }
+
+    const char* text = static_cast<const char*>(data);
+    try {
+        parse(text, text + info.st_size, path);
+    } catch (...) {
+        ::munmap(data, info.st_size);
+        throw;
+    }
+    ::munmap(data, info.st_size);
+}
+
+void SceneConfig::parse(const char* begin, const char* end, const std::string& source) {
+    int lineNumber = 0;
+    const char* line = begin;
+    while (line < end) {
+        ++lineNumber;
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!lineEnd)
+            lineEnd = end;
+
+        const char* comment = static_cast<const char*>(std::memchr(line, '#', lineEnd - line));
+        const char* contentEnd = comment ? comment : lineEnd;
+        const char* equal = static_cast<const char*>(std::memchr(line, '=', contentEnd - line));
+
+        const char* keyBegin = line;
+        const char* keyEnd = equal ? equal : contentEnd;
+        trim(keyBegin, keyEnd);
+
+        if (keyBegin != keyEnd || equal) {
+            auto error = [&](const char* message) {
+                throw std::runtime_error(source + ":" + std::to_string(lineNumber) + ": " + message);
+            };
+            if (!equal || keyBegin == keyEnd)
+                error("expected key = value");
+
+            const char* valueBegin = equal + 1;
+            const char* valueEnd = contentEnd;
+            trim(valueBegin, valueEnd);
+
+            // Clés et valeurs sont courtes: copies dans des tampons locaux terminés par un zéro
+            char key[64], value[256];
+            if (size_t(keyEnd - keyBegin) >= sizeof(key) || size_t(valueEnd - valueBegin) >= sizeof(value))
+                error("line too long");
+            std::memcpy(key, keyBegin, keyEnd - keyBegin);
+            key[keyEnd - keyBegin] = 0;
+            std::memcpy(value, valueBegin, valueEnd - valueBegin);
+            value[valueEnd - valueBegin] = 0;
+
+            if (const char* message = apply(*this, m_bDefaultSpheres, key, value))
+                error((std::string(message) + " for " + key).c_str());
+        }
+
+        line = lineEnd + 1;
+    }
+}
+
+void SceneConfig::set(const std::string& assignment) {
+    parse(assignment.data(), assignment.data() + assignment.size(), "--set");
+}
+
+void SceneConfig::set(const std::string& key, const std::string& value) {
+    set(key + "=" + value);
+}
+
+}
@@ -0,0 +1,107 @@
+#include "PartyKel/SharedRing.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace PartyKel {
+
+SharedMemory::SharedMemory(const std::string& name, size_t size):
+    m_Name(name), m_pData(nullptr), m_nSize(size), m_bOwner(true) {
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        throw std::runtime_error("Unable to create shared memory " + name + ": " + std::strerror(errno));
+    if (::ftruncate(fd, size) != 0) {
+        int error = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("Unable to size shared memory " + name + ": " + std::strerror(error));
+    }
+    try {
+        map(fd, "create");
+    } catch (...) {
+        ::shm_unlink(name.c_str());
+        throw;
+    }
+}
+
+SharedMemory::SharedMemory(const std::string& name):
+    m_Name(name), m_pData(nullptr), m_nSize(0), m_bOwner(false) {
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0)
+        throw std::runtime_error("Unable to open shared memory " + name + ": " + std::strerror(errno));
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Unable to open shared memory " + name);
+    }
+    m_nSize = info.st_size;
+    map(fd, "open");
+}
+
+SharedMemory::~SharedMemory() {
+    ::munmap(m_pData, m_nSize);
+    if (m_bOwner)
+        ::shm_unlink(m_Name.c_str());
+}
+
+void SharedMemory::map(int fd, const char* action) {
+    void* data = ::mmap(nullptr, m_nSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+        throw std::runtime_error(std::string("Unable to ") + action + " shared memory " + m_Name + ": " + std::strerror(errno));
+    m_pData = data;
+}
+
+SharedRing::SharedRing(const std::string& name, size_t slotSize, unsigned int slotCount):
+    m_Memory(name, sizeof(Header) + slotSize * slotCount) {
+    if (!slotCount)
+        throw std::runtime_error("SharedRing " + name + " needs at least one slot");
+    // Le segment est rempli de zéros: les compteurs sont construits en place avant tout accès concurrent
+    m_pHeader = new (m_Memory.getData()) Header();
+    m_pHeader->written.store(0);
+    m_pHeader->read.store(0);
+    m_pHeader->slotSize = slotSize;
+    m_pHeader->slotCount = slotCount;
+    m_pSlots = static_cast<char*>(m_Memory.getData()) + sizeof(Header);
+}
+
+SharedRing::SharedRing(const std::string& name):
+    m_Memory(name) {
+    if (m_Memory.getSize() < sizeof(Header))
+        throw std::runtime_error("Shared memory " + name + " is not a SharedRing");
+    m_pHeader = static_cast<Header*>(m_Memory.getData());
+    if (m_pHeader->slotCount == 0 || m_Memory.getSize() < sizeof(Header) + m_pHeader->slotSize * m_pHeader->slotCount)
+        throw std::runtime_error("Shared memory " + name + " is not a SharedRing");
+    m_pSlots = static_cast<char*>(m_Memory.getData()) + sizeof(Header);
+}
+
+void* SharedRing::beginWrite() {
+    uint64_t written = m_pHeader->written.load(std::memory_order_relaxed);
+    while (written - m_pHeader->read.load(std::memory_order_acquire) >= m_pHeader->slotCount)
+        std::this_thread::yield();
+    return getSlot(written);
+}
+
+void SharedRing::endWrite() {
+    m_pHeader->written.fetch_add(1, std::memory_order_release);
+}
+
+const void* SharedRing::beginRead() {
+    uint64_t read = m_pHeader->read.load(std::memory_order_relaxed);
+    while (m_pHeader->written.load(std::memory_order_acquire) == read)
+        std::this_thread::yield();
+    return getSlot(read);
+}
+
+void SharedRing::endRead() {
+    m_pHeader->read.fetch_add(1, std::memory_order_release);
+}
+
+}
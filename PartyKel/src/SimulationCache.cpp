@@ -0,0 +1,368 @@
+#include "PartyKel/SimulationCache.hpp"
+#include "PartyKel/GridMesh.hpp"
+#include "PartyKel/VertexPacking.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace PartyKel {
+
+static const char SIMULATION_CACHE_MAGIC[4] = { 'P', 'K', 'S', 'C' };
+
+// Nombre maximal de frames en attente d'écriture avant de bloquer la simulation
+static const size_t MAX_PENDING_FRAMES = 16;
+
+// Codage zigzag: les petites valeurs négatives deviennent de petits entiers positifs
+static uint64_t zigzagEncode(int64_t value) {
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+static int64_t zigzagDecode(uint64_t value) {
+    return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+// Entier de longueur variable: 7 bits par octet, le bit de poids fort indique la présence d'un octet suivant
+static void writeVarint(std::vector<uint8_t>& buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    buffer.push_back(uint8_t(value));
+}
+
+static bool readVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && data < end; shift += 7) {
+        uint8_t byte = *data++;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static int32_t quantize(float value, float step) {
+    double q = std::floor(double(value) / step + 0.5);
+    if (!(q >= std::numeric_limits<int32_t>::min()))
+        return std::numeric_limits<int32_t>::min();
+    if (q > std::numeric_limits<int32_t>::max())
+        return std::numeric_limits<int32_t>::max();
+    return int32_t(q);
+}
+
+SimulationCacheWriter::SimulationCacheWriter(const std::string& path, uint32_t particleCount,
+                                             SimulationCacheEncoding encoding,
+                                             float quantizationStep, uint32_t keyframeInterval,
+                                             uint32_t normalGridWidth):
+    m_Path(path), m_pFile(std::fopen(path.c_str(), "wb")), m_nAppendedCount(0),
+    m_nOffset(0), m_bFailed(false), m_bStop(false) {
+
+    if (!m_pFile) {
+        throw std::runtime_error("Unable to open " + path + " for writing");
+    }
+    if (encoding == SimulationCacheEncoding::QuantizedDelta && (!(quantizationStep > 0.f) || keyframeInterval == 0)) {
+        std::fclose(m_pFile);
+        throw std::runtime_error("Invalid simulation cache quantization parameters");
+    }
+    if (normalGridWidth && (normalGridWidth < 2 || particleCount % normalGridWidth || particleCount / normalGridWidth < 2)) {
+        std::fclose(m_pFile);
+        throw std::runtime_error("Invalid simulation cache grid width");
+    }
+
+    std::memset(&m_Header, 0, sizeof(m_Header));
+    std::memcpy(m_Header.magic, SIMULATION_CACHE_MAGIC, 4);
+    m_Header.version = SIMULATION_CACHE_VERSION;
+    m_Header.encoding = uint32_t(encoding);
+    m_Header.particleCount = particleCount;
+    m_Header.quantizationStep = quantizationStep;
+    m_Header.keyframeInterval = keyframeInterval;
+    if (normalGridWidth) {
+        m_Header.flags = SIMULATION_CACHE_NORMALS;
+        m_Header.gridWidth = normalGridWidth;
+        m_FaceNormals.resize(2 * (normalGridWidth - 1) * (particleCount / normalGridWidth - 1));
+        m_Normals.resize(particleCount);
+    }
+
+    m_bFailed |= std::fwrite(&m_Header, sizeof(m_Header), 1, m_pFile) != 1;
+    m_nOffset = sizeof(m_Header);
+
+    m_IOThread = std::thread(&SimulationCacheWriter::ioLoop, this);
+}
+
+SimulationCacheWriter::~SimulationCacheWriter() {
+    try {
+        close();
+    } catch (const std::exception&) {
+    }
+}
+
+void SimulationCacheWriter::append(const glm::vec3* positionArray) {
+    std::vector<glm::vec3> buffer;
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        if (m_bStop) {
+            throw std::runtime_error("Simulation cache " + m_Path + " is closed");
+        }
+        // Le thread d'E/S est en retard: on l'attend plutôt que d'accumuler des frames
+        m_Condition.wait(lock, [this]() { return m_PendingFrames.size() < MAX_PENDING_FRAMES; });
+        if (!m_FreeBuffers.empty()) {
+            buffer = std::move(m_FreeBuffers.back());
+            m_FreeBuffers.pop_back();
+        }
+    }
+
+    buffer.assign(positionArray, positionArray + m_Header.particleCount);
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_PendingFrames.push_back(std::move(buffer));
+    }
+    m_Condition.notify_all();
+    ++m_nAppendedCount;
+}
+
+void SimulationCacheWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_bStop)
+            return;
+        m_bStop = true;
+    }
+    m_Condition.notify_all();
+    m_IOThread.join();
+
+    // La table d'index est alignée pour être lue directement dans le fichier projeté
+    static const uint8_t padding[alignof(SimulationCacheFrame)] = {};
+    size_t paddingSize = (alignof(SimulationCacheFrame) - m_nOffset % alignof(SimulationCacheFrame)) % alignof(SimulationCacheFrame);
+    m_bFailed |= std::fwrite(padding, 1, paddingSize, m_pFile) != paddingSize;
+    m_nOffset += paddingSize;
+
+    SimulationCacheFooter footer;
+    footer.tableOffset = m_nOffset;
+    footer.frameCount = uint32_t(m_Frames.size());
+    std::memcpy(footer.magic, SIMULATION_CACHE_MAGIC, 4);
+
+    if (!m_Frames.empty()) {
+        m_bFailed |= std::fwrite(m_Frames.data(), sizeof(SimulationCacheFrame), m_Frames.size(), m_pFile) != m_Frames.size();
+    }
+    m_bFailed |= std::fwrite(&footer, sizeof(footer), 1, m_pFile) != 1;
+    m_bFailed |= std::fclose(m_pFile) != 0;
+    m_pFile = nullptr;
+
+    if (m_bFailed) {
+        throw std::runtime_error("Unable to write simulation cache " + m_Path);
+    }
+}
+
+void SimulationCacheWriter::ioLoop() {
+    while (true) {
+        std::vector<glm::vec3> positions;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_bStop || !m_PendingFrames.empty(); });
+            if (m_PendingFrames.empty())
+                return;
+
+            positions = std::move(m_PendingFrames.front());
+            m_PendingFrames.pop_front();
+        }
+        m_Condition.notify_all();
+
+        writeFrame(positions);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_FreeBuffers.push_back(std::move(positions));
+    }
+}
+
+void SimulationCacheWriter::writeFrame(const std::vector<glm::vec3>& positions) {
+    SimulationCacheFrame frame = { m_nOffset, 0, 1 };
+
+    if (m_Header.encoding == uint32_t(SimulationCacheEncoding::Raw)) {
+        frame.size = uint32_t(positions.size() * sizeof(glm::vec3));
+        m_bFailed |= std::fwrite(positions.data(), sizeof(glm::vec3), positions.size(), m_pFile) != positions.size();
+    } else {
+        const float* values = glm::value_ptr(positions[0]);
+        size_t count = positions.size() * 3;
+
+        m_Quantized.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            m_Quantized[i] = quantize(values[i], m_Header.quantizationStep);
+        }
+
+        // Différence avec la frame précédente quantifiée: l'erreur de quantification ne s'accumule pas
+        frame.keyframe = m_Frames.size() % m_Header.keyframeInterval == 0;
+        m_Encoded.clear();
+        for (size_t i = 0; i < count; ++i) {
+            int64_t value = frame.keyframe ? m_Quantized[i] : int64_t(m_Quantized[i]) - m_PreviousQuantized[i];
+            writeVarint(m_Encoded, zigzagEncode(value));
+        }
+        std::swap(m_Quantized, m_PreviousQuantized);
+
+        frame.size = uint32_t(m_Encoded.size());
+        m_bFailed |= std::fwrite(m_Encoded.data(), 1, m_Encoded.size(), m_pFile) != m_Encoded.size();
+    }
+
+    if (m_Header.flags & SIMULATION_CACHE_NORMALS) {
+        int gridWidth = m_Header.gridWidth;
+        int gridHeight = m_Header.particleCount / gridWidth;
+        computeGridNormals(positions.data(), gridWidth, gridHeight, m_FaceNormals.data(), m_Normals.data());
+
+        m_Encoded.resize(m_Normals.size() * 2 * sizeof(int16_t));
+        int16_t* packed = reinterpret_cast<int16_t*>(m_Encoded.data());
+        for (size_t k = 0; k < m_Normals.size(); ++k) {
+            glm::vec2 n = encodeOctahedral(m_Normals[k]);
+            packed[2 * k] = packSnorm16(n.x);
+            packed[2 * k + 1] = packSnorm16(n.y);
+        }
+
+        frame.size += uint32_t(m_Encoded.size());
+        m_bFailed |= std::fwrite(m_Encoded.data(), 1, m_Encoded.size(), m_pFile) != m_Encoded.size();
+    }
+
+    m_nOffset += frame.size;
+    m_Frames.push_back(frame);
+}
+
+SimulationCacheReader::SimulationCacheReader(const std::string& path):
+    m_pData(nullptr), m_nSize(0), m_pFrames(nullptr), m_nFrameCount(0), m_nNormalSize(0), m_nDecodedFrame(-1) {
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open simulation cache " + path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(SimulationCacheHeader) + sizeof(SimulationCacheFooter)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid simulation cache " + path);
+    }
+    m_nSize = info.st_size;
+
+    void* data = ::mmap(nullptr, m_nSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Unable to map simulation cache " + path);
+    }
+    m_pData = static_cast<const uint8_t*>(data);
+
+    std::memcpy(&m_Header, m_pData, sizeof(m_Header));
+    SimulationCacheFooter footer;
+    std::memcpy(&footer, m_pData + m_nSize - sizeof(footer), sizeof(footer));
+
+    // Les champs flags et gridWidth étaient réservés (nuls) en version 1
+    if (m_Header.version < 2) {
+        m_Header.flags = 0;
+        m_Header.gridWidth = 0;
+    }
+    if (hasNormals()) {
+        m_nNormalSize = size_t(m_Header.particleCount) * 2 * sizeof(int16_t);
+    }
+
+    size_t tableEnd = m_nSize - sizeof(SimulationCacheFooter);
+    bool valid = std::memcmp(m_Header.magic, SIMULATION_CACHE_MAGIC, 4) == 0 &&
+                 std::memcmp(footer.magic, SIMULATION_CACHE_MAGIC, 4) == 0 &&
+                 m_Header.version <= SIMULATION_CACHE_VERSION &&
+                 m_Header.encoding <= uint32_t(SimulationCacheEncoding::QuantizedDelta) &&
+                 footer.tableOffset <= tableEnd &&
+                 footer.frameCount == (tableEnd - footer.tableOffset) / sizeof(SimulationCacheFrame) &&
+                 footer.tableOffset % alignof(SimulationCacheFrame) == 0 &&
+                 (!hasNormals() || (m_Header.gridWidth >= 2 && m_Header.particleCount % m_Header.gridWidth == 0));
+
+    m_pFrames = reinterpret_cast<const SimulationCacheFrame*>(m_pData + footer.tableOffset);
+    m_nFrameCount = footer.frameCount;
+
+    size_t rawSize = size_t(m_Header.particleCount) * sizeof(glm::vec3);
+    for (uint32_t i = 0; valid && i < m_nFrameCount; ++i) {
+        const SimulationCacheFrame& frame = m_pFrames[i];
+        valid = frame.offset <= footer.tableOffset && frame.size <= footer.tableOffset - frame.offset &&
+                frame.size >= m_nNormalSize &&
+                (getEncoding() != SimulationCacheEncoding::Raw || frame.size == rawSize + m_nNormalSize) &&
+                (i > 0 || frame.keyframe);
+    }
+
+    if (!valid) {
+        ::munmap(const_cast<uint8_t*>(m_pData), m_nSize);
+        throw std::runtime_error("Invalid simulation cache " + path);
+    }
+}
+
+SimulationCacheReader::~SimulationCacheReader() {
+    ::munmap(const_cast<uint8_t*>(m_pData), m_nSize);
+}
+
+const glm::vec3* SimulationCacheReader::rawFrame(uint32_t index) const {
+    if (index >= m_nFrameCount) {
+        throw std::out_of_range("Simulation cache frame out of range");
+    }
+    if (getEncoding() != SimulationCacheEncoding::Raw)
+        return nullptr;
+    return reinterpret_cast<const glm::vec3*>(m_pData + m_pFrames[index].offset);
+}
+
+void SimulationCacheReader::readFrame(uint32_t index, glm::vec3* positionArray) {
+    const glm::vec3* raw = rawFrame(index);
+    if (raw) {
+        std::copy(raw, raw + m_Header.particleCount, positionArray);
+        return;
+    }
+
+    // Repart de la frame clé précédente, sauf si la frame déjà décodée est entre les deux
+    uint32_t first = index;
+    while (!m_pFrames[first].keyframe)
+        --first;
+    if (m_nDecodedFrame >= int64_t(first) && m_nDecodedFrame <= int64_t(index))
+        first = uint32_t(m_nDecodedFrame + 1);
+
+    for (uint32_t i = first; i <= index; ++i) {
+        decodeFrame(i);
+    }
+
+    float* values = glm::value_ptr(positionArray[0]);
+    for (size_t i = 0; i < m_Quantized.size(); ++i) {
+        values[i] = m_Quantized[i] * m_Header.quantizationStep;
+    }
+}
+
+void SimulationCacheReader::readNormals(uint32_t index, glm::vec3* normalArray) const {
+    if (index >= m_nFrameCount) {
+        throw std::out_of_range("Simulation cache frame out of range");
+    }
+    if (!hasNormals()) {
+        throw std::runtime_error("Simulation cache has no normals");
+    }
+
+    const SimulationCacheFrame& frame = m_pFrames[index];
+    const uint8_t* data = m_pData + frame.offset + frame.size - m_nNormalSize;
+    for (uint32_t k = 0; k < m_Header.particleCount; ++k) {
+        int16_t packed[2];
+        std::memcpy(packed, data + 4 * k, sizeof(packed));
+        normalArray[k] = decodeOctahedral(glm::vec2(unpackSnorm16(packed[0]), unpackSnorm16(packed[1])));
+    }
+}
+
+void SimulationCacheReader::decodeFrame(uint32_t index) {
+    const SimulationCacheFrame& frame = m_pFrames[index];
+    const uint8_t* data = m_pData + frame.offset;
+    const uint8_t* end = data + frame.size - m_nNormalSize;
+
+    m_Quantized.resize(size_t(m_Header.particleCount) * 3);
+    m_nDecodedFrame = -1;
+    for (auto& q : m_Quantized) {
+        uint64_t value;
+        if (!readVarint(data, end, value)) {
+            throw std::runtime_error("Corrupted simulation cache frame");
+        }
+        q = int32_t(frame.keyframe ? zigzagDecode(value) : q + zigzagDecode(value));
+    }
+    m_nDecodedFrame = index;
+}
+
+}
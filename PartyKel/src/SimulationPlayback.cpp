@@ -0,0 +1,79 @@
+#include "PartyKel/SimulationPlayback.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace PartyKel {
+
+SimulationPlayback::SimulationPlayback(const std::string& path):
+    m_Reader(path), m_pPositions(nullptr), m_pNormals(nullptr) {
+
+    if (m_Reader.getFrameCount() == 0) {
+        throw std::runtime_error("Simulation cache " + path + " is empty");
+    }
+
+    uint32_t n = m_Reader.getParticleCount();
+    for (int slot = 0; slot < 2; ++slot) {
+        m_FrameIndex[slot] = -1;
+        m_Positions[slot].resize(n);
+        if (hasNormals())
+            m_Normals[slot].resize(n);
+    }
+    m_InterpolatedPositions.resize(n);
+    if (hasNormals())
+        m_InterpolatedNormals.resize(n);
+
+    seek(0.f);
+}
+
+int SimulationPlayback::loadFrame(uint32_t index, int other) {
+    for (int slot = 0; slot < 2; ++slot) {
+        if (m_FrameIndex[slot] == index)
+            return slot;
+    }
+
+    int slot = 1 - other;
+    m_Reader.readFrame(index, m_Positions[slot].data());
+    if (hasNormals())
+        m_Reader.readNormals(index, m_Normals[slot].data());
+    m_FrameIndex[slot] = index;
+    return slot;
+}
+
+void SimulationPlayback::seek(float time) {
+    uint32_t lastFrame = getFrameCount() - 1;
+    time = glm::clamp(time, 0.f, float(lastFrame));
+
+    uint32_t first = glm::min(uint32_t(time), lastFrame);
+    uint32_t second = glm::min(first + 1, lastFrame);
+    float alpha = time - first;
+
+    int firstSlot = loadFrame(first, m_FrameIndex[0] == second ? 0 : 1);
+    if (alpha == 0.f || first == second) {
+        m_pPositions = m_Positions[firstSlot].data();
+        m_pNormals = hasNormals() ? m_Normals[firstSlot].data() : nullptr;
+        return;
+    }
+    int secondSlot = loadFrame(second, firstSlot);
+
+    const std::vector<glm::vec3>& p0 = m_Positions[firstSlot];
+    const std::vector<glm::vec3>& p1 = m_Positions[secondSlot];
+    for (size_t k = 0; k < m_InterpolatedPositions.size(); ++k) {
+        m_InterpolatedPositions[k] = glm::mix(p0[k], p1[k], alpha);
+    }
+    m_pPositions = m_InterpolatedPositions.data();
+    m_pNormals = nullptr;
+
+    if (hasNormals()) {
+        const std::vector<glm::vec3>& n0 = m_Normals[firstSlot];
+        const std::vector<glm::vec3>& n1 = m_Normals[secondSlot];
+        for (size_t k = 0; k < m_InterpolatedNormals.size(); ++k) {
+            glm::vec3 n = glm::mix(n0[k], n1[k], alpha);
+            float length = glm::length(n);
+            m_InterpolatedNormals[k] = length > 0.f ? n / length : n0[k];
+        }
+        m_pNormals = m_InterpolatedNormals.data();
+    }
+}
+
+}
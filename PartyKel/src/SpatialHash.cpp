@@ -0,0 +1,45 @@
+#include "PartyKel/SpatialHash.hpp"
+#include "PartyKel/ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace PartyKel {
+
+void SpatialHash::build(const glm::vec3* positions, int count, float radius, ThreadPool* pool) {
+    m_fCellSize = 2.f * radius;
+
+    // Au moins deux cases par point pour limiter les collisions de la table
+    uint32_t bucketCount = 64;
+    while (bucketCount < 2 * uint32_t(count))
+        bucketCount *= 2;
+    m_nBucketMask = bucketCount - 1;
+
+    m_Cells.resize(count);
+    m_Buckets.resize(count);
+    m_Entries.resize(count);
+    m_BucketStart.resize(bucketCount + 1);
+
+    auto computeCells = [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            m_Cells[i] = cellOf(positions[i]);
+            m_Buckets[i] = hash(m_Cells[i]);
+        }
+    };
+    if (pool)
+        pool->parallelFor(0, count, 4096, computeCells);
+    else
+        computeCells(0, count);
+
+    // Tri par dénombrement: m_BucketStart[b] reçoit d'abord la fin de la case b, puis
+    // le remplissage à rebours la ramène au début de la case
+    std::fill(m_BucketStart.begin(), m_BucketStart.end(), 0);
+    for (int i = 0; i < count; ++i)
+        ++m_BucketStart[m_Buckets[i]];
+    for (uint32_t b = 1; b < bucketCount; ++b)
+        m_BucketStart[b] += m_BucketStart[b - 1];
+    m_BucketStart[bucketCount] = count;
+    for (int i = count - 1; i >= 0; --i)
+        m_Entries[--m_BucketStart[m_Buckets[i]]] = i;
+}
+
+}
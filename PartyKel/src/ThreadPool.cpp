@@ -0,0 +1,170 @@
+#include "PartyKel/ThreadPool.hpp"
+#include "PartyKel/Tracer.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace PartyKel {
+
+static thread_local unsigned int t_nThreadIndex = 0;
+
+// Fixe le thread sur le (index modulo N)-ième des N coeurs autorisés pour le processus
+static void pinThread(std::thread::native_handle_type thread, unsigned int index) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0)
+        return;
+
+    unsigned int target = index % CPU_COUNT(&allowed);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed))
+            continue;
+        if (target-- == 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(thread, sizeof(set), &set);
+            return;
+        }
+    }
+#else
+    (void) thread;
+    (void) index;
+#endif
+}
+
+ThreadPool::ThreadPool(unsigned int threadCount, bool pinThreads):
+    m_Task{ nullptr, nullptr },
+    m_nBegin(0), m_nEnd(0), m_nChunkSize(0), m_nChunkCount(0),
+    m_nNextChunk(0), m_nPendingChunks(0), m_nActiveWorkers(0),
+    m_nGeneration(0), m_bStop(false) {
+    for (unsigned int i = 0; i < std::max(threadCount, 1u); ++i) {
+        m_FrameArenas.emplace_back(new FrameArena());
+    }
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        m_Workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    if (pinThreads) {
+        // Les coeurs sont lus avant de fixer le thread appelant, qui restreindrait sinon ceux des workers
+        for (unsigned int i = 1; i < threadCount; ++i)
+            pinThread(m_Workers[i - 1].native_handle(), i);
+#ifdef __linux__
+        pinThread(pthread_self(), 0);
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_bStop = true;
+    }
+    m_WakeCondition.notify_all();
+    for (auto& worker : m_Workers) {
+        worker.join();
+    }
+}
+
+unsigned int ThreadPool::getCurrentThreadIndex() {
+    return t_nThreadIndex;
+}
+
+void ThreadPool::resetFrameArenas() {
+    for (auto& arena : m_FrameArenas) {
+        arena->reset();
+    }
+}
+
+void ThreadPool::run(int begin, int end, int grain, TaskRef task) {
+    int count = end - begin;
+    if (count <= 0)
+        return;
+
+    // Quelques blocs par thread pour équilibrer la charge
+    int chunkCount = std::min((count + std::max(grain, 1) - 1) / std::max(grain, 1), int(getThreadCount()) * 4);
+    if (m_Workers.empty() || chunkCount <= 1) {
+        task.call(task.task, begin, end);
+        return;
+    }
+    int chunkSize = (count + chunkCount - 1) / chunkCount;
+    chunkCount = (count + chunkSize - 1) / chunkSize;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Task = task;
+        m_nBegin = begin;
+        m_nEnd = end;
+        m_nChunkSize = chunkSize;
+        m_nChunkCount = chunkCount;
+        m_nNextChunk = 0;
+        m_nPendingChunks = chunkCount;
+        ++m_nGeneration;
+    }
+    m_WakeCondition.notify_all();
+
+    runChunks(task, begin, end, chunkSize, chunkCount);
+
+    // Attend la fin des blocs et que plus aucun worker ne lise les paramètres de la tâche
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_DoneCondition.wait(lock, [this]() { return m_nPendingChunks == 0 && m_nActiveWorkers == 0; });
+    m_Task.task = nullptr;
+}
+
+void ThreadPool::runChunks(TaskRef task, int begin, int end, int chunkSize, int chunkCount) {
+    int completed = 0;
+    for (int chunk = m_nNextChunk++; chunk < chunkCount; chunk = m_nNextChunk++) {
+        int chunkBegin = begin + chunk * chunkSize, chunkEnd = std::min(chunkBegin + chunkSize, end);
+        PK_TRACE_TASK(chunkBegin, chunkEnd);
+        task.call(task.task, chunkBegin, chunkEnd);
+        ++completed;
+    }
+
+    if (completed > 0) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_nPendingChunks -= completed;
+    }
+}
+
+void ThreadPool::workerLoop(unsigned int index) {
+    t_nThreadIndex = index;
+#ifdef PARTYKEL_ENABLE_PROFILING
+    Tracer::instance().setThreadName("Worker " + std::to_string(index));
+#else
+    (void) index;
+#endif
+
+    uint64_t lastGeneration = 0;
+    while (true) {
+        TaskRef task;
+        int begin, end, chunkSize, chunkCount;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WakeCondition.wait(lock, [&]() { return m_bStop || (m_nGeneration != lastGeneration && m_Task.task); });
+            if (m_bStop)
+                return;
+
+            lastGeneration = m_nGeneration;
+            task = m_Task;
+            begin = m_nBegin;
+            end = m_nEnd;
+            chunkSize = m_nChunkSize;
+            chunkCount = m_nChunkCount;
+            ++m_nActiveWorkers;
+        }
+
+        runChunks(task, begin, end, chunkSize, chunkCount);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            --m_nActiveWorkers;
+        }
+        m_DoneCondition.notify_one();
+    }
+}
+
+}
@@ -0,0 +1,129 @@
+#include "PartyKel/Tracer.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace PartyKel {
+
+thread_local Tracer::ThreadBuffer* Tracer::t_pBuffer = nullptr;
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer():
+    m_Epoch(Clock::now()), m_bRecording(false) {
+}
+
+Tracer::ThreadBuffer* Tracer::getThreadBuffer() {
+    if (t_pBuffer)
+        return t_pBuffer;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+    buffer->id = m_Buffers.size() + 1;
+    buffer->name = "Thread " + std::to_string(buffer->id);
+    buffer->count = 0;
+    buffer->dropped = 0;
+    t_pBuffer = buffer.get();
+    m_Buffers.push_back(std::move(buffer));
+    return m_Buffers.back().get();
+}
+
+void Tracer::start() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto& buffer : m_Buffers) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+    m_bRecording.store(true, std::memory_order_release);
+}
+
+void Tracer::record(const char* name, const char* category, Clock::time_point startTime, Clock::time_point endTime,
+                    int32_t begin, int32_t end) {
+    ThreadBuffer* buffer = getThreadBuffer();
+
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= EVENTS_PER_THREAD) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!buffer->events)
+        buffer->events.reset(new TraceEvent[EVENTS_PER_THREAD]);
+
+    TraceEvent& event = buffer->events[index];
+    event.name = name;
+    event.category = category;
+    event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(startTime - m_Epoch).count();
+    event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    event.begin = begin;
+    event.end = end;
+
+    // Publie l'événement pour writeJSON
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    ThreadBuffer* buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    buffer->name = name;
+}
+
+void Tracer::writeJSON(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Unable to open trace file " + path);
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // ts et dur sont en microsecondes
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&]() -> std::ostream& {
+        if (!first)
+            out << ",\n";
+        first = false;
+        return out;
+    };
+
+    for (const auto& buffer : m_Buffers) {
+        separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+                    << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+        separator() << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+                    << ",\"args\":{\"sort_index\":" << buffer->id << "}}";
+
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t k = 0; k < count; ++k) {
+            const TraceEvent& event = buffer->events[k];
+            separator() << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+                        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                        << ",\"ts\":" << event.start * 1e-3 << ",\"dur\":" << event.duration * 1e-3;
+            if (event.begin >= 0)
+                out << ",\"args\":{\"begin\":" << event.begin << ",\"end\":" << event.end << "}";
+            out << "}";
+        }
+    }
+
+    uint64_t dropped = 0;
+    for (const auto& buffer : m_Buffers)
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    out << "\n],\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+
+    if (!out) {
+        throw std::runtime_error("Unable to write trace file " + path);
+    }
+}
+
+uint64_t Tracer::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    uint64_t dropped = 0;
+    for (const auto& buffer : m_Buffers)
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    return dropped;
+}
+
+}
@@ -0,0 +1,193 @@
+#include "PartyKel/TriangleMesh.hpp"
+#include "PartyKel/ThreadPool.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace PartyKel {
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Lit les sommets et les faces des lignes [begin, end)
+static void parseOBJ(const char* begin, const char* end, const std::string& source, TriangleMesh& mesh) {
+    int lineNumber = 0;
+    std::vector<uint32_t> polygon;
+    const char* line = begin;
+    while (line < end) {
+        ++lineNumber;
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!lineEnd)
+            lineEnd = end;
+
+        auto error = [&](const char* message) {
+            throw std::runtime_error(source + ":" + std::to_string(lineNumber) + ": " + message);
+        };
+
+        // strtof et strtol s'arrêtent au premier caractère invalide: une copie terminée par un zéro
+        // évite de lire au-delà de la ligne (le fichier mappé n'est pas terminé par un zéro)
+        char buffer[512];
+        if (size_t(lineEnd - line) >= sizeof(buffer))
+            error("line too long");
+        std::memcpy(buffer, line, lineEnd - line);
+        buffer[lineEnd - line] = 0;
+
+        const char* c = buffer;
+        while (isBlank(*c))
+            ++c;
+
+        if (c[0] == 'v' && isBlank(c[1])) {
+            float v[3];
+            const char* value = c + 2;
+            for (int k = 0; k < 3; ++k) {
+                char* next;
+                v[k] = std::strtof(value, &next);
+                if (next == value)
+                    error("expected 3 coordinates");
+                value = next;
+            }
+            mesh.positions.push_back(glm::vec3(v[0], v[1], v[2]));
+        } else if (c[0] == 'f' && isBlank(c[1])) {
+            polygon.clear();
+            const char* corner = c + 2;
+            while (true) {
+                while (isBlank(*corner))
+                    ++corner;
+                if (!*corner)
+                    break;
+
+                char* next;
+                long index = std::strtol(corner, &next, 10);
+                if (next == corner || index == 0)
+                    error("invalid vertex index");
+
+                // Indices négatifs: relatifs au dernier sommet lu
+                long vertexCount = mesh.positions.size();
+                long vertex = index > 0 ? index - 1 : vertexCount + index;
+                if (vertex < 0 || vertex >= vertexCount)
+                    error("vertex index out of range");
+                polygon.push_back(uint32_t(vertex));
+
+                // Ignore les indices de texture et de normale (v/vt/vn, v//vn)
+                corner = next;
+                while (*corner && !isBlank(*corner))
+                    ++corner;
+            }
+
+            if (polygon.size() < 3)
+                error("a face needs at least 3 vertices");
+            for (size_t k = 1; k + 1 < polygon.size(); ++k) {
+                mesh.indices.push_back(polygon[0]);
+                mesh.indices.push_back(polygon[k]);
+                mesh.indices.push_back(polygon[k + 1]);
+            }
+        }
+        // Les autres instructions (vt, vn, o, g, usemtl, commentaires...) sont ignorées
+
+        line = lineEnd + 1;
+    }
+}
+
+TriangleMesh loadOBJ(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open mesh " + path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Unable to read mesh " + path);
+    }
+
+    TriangleMesh mesh;
+    if (info.st_size > 0) {
+        void* data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Unable to read mesh " + path);
+        }
+
+        const char* text = static_cast<const char*>(data);
+        try {
+            parseOBJ(text, text + info.st_size, path, mesh);
+        } catch (...) {
+            ::munmap(data, info.st_size);
+            throw;
+        }
+        ::munmap(data, info.st_size);
+    } else {
+        ::close(fd);
+    }
+
+    if (mesh.indices.empty()) {
+        throw std::runtime_error("Mesh " + path + " has no faces");
+    }
+    return mesh;
+}
+
+void buildVertexTriangles(const std::vector<uint32_t>& indexArray, uint32_t vertexCount, VertexTriangles& adjacency) {
+    adjacency.offsets.assign(vertexCount + 1, 0);
+    for (uint32_t v : indexArray)
+        ++adjacency.offsets[v + 1];
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+    adjacency.triangles.resize(indexArray.size());
+    std::vector<uint32_t> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t k = 0; k < indexArray.size(); ++k)
+        adjacency.triangles[cursor[indexArray[k]]++] = uint32_t(k / 3);
+}
+
+void computeMeshFaceNormals(const glm::vec3* positionArray, const uint32_t* indexArray,
+                            glm::vec3* faceNormalArray, int triangleBegin, int triangleEnd) {
+    for (int t = triangleBegin; t < triangleEnd; ++t) {
+        const glm::vec3& A = positionArray[indexArray[3 * t]];
+        const glm::vec3& B = positionArray[indexArray[3 * t + 1]];
+        const glm::vec3& C = positionArray[indexArray[3 * t + 2]];
+        glm::vec3 N = glm::cross(B - A, C - A);
+        float l = glm::length(N);
+        faceNormalArray[t] = l > 0.0001f ? N / l : glm::vec3(0.f);
+    }
+}
+
+void gatherMeshVertexNormals(const glm::vec3* faceNormalArray, const VertexTriangles& adjacency,
+                             glm::vec3* normalArray, int vertexBegin, int vertexEnd) {
+    for (int v = vertexBegin; v < vertexEnd; ++v) {
+        glm::vec3 N(0.f);
+        for (uint32_t k = adjacency.offsets[v]; k < adjacency.offsets[v + 1]; ++k)
+            N += faceNormalArray[adjacency.triangles[k]];
+
+        float l = glm::length(N);
+        normalArray[v] = l > 0.f ? N / l : glm::vec3(0.f);
+    }
+}
+
+void computeMeshNormals(const glm::vec3* positionArray, const std::vector<uint32_t>& indexArray,
+                        const VertexTriangles& adjacency, glm::vec3* faceNormalArray, glm::vec3* normalArray,
+                        ThreadPool* pool) {
+    int triangleCount = indexArray.size() / 3;
+    int vertexCount = adjacency.offsets.size() - 1;
+
+    if (!pool) {
+        computeMeshFaceNormals(positionArray, indexArray.data(), faceNormalArray, 0, triangleCount);
+        gatherMeshVertexNormals(faceNormalArray, adjacency, normalArray, 0, vertexCount);
+        return;
+    }
+
+    pool->parallelFor(0, triangleCount, 4096, [&](int begin, int end) {
+        computeMeshFaceNormals(positionArray, indexArray.data(), faceNormalArray, begin, end);
+    });
+    pool->parallelFor(0, vertexCount, 4096, [&](int begin, int end) {
+        gatherMeshVertexNormals(faceNormalArray, adjacency, normalArray, begin, end);
+    });
+}
+
+}
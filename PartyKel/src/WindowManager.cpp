@@ -1,4 +1,5 @@
 #include "PartyKel/WindowManager.hpp"
+#include "PartyKel/HeadlessRenderer.hpp"
 
 #include <GL/glew.h>
 #include <iostream>
@@ -24,11 +25,27 @@ WindowManager::WindowManager(uint32_t w, uint32_t h, const char *title) {
     }
 }
 
+WindowManager::WindowManager(uint32_t w, uint32_t h, const std::string& outputDirectory):
+    m_nStartTime(0) {
+    setFramerate(30);
+
+    m_pHeadless.reset(new HeadlessRenderer(w, h, outputDirectory));
+}
+
 WindowManager::~WindowManager() {
+    if (m_pHeadless) {
+        m_pHeadless.reset();
+        return;
+    }
     SDL_Quit();
 }
 
 float WindowManager::update() {
+    if (m_pHeadless) {
+        m_pHeadless->endFrame();
+        return 0.01f * m_nFrameDuration;
+    }
+
     SDL_GL_SwapBuffers();
 
     Uint32 currentTime = SDL_GetTicks();
@@ -1,11 +1,43 @@
 #include "PartyKel/renderer/FlagRenderer3D.hpp"
 #include "PartyKel/renderer/GLtools.hpp"
+#include "PartyKel/GridMesh.hpp"
+#include "PartyKel/VertexPacking.hpp"
+#include "PartyKel/ThreadPool.hpp"
+#include "PartyKel/Profiler.hpp"
 #include "PartyKel/glm.hpp"
 
 #include <iostream>
+#include <algorithm>
 
 namespace PartyKel {
 
+// Appelle f(begin, end) pour chaque suite de rangées consécutives de [0, rowCount) vérifiant needed(j)
+template<typename P, typename F>
+static void forEachRowRun(int rowCount, const P& needed, const F& f) {
+    int j = 0;
+    while (j < rowCount) {
+        if (!needed(j)) {
+            ++j;
+            continue;
+        }
+        int begin = j;
+        while (j < rowCount && needed(j))
+            ++j;
+        f(begin, j);
+    }
+}
+
+// Appelle f sur des blocs de [begin, end), en parallèle si un pool est fourni
+template<typename F>
+static void forEachRowBlock(ThreadPool* pool, int begin, int end, int grain, const F& f) {
+    if (pool)
+        pool->parallelFor(begin, end, grain, f);
+    else
+        f(begin, end);
+}
+
+const int FlagRenderer3D::REGION_COUNT;
+
 const GLchar* FlagRenderer3D::VERTEX_SHADER =
 "#version 330 core\n"
 GL_STRINGIFY(
@@ -15,13 +47,29 @@ GL_STRINGIFY(
     uniform mat4 uMVPMatrix;
     uniform mat4 uMVMatrix;
 
+    // Format compact: positions normalisées dans la boîte englobante, normales en encodage octaédrique
+    uniform vec3 uPositionOffset;
+    uniform vec3 uPositionScale;
+    uniform bool uOctahedralNormals;
+
     out vec3 vFragPosition;
     out vec3 vFragNormal;
 
+    vec3 decodeOctahedral(vec2 e) {
+        vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+        if (n.z < 0.0) {
+            n.xy = (1.0 - abs(e.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+        }
+        return n;
+    }
+
     void main() {
-        vFragPosition = vec3(uMVPMatrix * vec4(aVertexPosition, 1));
-        vFragNormal = vec3(uMVMatrix * vec4(aVertexNormal, 0));
-        gl_Position = uMVPMatrix * vec4(aVertexPosition, 1);
+        vec3 position = uPositionOffset + uPositionScale * aVertexPosition;
+        vec3 normal = uOctahedralNormals ? decodeOctahedral(aVertexNormal.xy) : aVertexNormal;
+
+        vFragPosition = vec3(uMVPMatrix * vec4(position, 1));
+        vFragNormal = vec3(uMVMatrix * vec4(normal, 0));
+        gl_Position = uMVPMatrix * vec4(position, 1);
     }
 );
 
@@ -38,29 +86,70 @@ GL_STRINGIFY(
     }
 );
 
-FlagRenderer3D::FlagRenderer3D(int gridWidth, int gridHeight):
+FlagRenderer3D::FlagRenderer3D(int gridWidth, int gridHeight, UploadMode uploadMode, VertexFormat vertexFormat):
     m_ProgramID(buildProgram(VERTEX_SHADER, FRAGMENT_SHADER)),
     m_ProjMatrix(1.f), m_ViewMatrix(1.f),
     m_nGridWidth(gridWidth), m_nGridHeight(gridHeight), m_nIndexCount(0),
-    m_VertexBuffer(gridWidth * gridHeight) {
+    m_nVertexCount(gridWidth * gridHeight),
+    m_UploadMode(uploadMode), m_VertexFormat(vertexFormat),
+    m_pMappedBuffer(nullptr), m_nCurrentRegion(0),
+    m_PositionOffset(0.f), m_PositionScale(1.f),
+    m_FaceNormals(2 * (gridWidth - 1) * (gridHeight - 1)),
+    m_pThreadPool(nullptr),
+    m_pChangedRows(nullptr), m_RowAges(gridHeight, 0) {
+
+    bool hasBufferStorage = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    if (m_UploadMode == UploadMode::Auto || (m_UploadMode == UploadMode::PersistentMapped && !hasBufferStorage)) {
+        m_UploadMode = hasBufferStorage ? UploadMode::PersistentMapped : UploadMode::Orphaning;
+    }
+
+    if (m_VertexFormat == VertexFormat::Compact) {
+        m_nPositionSize = 4 * sizeof(uint16_t); // La 4ème composante aligne les positions sur 8 octets
+        m_nNormalSize = 2 * sizeof(int16_t);
+    } else {
+        m_nPositionSize = sizeof(glm::vec3);
+        m_nNormalSize = sizeof(glm::vec3);
+    }
+
+    for (auto& fence : m_Fences) {
+        fence = 0;
+    }
 
     // Création du VBO
     glGenBuffers(1, &m_VBOID);
     glBindBuffer(GL_ARRAY_BUFFER, m_VBOID);
 
-    glGenBuffers(1, &m_IBOID);
-
-    std::vector<GLuint> indexBuffer;
-    for (int j = 0; j < gridHeight - 1; ++j) {
-        for (int i = 0; i < gridWidth - 1; ++i) {
-            indexBuffer.push_back(i + j * gridWidth);
-            indexBuffer.push_back((i + 1) + j * gridWidth);
-            indexBuffer.push_back((i + 1) + (j + 1) * gridWidth);
-            indexBuffer.push_back(i + j * gridWidth);
-            indexBuffer.push_back((i + 1) + (j + 1) * gridWidth);
-            indexBuffer.push_back(i + (j + 1) * gridWidth);
+    int regionCount = 1;
+    if (m_UploadMode == UploadMode::PersistentMapped) {
+        regionCount = REGION_COUNT;
+
+        GLsizeiptr size = regionCount * m_nVertexCount * (m_nPositionSize + m_nNormalSize);
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        m_pMappedBuffer = (GLubyte*) glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+
+        if (!m_pMappedBuffer) {
+            // Un buffer alloué par glBufferStorage est immuable: on en recrée un
+            std::cerr << "Unable to map the cloth vertex buffer, falling back to orphaning" << std::endl;
+            glDeleteBuffers(1, &m_VBOID);
+            glGenBuffers(1, &m_VBOID);
+            glBindBuffer(GL_ARRAY_BUFFER, m_VBOID);
+            m_UploadMode = UploadMode::Orphaning;
+            regionCount = 1;
         }
     }
+
+    if (m_UploadMode == UploadMode::Orphaning || m_VertexFormat == VertexFormat::Compact) {
+        m_Normals.resize(m_nVertexCount);
+    }
+    if (m_UploadMode == UploadMode::Orphaning && m_VertexFormat == VertexFormat::Compact) {
+        m_Staging.resize(m_nVertexCount * (m_nPositionSize + m_nNormalSize));
+    }
+
+    glGenBuffers(1, &m_IBOID);
+
+    std::vector<uint32_t> indexBuffer;
+    buildGridIndices(gridWidth, gridHeight, indexBuffer);
     m_nIndexCount = indexBuffer.size();
 
     // Création du VAO
@@ -70,19 +159,37 @@ FlagRenderer3D::FlagRenderer3D(int gridWidth, int gridHeight):
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBOID);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.size() * sizeof(indexBuffer[0]), indexBuffer.data(), GL_STATIC_DRAW);
 
+    const GLvoid* normalOffset = (const GLvoid*) (regionCount * m_nVertexCount * m_nPositionSize);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*) offsetof(Vertex, position));
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*) offsetof(Vertex, normal));
+    if (m_VertexFormat == VertexFormat::Compact) {
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, m_nPositionSize, (const GLvoid*) 0);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, m_nNormalSize, normalOffset);
+    } else {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, m_nPositionSize, (const GLvoid*) 0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, m_nNormalSize, normalOffset);
+    }
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
     m_uMVPMatrix = glGetUniformLocation(m_ProgramID, "uMVPMatrix");
     m_uMVMatrix = glGetUniformLocation(m_ProgramID, "uMVMatrix");
+    m_uPositionOffset = glGetUniformLocation(m_ProgramID, "uPositionOffset");
+    m_uPositionScale = glGetUniformLocation(m_ProgramID, "uPositionScale");
+    m_uOctahedralNormals = glGetUniformLocation(m_ProgramID, "uOctahedralNormals");
 }
 
 FlagRenderer3D::~FlagRenderer3D() {
+    for (auto fence : m_Fences) {
+        if (fence)
+            glDeleteSync(fence);
+    }
+    if (m_pMappedBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBOID);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
     glDeleteBuffers(1, &m_VBOID);
     glDeleteBuffers(1, &m_IBOID);
     glDeleteVertexArrays(1, &m_VAOID);
@@ -93,125 +200,161 @@ void FlagRenderer3D::clear() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
-void FlagRenderer3D::drawGrid(const glm::vec3* positionArray, bool wireframe) {
-    glEnable(GL_DEPTH_TEST);
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBOID);
-
-    for (int j = 0; j < m_nGridHeight; ++j) {
-        for (int i = 0; i < m_nGridWidth; ++i) {
-            m_VertexBuffer[i + j * m_nGridWidth].position = positionArray[i + j * m_nGridWidth];
-            
-            glm::vec3 N(0.f);
-
-            glm::vec3 A = positionArray[i + j * m_nGridWidth];
-
-            if (i > 0 && j > 0) {
-                glm::vec3 B = positionArray[(i - 1) + j * m_nGridWidth];
-                glm::vec3 C = positionArray[(i - 1) + (j - 1) * m_nGridWidth];
-
-                glm::vec3 BxC = glm::cross(B - A, C - A);
-                float l = glm::length(BxC);
-
-                if (l > 0.0001f) {
-                    N += BxC / l;
-                }
-            }
-
-            if (i > 0 && j > 0) {
-                glm::vec3 B = positionArray[(i - 1) + (j - 1) * m_nGridWidth];
-                glm::vec3 C = positionArray[i + (j - 1) * m_nGridWidth];
-
-                glm::vec3 BxC = glm::cross(B - A, C - A);
-                float l = glm::length(BxC);
-
-                if (l > 0.0001f) {
-                    N += BxC / l;
-                }
-            }
-
-            if (i < m_nGridWidth - 1 && j > 0) {
-                glm::vec3 B = positionArray[i + (j - 1) * m_nGridWidth];
-                glm::vec3 C = positionArray[(i + 1) + (j - 1) * m_nGridWidth];
-
-                glm::vec3 BxC = glm::cross(B - A, C - A);
-                float l = glm::length(BxC);
-
-                if (l > 0.0001f) {
-                    N += BxC / l;
-                }
-            }
-
-            if (i < m_nGridWidth - 1 && j > 0) {
-                glm::vec3 B = positionArray[(i + 1) + (j - 1) * m_nGridWidth];
-                glm::vec3 C = positionArray[(i + 1) + j * m_nGridWidth];
+void FlagRenderer3D::packCompactVertices(const glm::vec3* positionArray, const glm::vec3* normalArray,
+                                         GLubyte* positionDst, GLubyte* normalDst) {
+    // Boîte englobante du drapeau
+    glm::vec3 minPosition = positionArray[0], maxPosition = positionArray[0];
+    for (uint32_t k = 1; k < m_nVertexCount; ++k) {
+        minPosition = glm::min(minPosition, positionArray[k]);
+        maxPosition = glm::max(maxPosition, positionArray[k]);
+    }
+    m_PositionOffset = minPosition;
+    m_PositionScale = glm::max(maxPosition - minPosition, glm::vec3(0.000001f));
+
+    glm::vec3 rcpScale = 1.f / m_PositionScale;
+    uint16_t* positions = (uint16_t*) positionDst;
+    int16_t* normals = (int16_t*) normalDst;
+
+    auto pack = [&](int begin, int end) {
+        for (int k = begin; k < end; ++k) {
+            glm::vec3 p = (positionArray[k] - m_PositionOffset) * rcpScale;
+            positions[4 * k] = packUnorm16(p.x);
+            positions[4 * k + 1] = packUnorm16(p.y);
+            positions[4 * k + 2] = packUnorm16(p.z);
+            positions[4 * k + 3] = 0;
+
+            glm::vec2 n = encodeOctahedral(normalArray[k]);
+            normals[2 * k] = packSnorm16(n.x);
+            normals[2 * k + 1] = packSnorm16(n.y);
+        }
+    };
 
-                glm::vec3 BxC = glm::cross(B - A, C - A);
-                float l = glm::length(BxC);
+    if (m_pThreadPool) {
+        m_pThreadPool->parallelFor(0, m_nVertexCount, 4096, pack);
+    } else {
+        pack(0, m_nVertexCount);
+    }
+}
 
-                if (l > 0.0001f) {
-                    N += BxC / l;
-                }
-            }
+void FlagRenderer3D::drawGrid(const glm::vec3* positionArray, bool wireframe) {
+    drawGrid(positionArray, nullptr, wireframe);
+}
 
-            if (i < m_nGridWidth - 1 && j < m_nGridHeight - 1) {
-                glm::vec3 B = positionArray[(i + 1) + j * m_nGridWidth];
-                glm::vec3 C = positionArray[(i + 1) + (j + 1) * m_nGridWidth];
+void FlagRenderer3D::drawGrid(const glm::vec3* positionArray, const glm::vec3* normalArray, bool wireframe) {
+    glEnable(GL_DEPTH_TEST);
 
-                glm::vec3 BxC = glm::cross(B - A, C - A);
-                float l = glm::length(BxC);
+    GLint baseVertex = 0;
+    bool compact = m_VertexFormat == VertexFormat::Compact;
 
-                if (l > 0.0001f) {
-                    N += BxC / l;
+    // Seul le chemin PersistentMapped + Float, calculant ses normales, réécrit une partie des rangées
+    if (m_pChangedRows && !normalArray) {
+        for (int j = 0; j < m_nGridHeight; ++j)
+            m_RowAges[j] = m_pChangedRows[j] ? 0 : std::min(m_RowAges[j] + 1, REGION_COUNT);
+    } else {
+        std::fill(m_RowAges.begin(), m_RowAges.end(), 0);
+    }
+    m_pChangedRows = nullptr;
+
+    if (m_UploadMode == UploadMode::PersistentMapped) {
+        GLubyte *positions, *normals;
+        {
+            // L'attente du GPU fait partie du coût de l'envoi
+            PK_SCOPED_TIMER(PROFILE_UPLOAD);
+
+            // Attend que le GPU ait fini de lire la région (REGION_COUNT frames plus tôt)
+            GLsync& fence = m_Fences[m_nCurrentRegion];
+            if (fence) {
+                while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {
                 }
+                glDeleteSync(fence);
+                fence = 0;
             }
 
-            if (i < m_nGridWidth - 1 && j < m_nGridHeight - 1) {
-                glm::vec3 B = positionArray[(i + 1) + (j + 1) * m_nGridWidth];
-                glm::vec3 C = positionArray[i + (j + 1) * m_nGridWidth];
-
-                glm::vec3 BxC = glm::cross(B - A, C - A);
-                float l = glm::length(BxC);
+            baseVertex = m_nCurrentRegion * m_nVertexCount;
+            positions = m_pMappedBuffer + baseVertex * m_nPositionSize;
+            normals = m_pMappedBuffer + REGION_COUNT * m_nVertexCount * m_nPositionSize + baseVertex * m_nNormalSize;
+        }
 
-                if (l > 0.0001f) {
-                    N += BxC / l;
-                }
+        // Positions et normales sont écrites directement dans la mémoire mappée
+        if (compact) {
+            if (!normalArray) {
+                PK_SCOPED_TIMER(PROFILE_NORMALS);
+                computeGridNormals(positionArray, m_nGridWidth, m_nGridHeight, m_FaceNormals.data(), m_Normals.data(), m_pThreadPool);
+                normalArray = m_Normals.data();
             }
-
-            if (i > 0 && j < m_nGridHeight - 1) {
-                glm::vec3 B = positionArray[i + (j + 1) * m_nGridWidth];
-                glm::vec3 C = positionArray[(i - 1) + (j + 1) * m_nGridWidth];
-
-                glm::vec3 BxC = glm::cross(B - A, C - A);
-                float l = glm::length(BxC);
-
-                if (l > 0.0001f) {
-                    N += BxC / l;
-                }
+            PK_SCOPED_TIMER(PROFILE_UPLOAD);
+            packCompactVertices(positionArray, normalArray, positions, normals);
+        } else if (normalArray) {
+            PK_SCOPED_TIMER(PROFILE_UPLOAD);
+            std::copy(positionArray, positionArray + m_nVertexCount, (glm::vec3*) positions);
+            std::copy(normalArray, normalArray + m_nVertexCount, (glm::vec3*) normals);
+        } else {
+            // Les rangées identiques dans la région (voir m_RowAges) ne sont ni recopiées ni recalculées
+            auto stale = [&](int j) {
+                return m_RowAges[j] < REGION_COUNT;
+            };
+            {
+                PK_SCOPED_TIMER(PROFILE_UPLOAD);
+                forEachRowRun(m_nGridHeight, stale, [&](int begin, int end) {
+                    std::copy(positionArray + begin * m_nGridWidth, positionArray + end * m_nGridWidth,
+                              (glm::vec3*) positions + begin * m_nGridWidth);
+                });
             }
-
-            if (i > 0 && j < m_nGridHeight - 1) {
-                glm::vec3 B = positionArray[(i - 1) + (j + 1) * m_nGridWidth];
-                glm::vec3 C = positionArray[(i - 1) + j * m_nGridWidth];
-
-                glm::vec3 BxC = glm::cross(B - A, C - A);
-                float l = glm::length(BxC);
-
-                if (l > 0.0001f) {
-                    N += BxC / l;
-                }
+            {
+                PK_SCOPED_TIMER(PROFILE_NORMALS);
+                // Environ 4096 sommets par bloc, comme computeGridNormals
+                int grain = std::max(1, 4096 / std::max(m_nGridWidth, 1));
+
+                // Les normales des faces ne sont pas propres à une région: seules celles des quads déplacés changent
+                forEachRowRun(m_nGridHeight - 1, [&](int j) { return m_RowAges[j] == 0 || m_RowAges[j + 1] == 0; }, [&](int begin, int end) {
+                    forEachRowBlock(m_pThreadPool, begin, end, grain, [&](int rowBegin, int rowEnd) {
+                        computeGridFaceNormals(positionArray, m_nGridWidth, m_nGridHeight, m_FaceNormals.data(), rowBegin, rowEnd);
+                    });
+                });
+                // La normale d'un sommet dépend des rangées voisines
+                forEachRowRun(m_nGridHeight, [&](int j) {
+                    return stale(j) || (j > 0 && stale(j - 1)) || (j + 1 < m_nGridHeight && stale(j + 1));
+                }, [&](int begin, int end) {
+                    forEachRowBlock(m_pThreadPool, begin, end, grain, [&](int rowBegin, int rowEnd) {
+                        gatherGridVertexNormals(m_FaceNormals.data(), m_nGridWidth, m_nGridHeight, (glm::vec3*) normals, rowBegin, rowEnd);
+                    });
+                });
             }
+        }
+    } else {
+        // Normales des faces puis des sommets (voir GridMesh.hpp)
+        if (!normalArray) {
+            PK_SCOPED_TIMER(PROFILE_NORMALS);
+            computeGridNormals(positionArray, m_nGridWidth, m_nGridHeight, m_FaceNormals.data(), m_Normals.data(), m_pThreadPool);
+            normalArray = m_Normals.data();
+        }
 
-            m_VertexBuffer[i + j * m_nGridWidth].normal = N != glm::vec3(0.f) ? glm::normalize(N) : glm::vec3(0.f);
+        PK_SCOPED_TIMER(PROFILE_UPLOAD);
+        size_t positionSize = m_nVertexCount * m_nPositionSize;
+        size_t normalSize = m_nVertexCount * m_nNormalSize;
+        const GLvoid* positions = positionArray;
+        const GLvoid* normals = normalArray;
+        if (compact) {
+            packCompactVertices(positionArray, normalArray, m_Staging.data(), m_Staging.data() + positionSize);
+            positions = m_Staging.data();
+            normals = m_Staging.data() + positionSize;
         }
-    }
 
-    glBufferData(GL_ARRAY_BUFFER, m_VertexBuffer.size() * sizeof(m_VertexBuffer[0]), m_VertexBuffer.data(), GL_DYNAMIC_DRAW);
+        // Orphaning: le driver fournit un nouveau stockage sans attendre le GPU
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBOID);
+        glBufferData(GL_ARRAY_BUFFER, positionSize + normalSize, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, positionSize, positions);
+        glBufferSubData(GL_ARRAY_BUFFER, positionSize, normalSize, normals);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
 
     glUseProgram(m_ProgramID);
 
     glUniformMatrix4fv(m_uMVPMatrix, 1, GL_FALSE, glm::value_ptr(m_ProjMatrix * m_ViewMatrix));
     glUniformMatrix4fv(m_uMVMatrix, 1, GL_FALSE, glm::value_ptr(m_ViewMatrix));
+    glUniform3fv(m_uPositionOffset, 1, glm::value_ptr(m_PositionOffset));
+    glUniform3fv(m_uPositionScale, 1, glm::value_ptr(m_PositionScale));
+    glUniform1i(m_uOctahedralNormals, compact);
 
     if (wireframe) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -220,8 +363,13 @@ void FlagRenderer3D::drawGrid(const glm::vec3* positionArray, bool wireframe) {
     }
 
     glBindVertexArray(m_VAOID);
-        glDrawElements(GL_TRIANGLES, m_nIndexCount, GL_UNSIGNED_INT, 0);
+        glDrawElementsBaseVertex(GL_TRIANGLES, m_nIndexCount, GL_UNSIGNED_INT, 0, baseVertex);
     glBindVertexArray(0);
+
+    if (m_UploadMode == UploadMode::PersistentMapped) {
+        m_Fences[m_nCurrentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_nCurrentRegion = (m_nCurrentRegion + 1) % REGION_COUNT;
+    }
 }
 
 }
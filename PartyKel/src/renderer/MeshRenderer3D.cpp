@@ -0,0 +1,121 @@
+#include "PartyKel/renderer/MeshRenderer3D.hpp"
+#include "PartyKel/renderer/GLtools.hpp"
+#include "PartyKel/glm.hpp"
+
+namespace PartyKel {
+
+const GLchar* MeshRenderer3D::VERTEX_SHADER =
+"#version 330 core\n"
+GL_STRINGIFY(
+    layout(location = 0) in vec3 aVertexPosition;
+    layout(location = 1) in vec3 aVertexNormal;
+
+    uniform mat4 uMVPMatrix;
+    uniform mat4 uMVMatrix;
+
+    out vec3 vFragPosition;
+    out vec3 vFragNormal;
+
+    void main() {
+        vFragPosition = vec3(uMVPMatrix * vec4(aVertexPosition, 1));
+        vFragNormal = vec3(uMVMatrix * vec4(aVertexNormal, 0));
+        gl_Position = uMVPMatrix * vec4(aVertexPosition, 1);
+    }
+);
+
+const GLchar* MeshRenderer3D::FRAGMENT_SHADER =
+"#version 330 core\n"
+GL_STRINGIFY(
+    in vec3 vFragPosition;
+    in vec3 vFragNormal;
+
+    out vec3 fFragColor;
+
+    void main() {
+        fFragColor = vec3(abs(dot(normalize(vFragPosition), normalize(vFragNormal))));
+    }
+);
+
+MeshRenderer3D::MeshRenderer3D(uint32_t vertexCount, const std::vector<uint32_t>& indexArray):
+    m_ProgramID(buildProgram(VERTEX_SHADER, FRAGMENT_SHADER)),
+    m_ProjMatrix(1.f), m_ViewMatrix(1.f),
+    m_nVertexCount(vertexCount), m_nIndexCount(indexArray.size()),
+    m_Indices(indexArray),
+    m_FaceNormals(indexArray.size() / 3),
+    m_Normals(vertexCount),
+    m_pThreadPool(nullptr) {
+
+    buildVertexTriangles(m_Indices, m_nVertexCount, m_VertexTriangles);
+
+    glGenBuffers(1, &m_VBOID);
+    glGenBuffers(1, &m_IBOID);
+
+    // Création du VAO: positions puis normales dans le même VBO
+    glGenVertexArrays(1, &m_VAOID);
+    glBindVertexArray(m_VAOID);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBOID);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(m_Indices[0]), m_Indices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBOID);
+    glBufferData(GL_ARRAY_BUFFER, 2 * m_nVertexCount * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (const GLvoid*) 0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (const GLvoid*) (m_nVertexCount * sizeof(glm::vec3)));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    m_uMVPMatrix = glGetUniformLocation(m_ProgramID, "uMVPMatrix");
+    m_uMVMatrix = glGetUniformLocation(m_ProgramID, "uMVMatrix");
+}
+
+MeshRenderer3D::~MeshRenderer3D() {
+    glDeleteBuffers(1, &m_VBOID);
+    glDeleteBuffers(1, &m_IBOID);
+    glDeleteVertexArrays(1, &m_VAOID);
+    glDeleteProgram(m_ProgramID);
+}
+
+void MeshRenderer3D::clear() {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void MeshRenderer3D::drawMesh(const glm::vec3* positionArray, bool wireframe) {
+    drawMesh(positionArray, nullptr, wireframe);
+}
+
+void MeshRenderer3D::drawMesh(const glm::vec3* positionArray, const glm::vec3* normalArray, bool wireframe) {
+    glEnable(GL_DEPTH_TEST);
+
+    if (!normalArray) {
+        computeMeshNormals(positionArray, m_Indices, m_VertexTriangles, m_FaceNormals.data(), m_Normals.data(), m_pThreadPool);
+        normalArray = m_Normals.data();
+    }
+
+    // Orphaning: le driver fournit un nouveau stockage sans attendre le GPU
+    GLsizeiptr size = m_nVertexCount * sizeof(glm::vec3);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBOID);
+    glBufferData(GL_ARRAY_BUFFER, 2 * size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, positionArray);
+    glBufferSubData(GL_ARRAY_BUFFER, size, size, normalArray);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glUseProgram(m_ProgramID);
+
+    glUniformMatrix4fv(m_uMVPMatrix, 1, GL_FALSE, glm::value_ptr(m_ProjMatrix * m_ViewMatrix));
+    glUniformMatrix4fv(m_uMVMatrix, 1, GL_FALSE, glm::value_ptr(m_ViewMatrix));
+
+    if (wireframe) {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    } else {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+
+    glBindVertexArray(m_VAOID);
+        glDrawElements(GL_TRIANGLES, m_nIndexCount, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+}
+
+}
@@ -2,24 +2,41 @@
 #include "PartyKel/renderer/GLtools.hpp"
 #include "PartyKel/renderer/Sphere.hpp"
 
+#include <limits>
+
 namespace PartyKel {
 
+// Discrétisations (latitude, longitude) de chaque niveau de détail
+static const GLsizei LOD_DISCRETISATIONS[Renderer3D::LOD_COUNT][2] = { {64, 32}, {32, 16}, {16, 8}, {12, 6} };
+
+// Rayon projeté minimal (en pixels) pour utiliser chaque niveau de détail
+static const float LOD_MIN_PIXEL_RADIUS[Renderer3D::LOD_COUNT] = { 48.f, 16.f, 6.f, 0.f };
+
 const GLchar* Renderer3D::SPHERE_VERTEX_SHADER =
 "#version 330 core\n"
 GL_STRINGIFY(
     layout(location = 0) in vec3 aVertexPosition;
     layout(location = 1) in vec3 aVertexNormal;
 
-    uniform mat4 uMVPMatrix;
-    uniform mat4 uMVMatrix;
+    // Attributs d'instance
+    layout(location = 2) in vec3 aParticlePosition;
+    layout(location = 3) in float aParticleMass;
+    layout(location = 4) in vec3 aParticleColor;
+
+    uniform mat4 uProjMatrix;
+    uniform mat4 uViewMatrix;
+    uniform float uMassScale;
 
     out vec3 vFragPositionViewSpace;
     out vec3 vFragNormalViewSpace;
+    flat out vec3 vParticleColor;
 
     void main() {
-        vFragPositionViewSpace = vec3(uMVMatrix * vec4(aVertexPosition, 1));
-        vFragNormalViewSpace = vec3(uMVMatrix * vec4(aVertexNormal, 0));
-        gl_Position = uMVPMatrix * vec4(aVertexPosition, 1);
+        vec4 positionViewSpace = uViewMatrix * vec4(aParticlePosition + uMassScale * aParticleMass * aVertexPosition, 1);
+        vFragPositionViewSpace = vec3(positionViewSpace);
+        vFragNormalViewSpace = vec3(uViewMatrix * vec4(aVertexNormal, 0));
+        vParticleColor = aParticleColor;
+        gl_Position = uProjMatrix * positionViewSpace;
     }
 );
 
@@ -28,41 +45,74 @@ const GLchar* Renderer3D::SPHERE_FRAGMENT_SHADER =
 GL_STRINGIFY(
     in vec3 vFragPositionViewSpace;
     in vec3 vFragNormalViewSpace;
-
-    uniform vec3 uParticleColor;
+    flat in vec3 vParticleColor;
 
     out vec3 fFragColor;
 
     void main() {
-        fFragColor = uParticleColor * vec3(abs(dot(normalize(vFragPositionViewSpace), normalize(vFragNormalViewSpace))));
+        fFragColor = vParticleColor * vec3(abs(dot(normalize(vFragPositionViewSpace), normalize(vFragNormalViewSpace))));
     }
 );
 
 Renderer3D::Renderer3D():
     m_SphereProgramID(buildProgram(SPHERE_VERTEX_SHADER, SPHERE_FRAGMENT_SHADER)) {
     // Récuperation des uniforms
-    m_uParticleColor = glGetUniformLocation(m_SphereProgramID, "uParticleColor");
-    m_uMVPMatrix = glGetUniformLocation(m_SphereProgramID, "uMVPMatrix");
-    m_uMVMatrix = glGetUniformLocation(m_SphereProgramID, "uMVMatrix");
+    m_uProjMatrix = glGetUniformLocation(m_SphereProgramID, "uProjMatrix");
+    m_uViewMatrix = glGetUniformLocation(m_SphereProgramID, "uViewMatrix");
+    m_uMassScale = glGetUniformLocation(m_SphereProgramID, "uMassScale");
+
+    // Construction des niveaux de détail, concaténés dans un VBO et un IBO
+    std::vector<Sphere::Vertex> vertices;
+    std::vector<GLuint> indices;
+    for (int lod = 0; lod < LOD_COUNT; ++lod) {
+        Sphere sphere(1.f, LOD_DISCRETISATIONS[lod][0], LOD_DISCRETISATIONS[lod][1]);
+
+        m_SphereLODs[lod].indexCount = sphere.getIndexCount();
+        m_SphereLODs[lod].indexOffset = indices.size() * sizeof(GLuint);
+        m_SphereLODs[lod].baseVertex = vertices.size();
+
+        vertices.insert(vertices.end(), sphere.getDataPointer(), sphere.getDataPointer() + sphere.getVertexCount());
+        indices.insert(indices.end(), sphere.getIndexPointer(), sphere.getIndexPointer() + sphere.getIndexCount());
+    }
 
     // Création du VBO
     glGenBuffers(1, &m_SphereVBOID);
     glBindBuffer(GL_ARRAY_BUFFER, m_SphereVBOID);
-
-    Sphere sphere(1.f, 64, 32);
-    m_nSphereVertexCount = sphere.getVertexCount();
-
-    glBufferData(GL_ARRAY_BUFFER, m_nSphereVertexCount * sizeof(Sphere::Vertex), sphere.getDataPointer(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Sphere::Vertex), vertices.data(), GL_STATIC_DRAW);
 
     // Création du VAO
     glGenVertexArrays(1, &m_SphereVAOID);
     glBindVertexArray(m_SphereVAOID);
 
+    glGenBuffers(1, &m_SphereIBOID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_SphereIBOID);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
     glEnableVertexAttribArray(0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Sphere::Vertex), (const GLvoid*) offsetof(Sphere::Vertex, position));
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Sphere::Vertex), (const GLvoid*) offsetof(Sphere::Vertex, normal));
 
+    // Buffers des attributs d'instance, remplis à chaque appel de drawParticles
+    glGenBuffers(1, &m_InstancePositionVBOID);
+    glGenBuffers(1, &m_InstanceMassVBOID);
+    glGenBuffers(1, &m_InstanceColorVBOID);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_InstancePositionVBOID);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+    glVertexAttribDivisor(2, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceMassVBOID);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(float), 0);
+    glVertexAttribDivisor(3, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceColorVBOID);
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+    glVertexAttribDivisor(4, 1);
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
@@ -71,6 +121,10 @@ Renderer3D::~Renderer3D() {
     glDeleteProgram(m_SphereProgramID);
 
     glDeleteBuffers(1, &m_SphereVBOID);
+    glDeleteBuffers(1, &m_SphereIBOID);
+    glDeleteBuffers(1, &m_InstancePositionVBOID);
+    glDeleteBuffers(1, &m_InstanceMassVBOID);
+    glDeleteBuffers(1, &m_InstanceColorVBOID);
     glDeleteVertexArrays(1, &m_SphereVAOID);
 }
 
@@ -83,22 +137,92 @@ void Renderer3D::drawParticles(uint32_t count,
                    const float* massArray,
                    const glm::vec3* colorArray,
                    float massScale) {
+    if (count == 0)
+        return;
+
+    // Choix du niveau de détail: rayon projeté en pixels = rayon * P[1][1] * (hauteur / 2) / profondeur
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float pixelScale = 0.5f * viewport[3] * m_ProjMatrix[1][1];
+
+    uint32_t lodCounts[LOD_COUNT] = {};
+    m_InstanceLODs.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        float depth = -(m_ViewMatrix * glm::vec4(positionArray[i], 1.f)).z;
+        float pixelRadius = depth > 0.f ? pixelScale * massScale * massArray[i] / depth : std::numeric_limits<float>::max();
+
+        int lod = 0;
+        while (lod < LOD_COUNT - 1 && pixelRadius < LOD_MIN_PIXEL_RADIUS[lod]) {
+            ++lod;
+        }
+        m_InstanceLODs[i] = lod;
+        ++lodCounts[lod];
+    }
+
+    uint32_t lodFirst[LOD_COUNT];
+    uint32_t usedLODs = 0;
+    for (int lod = 0, first = 0; lod < LOD_COUNT; ++lod) {
+        lodFirst[lod] = first;
+        first += lodCounts[lod];
+        usedLODs += lodCounts[lod] > 0;
+    }
+
+    // Regroupe les instances par niveau de détail (inutile si un seul niveau est utilisé)
+    if (usedLODs > 1) {
+        m_SortedPositions.resize(count);
+        m_SortedMasses.resize(count);
+        m_SortedColors.resize(count);
+
+        uint32_t next[LOD_COUNT];
+        std::copy(lodFirst, lodFirst + LOD_COUNT, next);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t j = next[m_InstanceLODs[i]]++;
+            m_SortedPositions[j] = positionArray[i];
+            m_SortedMasses[j] = massArray[i];
+            m_SortedColors[j] = colorArray[i];
+        }
+
+        positionArray = m_SortedPositions.data();
+        massArray = m_SortedMasses.data();
+        colorArray = m_SortedColors.data();
+    }
+
+    // Envoi des attributs d'instance (la réallocation évite d'attendre le GPU)
+    glBindBuffer(GL_ARRAY_BUFFER, m_InstancePositionVBOID);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec3), positionArray, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceMassVBOID);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(float), massArray, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceColorVBOID);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec3), colorArray, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
     glUseProgram(m_SphereProgramID);
 
-    glBindVertexArray(m_SphereVAOID);
+    glUniformMatrix4fv(m_uProjMatrix, 1, GL_FALSE, glm::value_ptr(m_ProjMatrix));
+    glUniformMatrix4fv(m_uViewMatrix, 1, GL_FALSE, glm::value_ptr(m_ViewMatrix));
+    glUniform1f(m_uMassScale, massScale);
 
     glEnable(GL_DEPTH_TEST);
 
-    // Dessine chacune des particules
-    for(uint32_t i = 0; i < count; ++i) {
-        auto modelMatrix = glm::scale(glm::translate(glm::mat4(1.f), positionArray[i]), glm::vec3(massScale * massArray[i]));
-        glUniformMatrix4fv(m_uMVPMatrix, 1, GL_FALSE, glm::value_ptr(m_ProjMatrix * m_ViewMatrix * modelMatrix));
-        glUniformMatrix4fv(m_uMVMatrix, 1, GL_FALSE, glm::value_ptr(m_ViewMatrix * modelMatrix));
-
-        glUniform3fv(m_uParticleColor, 1, glm::value_ptr(colorArray[i]));
-        glDrawArrays(GL_TRIANGLES, 0, m_nSphereVertexCount);
+    // Un appel instancié par niveau de détail utilisé
+    glBindVertexArray(m_SphereVAOID);
+    for (int lod = 0; lod < LOD_COUNT; ++lod) {
+        if (lodCounts[lod] == 0)
+            continue;
+
+        // Décale les attributs d'instance sur le premier élément du niveau
+        glBindBuffer(GL_ARRAY_BUFFER, m_InstancePositionVBOID);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (const GLvoid*) (lodFirst[lod] * sizeof(glm::vec3)));
+        glBindBuffer(GL_ARRAY_BUFFER, m_InstanceMassVBOID);
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(float), (const GLvoid*) (lodFirst[lod] * sizeof(float)));
+        glBindBuffer(GL_ARRAY_BUFFER, m_InstanceColorVBOID);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (const GLvoid*) (lodFirst[lod] * sizeof(glm::vec3)));
+
+        const SphereLOD& sphereLOD = m_SphereLODs[lod];
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, sphereLOD.indexCount, GL_UNSIGNED_INT,
+                                          (const GLvoid*) sphereLOD.indexOffset, lodCounts[lod], sphereLOD.baseVertex);
     }
-
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
 
@@ -23,8 +23,9 @@ void Sphere::build(GLfloat r, GLsizei discLat, GLsizei discLong) {
     GLfloat rcpLat = 1.f / discLat, rcpLong = 1.f / discLong;
     GLfloat dPhi = 2 * glm::pi<float>() * rcpLat, dTheta = glm::pi<float>() * rcpLong;
     
-    std::vector<Vertex> data;
-    
+    m_Vertices.reserve((discLong + 1) * (discLat + 1));
+    m_Indices.reserve(discLat * discLong * 6);
+
     // Construit l'ensemble des vertex
     for(GLsizei j = 0; j <= discLong; ++j) {
         GLfloat cosTheta = cos(-glm::pi<float>() / 2 + j * dTheta);
@@ -42,32 +43,25 @@ void Sphere::build(GLfloat r, GLsizei discLat, GLsizei discLong) {
             
             vertex.position = r * vertex.normal;
             
-            data.push_back(vertex);
+            m_Vertices.push_back(vertex);
         }
     }
 
-    m_nVertexCount = discLat * discLong * 6;
-    
-    GLuint idx = 0;
-    // Construit les vertex finaux en regroupant les données en triangles:
+    // Construit les indices en regroupant les sommets en triangles:
     // Pour une longitude donnée, les deux triangles formant une face sont de la forme:
     // (i, i + 1, i + discLat + 1), (i, i + discLat + 1, i + discLat)
     // avec i sur la bande correspondant à la longitude
     for(GLsizei j = 0; j < discLong; ++j) {
         GLsizei offset = j * (discLat + 1);
         for(GLsizei i = 0; i < discLat; ++i) {
-            m_Vertices.push_back(data[offset + i]);
-            m_Vertices.push_back(data[offset + (i + 1)]);
-            m_Vertices.push_back(data[offset + discLat + 1 + (i + 1)]);
-            m_Vertices.push_back(data[offset + i]);
-            m_Vertices.push_back(data[offset + discLat + 1 + (i + 1)]);
-            m_Vertices.push_back(data[offset + i + discLat + 1]);
+            m_Indices.push_back(offset + i);
+            m_Indices.push_back(offset + (i + 1));
+            m_Indices.push_back(offset + discLat + 1 + (i + 1));
+            m_Indices.push_back(offset + i);
+            m_Indices.push_back(offset + discLat + 1 + (i + 1));
+            m_Indices.push_back(offset + i + discLat + 1);
         }
     }
-
-    for(auto& vertice: m_Vertices) {
-        _positions.push_back(vertice.position);
-    }
 }
 
 }
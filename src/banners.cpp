@@ -0,0 +1,312 @@
+#include <iostream>
+#include <cstdlib>
+
+#include <PartyKel/glm.hpp>
+#include <PartyKel/WindowManager.hpp>
+
+#include <PartyKel/renderer/FlagRenderer3D.hpp>
+#include <PartyKel/renderer/TrackballCamera.hpp>
+#include <PartyKel/renderer/Renderer3D.hpp>
+#include <PartyKel/renderer/Sphere.hpp>
+#include <PartyKel/atb.hpp>
+#include <PartyKel/ThreadPool.hpp>
+#include <PartyKel/SceneConfig.hpp>
+#include <PartyKel/ClothWorld.hpp>
+#include <PartyKel/Flag.hpp>
+#include <PartyKel/FlagCollisions.hpp>
+#include <PartyKel/Random.hpp>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <stdexcept>
+
+static const Uint32 WINDOW_WIDTH = 900;
+static const Uint32 WINDOW_HEIGHT = 700;
+
+using namespace PartyKel;
+
+// Simulation de plusieurs bannières dans un même ClothWorld
+int main(int argc, char** argv) {
+    // banners --banners <n>: nombre de bannières (24 par défaut), par rangées de 6
+    // banners --flags: chaque bannière est un Flag indépendant, les collisions entre elles passent par FlagCollisions
+    // banners --headless <dossier> [nombre de frames]: rendu hors écran d'une séquence d'images
+    // banners --scene <fichier> / --set clé=valeur: paramètres de la scène (voir SceneConfig.hpp),
+    // grid et size donnent les dimensions de chaque bannière
+    int bannerCount = 24;
+    bool independentFlags = false;
+    std::string headlessDirectory;
+    int headlessFrameCount = 600;
+    std::string scenePath;
+    std::vector<std::string> sceneOverrides;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--banners" && i + 1 < argc) {
+            bannerCount = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--flags") {
+            independentFlags = true;
+        } else if (arg == "--headless" && i + 1 < argc) {
+            headlessDirectory = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                headlessFrameCount = std::atoi(argv[++i]);
+        } else if (arg == "--scene" && i + 1 < argc) {
+            scenePath = argv[++i];
+        } else if (arg == "--set" && i + 1 < argc) {
+            sceneOverrides.push_back(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--banners n] [--flags] [--scene file] [--set key=value] [--headless dir [frames]]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Bannières plus petites que le drapeau de flag, sauf si la scène les redéfinit
+    SceneConfig scene;
+    scene.grid = glm::ivec2(30, 20);
+    scene.size = glm::vec2(2.5f, 2.f);
+
+    ClothWorld world;
+    std::vector<std::unique_ptr<Flag>> flags;
+    std::vector<Flag*> flagPointers;
+    FlagCollisions flagCollisions;
+    try {
+        if (!scenePath.empty())
+            scene.loadFile(scenePath);
+        for (const auto& assignment : sceneOverrides)
+            scene.set(assignment);
+
+        // Rangées de 6 bannières assez proches pour que le vent les fasse se toucher
+        const int bannersPerRow = 6;
+        for (int b = 0; b < bannerCount; ++b) {
+            int column = b % bannersPerRow, row = b / bannersPerRow;
+            glm::vec3 offset((column - 0.5f * (bannersPerRow - 1)) * 1.1f * scene.size.x, 0.f, -0.6f * row);
+            if (independentFlags) {
+                flags.emplace_back(new Flag(scene.mass, scene.size.x, scene.size.y, scene.grid.x, scene.grid.y));
+                Flag& flag = *flags.back();
+                flag.K0 = scene.K0;
+                flag.K1 = scene.K1;
+                flag.K2 = scene.K2;
+                flag.V0 = scene.V0;
+                flag.V1 = scene.V1;
+                flag.V2 = scene.V2;
+                flag.sleepThreshold = scene.sleepThreshold;
+                flag.sleepFrames = scene.sleepFrames;
+                flag.wakeForceDelta = scene.wakeForceDelta;
+                flag.offset = offset;
+                flag.reset();
+                flagPointers.push_back(&flag);
+            } else {
+                world.addCloth(scene.grid, scene.size, glm::translate(glm::mat4(1.f), offset), scene);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (independentFlags)
+        std::cout << bannerCount << " independent flags: " << bannerCount * scene.grid.x * scene.grid.y << " particles" << std::endl;
+    else
+        std::cout << bannerCount << " banners: " << world.getParticleCount() << " particles, "
+                  << world.getSpringCount() << " springs" << std::endl;
+
+    SphereHandler sphereHandler;
+    sphereHandler.colors = scene.sphereColors;
+    sphereHandler.positions = scene.spherePositions;
+    sphereHandler.radius = scene.sphereRadius;
+
+    std::unique_ptr<WindowManager> wm(headlessDirectory.empty() ?
+        new WindowManager(WINDOW_WIDTH, WINDOW_HEIGHT, "Banners Simulation") :
+        new WindowManager(WINDOW_WIDTH, WINDOW_HEIGHT, headlessDirectory));
+    wm->setFramerate(60);
+
+    // Initialisation de AntTweakBar (pour la GUI)
+    TwInit(TW_OPENGL, NULL);
+    TwWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    bool wireframe = false;
+    int contactIterationsUsed = 0;
+
+    ThreadPool threadPool;
+
+    glm::mat4 projection = glm::perspective(70.f, float(WINDOW_WIDTH) / WINDOW_HEIGHT, 0.1f, 100.f);
+
+    // Un renderer par bannière: chacune a ses propres buffers
+    std::vector<std::unique_ptr<FlagRenderer3D>> renderers;
+    for (int c = 0; c < bannerCount; ++c) {
+        renderers.emplace_back(new FlagRenderer3D(scene.grid.x, scene.grid.y));
+        renderers.back()->setThreadPool(&threadPool);
+        renderers.back()->setProjMatrix(projection);
+    }
+
+    Renderer3D renderer3D;
+    renderer3D.setProjMatrix(projection);
+
+    TwBar* gui = TwNewBar("Parametres");
+
+    atb::addVarRW(gui, ATB_VAR(scene.sphereCollisionMultiplier), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(scene.radiusDelta), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(scene.maxDstRepulseForce), "step=0.01 min=0.01");
+    atb::addVarRW(gui, ATB_VAR(scene.multRepulseForce), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(scene.windVelocity), "label='Wind velocity' step=0.02");
+    atb::addVarRW(gui, ATB_VAR(scene.activeAutoCollisions));
+    atb::addVarRW(gui, ATB_VAR(scene.activeSpheres));
+    atb::addVarRW(gui, ATB_VAR(scene.activeContactSolver));
+    atb::addVarRW(gui, ATB_VAR(scene.contactIterations), "min=0 max=200");
+    atb::addVarRO(gui, ATB_VAR(contactIterationsUsed));
+    atb::addVarROCB(gui, "contacts", [&]() -> uint32_t {
+        if (!independentFlags)
+            return world.getSphereContacts().contacts().size() + world.getParticleContacts().contacts().size();
+        size_t count = flagCollisions.getMutualContacts().contacts().size();
+        for (const Flag* flag : flagPointers)
+            count += flag->sphereContacts.contacts().size() + flag->selfContacts.contacts().size();
+        return count;
+    });
+    if (independentFlags) {
+        atb::addVarROCB(gui, "mutualContacts", [&]() -> uint32_t {
+            return flagCollisions.getMutualContacts().contacts().size();
+        });
+        atb::addVarROCB(gui, "overlappingPairs", [&]() -> int32_t {
+            return flagCollisions.getOverlappingPairCount();
+        });
+    } else {
+        atb::addVarROCB(gui, "contactBatches", [&]() -> int32_t {
+            return world.getBatchCount();
+        });
+    }
+    atb::addVarRW(gui, ATB_VAR(wireframe));
+
+    atb::addButton(gui, "Reset", [&]() {
+        world.reset();
+        for (Flag* flag : flagPointers)
+            flag->reset();
+    });
+
+    // Pas des drapeaux indépendants, dans l'ordre de flag: forces, collisions, contacts puis intégration.
+    // FlagCollisions remplace l'octree de chaque drapeau par une grille commune
+    uint64_t flagFrame = 0;
+    auto stepFlags = [&](float dt) {
+        threadPool.resetFrameArenas();
+        RandomStream windStream(scene.seed, RANDOM_STREAM_WIND, flagFrame++);
+        glm::vec3 wind = windStream.sphericalRand(scene.windVelocity);
+        for (Flag* flag : flagPointers) {
+            flag->applyExternalForce(scene.gravity);
+            flag->applyExternalForce(wind);
+            flag->applyInternalForces(dt);
+            if (scene.activeSpheres && !scene.activeContactSolver)
+                flag->applySphereCollision(sphereHandler, scene.sphereCollisionMultiplier, scene.radiusDelta);
+        }
+
+        if (scene.activeAutoCollisions) {
+            flagCollisions.detect(flagPointers, scene.maxDstRepulseForce, scene.multRepulseForce, scene.activeContactSolver, threadPool);
+        } else {
+            for (Flag* flag : flagPointers)
+                flag->selfContacts.clear();
+        }
+
+        if (scene.activeContactSolver) {
+            contactIterationsUsed = 0;
+            for (Flag* flag : flagPointers) {
+                if (scene.activeSpheres)
+                    flag->detectSphereContacts(sphereHandler, scene.radiusDelta);
+                else
+                    flag->sphereContacts.clear();
+                contactIterationsUsed = std::max(contactIterationsUsed, flag->solveContacts(dt, scene.contactIterations));
+            }
+            if (scene.activeAutoCollisions)
+                contactIterationsUsed = std::max(contactIterationsUsed, flagCollisions.solveContacts(flagPointers, dt, scene.contactIterations));
+        }
+
+        for (Flag* flag : flagPointers)
+            flag->update(dt);
+    };
+
+    TrackballCamera camera;
+    camera.moveFront(16);
+    int mouseLastX, mouseLastY;
+
+    // Delta Time : temps s'écoulant entre chaque frame
+    float dt = 0.f;
+
+    bool done = false;
+    while(!done) {
+        wm->startMainLoop();
+
+        // Rendu
+        renderers[0]->clear();
+        renderer3D.setViewMatrix(camera.getViewMatrix());
+        for (int c = 0; c < bannerCount; ++c) {
+            renderers[c]->setViewMatrix(camera.getViewMatrix());
+            if (independentFlags)
+                renderers[c]->drawGrid(flagPointers[c]->positionArray.data(), wireframe);
+            else
+                renderers[c]->drawGrid(world.getPositions() + world.getCloth(c).firstParticle, wireframe);
+        }
+
+        if (scene.activeSpheres)
+            renderer3D.drawParticles(sphereHandler.positions.size(), sphereHandler.positions.data(), sphereHandler.radius.data(), sphereHandler.colors.data(), 1);
+
+        // Simulation
+        if (dt > 0.f) {
+            if (independentFlags)
+                stepFlags(dt);
+            else
+                contactIterationsUsed = world.step(dt, scene, sphereHandler, threadPool);
+        }
+
+        // GUI Display
+        if (!wm->isHeadless())
+            TwDraw();
+
+        // Gestion des evenements
+        SDL_Event e;
+        while(wm->pollEvent(e)) {
+            // Les évènements consommés par l'interface ne sont pas transmis à la scène
+            if (TwEventSDL(&e, SDL_MAJOR_VERSION, SDL_MINOR_VERSION))
+                continue;
+
+            switch(e.type) {
+                case SDL_QUIT:
+                    done = true;
+                    break;
+                case SDL_KEYDOWN:
+                    if (e.key.keysym.sym == SDLK_SPACE) {
+                        wireframe = !wireframe;
+                    }
+                    if (e.key.keysym.sym == SDLK_ESCAPE) {
+                        done = true;
+                    }
+                    break;
+                case SDL_MOUSEBUTTONDOWN:
+                    if (e.button.button == SDL_BUTTON_WHEELUP) {
+                        camera.moveFront(-0.4f);
+                    } else if (e.button.button == SDL_BUTTON_WHEELDOWN) {
+                        camera.moveFront(0.4f);
+                    }
+                    else if (e.button.button == SDL_BUTTON_LEFT) {
+                        mouseLastX = e.button.x;
+                        mouseLastY = e.button.y;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        int mouseX, mouseY;
+        if (!wm->isHeadless() && SDL_GetMouseState(&mouseX, &mouseY) & SDL_BUTTON(SDL_BUTTON_LEFT)) {
+            float dX = mouseX - mouseLastX, dY = mouseY - mouseLastY;
+            camera.rotateLeft(glm::radians(dX));
+            camera.rotateUp(glm::radians(dY));
+            mouseLastX = mouseX;
+            mouseLastY = mouseY;
+        }
+
+        // Mise à jour de la fenêtre
+        dt = wm->update();
+
+        if (wm->isHeadless() && --headlessFrameCount <= 0)
+            done = true;
+    }
+
+    return EXIT_SUCCESS;
+}
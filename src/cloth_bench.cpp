@@ -0,0 +1,468 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+
+#include <PartyKel/glm.hpp>
+#include <PartyKel/renderer/Sphere.hpp>
+#include <PartyKel/Octree.hpp>
+#include <PartyKel/ThreadPool.hpp>
+#include <PartyKel/GridMesh.hpp>
+#include <PartyKel/Random.hpp>
+#include <PartyKel/Forces.hpp>
+#include <PartyKel/Flag.hpp>
+#include <PartyKel/AllocationCounter.hpp>
+#include <PartyKel/SceneConfig.hpp>
+#include <PartyKel/ClothWorld.hpp>
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+using namespace PartyKel;
+
+// Microbenchmarks des chemins critiques de la simulation, sans fenêtre ni OpenGL.
+// Les résultats sont écrits en JSON (temps par itération et débit) afin de comparer deux versions:
+//
+//   cloth_bench [--filter <texte>] [--min-time <ms>] [--samples <n>] [--output <fichier>]
+//
+// cloth_bench --check-allocations vérifie qu'un pas complet de la simulation n'alloue plus de mémoire
+// une fois les tableaux et l'octree dimensionnés (nécessite PARTYKEL_ENABLE_PROFILING)
+//
+// cloth_bench --check-sleeping vérifie que les tuiles du drapeau de la scène par défaut s'endorment
+// et restent endormies sous le vent de la scène (voir Flag::sleepThreshold)
+
+// Empêche le compilateur de supprimer un calcul dont le résultat n'est pas utilisé
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+class BenchmarkRunner {
+public:
+    struct Result {
+        std::string name;
+        std::vector<std::pair<std::string, double>> parameters;
+        uint64_t iterations;        // Itérations par échantillon
+        std::vector<double> samples; // Temps par itération de chaque échantillon (ns)
+        double itemsPerIteration;   // Éléments traités par itération (particules, ressorts...)
+    };
+
+    BenchmarkRunner(const std::string& filter, double minSampleMilliseconds, int sampleCount):
+        m_Filter(filter), m_fMinSampleMilliseconds(minSampleMilliseconds), m_nSampleCount(sampleCount) {
+    }
+
+    bool isEnabled(const std::string& name) const {
+        return m_Filter.empty() || name.find(m_Filter) != std::string::npos;
+    }
+
+    // Mesure body (une itération): le nombre d'itérations est augmenté jusqu'à ce qu'un échantillon
+    // dure au moins minSampleMilliseconds, puis sampleCount échantillons sont mesurés
+    void run(const std::string& name, const std::vector<std::pair<std::string, double>>& parameters,
+             double itemsPerIteration, const std::function<void()>& body) {
+        Result result;
+        result.name = name;
+        result.parameters = parameters;
+        result.itemsPerIteration = itemsPerIteration;
+
+        result.iterations = 1;
+        while (true) {
+            double milliseconds = measure(body, result.iterations) * 1e-6;
+            if (milliseconds >= m_fMinSampleMilliseconds || result.iterations >= (uint64_t(1) << 40))
+                break;
+            // Saut direct vers l'estimation, au plus x100, pour ne pas doubler indéfiniment sur les corps rapides
+            double scale = milliseconds > 0. ? 1.2 * m_fMinSampleMilliseconds / milliseconds : 100.;
+            result.iterations = std::max(result.iterations * 2, uint64_t(result.iterations * std::min(scale, 100.)));
+        }
+
+        for (int s = 0; s < m_nSampleCount; ++s) {
+            result.samples.push_back(measure(body, result.iterations) / result.iterations);
+        }
+
+        std::vector<double> sorted = result.samples;
+        std::sort(sorted.begin(), sorted.end());
+        std::cerr << name;
+        for (const auto& parameter : parameters)
+            std::cerr << " " << parameter.first << "=" << parameter.second;
+        std::cerr << ": " << sorted[sorted.size() / 2] << " ns" << std::endl;
+
+        m_Results.push_back(result);
+    }
+
+    void writeJSON(std::ostream& out) const;
+
+private:
+    // Durée totale de iterations appels à body (ns)
+    static double measure(const std::function<void()>& body, uint64_t iterations) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            body();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::string m_Filter;
+    double m_fMinSampleMilliseconds;
+    int m_nSampleCount;
+    std::vector<Result> m_Results;
+};
+
+void BenchmarkRunner::writeJSON(std::ostream& out) const {
+    out.precision(10);
+    out << "{\n  \"context\": {\n";
+#ifdef __OPTIMIZE__
+    out << "    \"optimized\": true,\n";
+#else
+    out << "    \"optimized\": false,\n";
+#endif
+    out << "    \"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "    \"minSampleMilliseconds\": " << m_fMinSampleMilliseconds << ",\n";
+    out << "    \"samples\": " << m_nSampleCount << "\n  },\n";
+
+    out << "  \"benchmarks\": [";
+    for (size_t r = 0; r < m_Results.size(); ++r) {
+        const Result& result = m_Results[r];
+        std::vector<double> sorted = result.samples;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = 0.;
+        for (double sample : sorted)
+            mean += sample / sorted.size();
+        double median = sorted[sorted.size() / 2];
+
+        out << (r ? ",\n" : "\n") << "    {\n";
+        out << "      \"name\": \"" << result.name << "\",\n";
+        out << "      \"parameters\": {";
+        for (size_t p = 0; p < result.parameters.size(); ++p) {
+            out << (p ? ", " : "") << "\"" << result.parameters[p].first << "\": " << result.parameters[p].second;
+        }
+        out << "},\n";
+        out << "      \"iterations\": " << result.iterations << ",\n";
+        out << "      \"nsPerIteration\": { \"min\": " << sorted.front() << ", \"median\": " << median
+            << ", \"mean\": " << mean << ", \"max\": " << sorted.back() << " },\n";
+        out << "      \"itemsPerSecond\": " << result.itemsPerIteration * 1e9 / median << "\n";
+        out << "    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// Petites perturbations des positions pour que les ressorts ne soient pas tous au repos
+static void perturb(Flag& flag, float amplitude) {
+    RandomStream random(1, 0, 0);
+    for (auto& position : flag.positionArray)
+        position += glm::vec3(random.nextFloat(-1.f, 1.f), random.nextFloat(-1.f, 1.f), random.nextFloat(-1.f, 1.f)) * amplitude;
+}
+
+static void benchForces(BenchmarkRunner& runner) {
+    const int pairCount = 4096;
+    RandomStream random(2, 0, 0);
+    std::vector<glm::vec3> P1(pairCount), P2(pairCount), v1(pairCount), v2(pairCount);
+    for (int k = 0; k < pairCount; ++k) {
+        P1[k] = glm::vec3(random.nextFloat(), random.nextFloat(), random.nextFloat());
+        P2[k] = P1[k] + glm::vec3(random.nextFloat(-0.2f, 0.2f), random.nextFloat(-0.2f, 0.2f), random.nextFloat(-0.2f, 0.2f));
+        v1[k] = random.sphericalRand(0.1f);
+        v2[k] = random.sphericalRand(0.1f);
+    }
+
+    if (runner.isEnabled("hookForce")) {
+        runner.run("hookForce", { { "pairs", pairCount } }, pairCount, [&]() {
+            glm::vec3 F(0.f);
+            for (int k = 0; k < pairCount; ++k)
+                F += hookForce(1.f, 0.1f, P1[k], P2[k]);
+            doNotOptimize(F);
+        });
+    }
+
+    if (runner.isEnabled("brakeForce")) {
+        runner.run("brakeForce", { { "pairs", pairCount } }, pairCount, [&]() {
+            glm::vec3 F(0.f);
+            for (int k = 0; k < pairCount; ++k)
+                F += brakeForce(0.08f, 0.016f, v1[k], v2[k]);
+            doNotOptimize(F);
+        });
+    }
+}
+
+static void benchInternalForces(BenchmarkRunner& runner) {
+    if (!runner.isEnabled("Flag::applyInternalForces"))
+        return;
+
+    for (int size = 32; size <= 1024; size *= 2) {
+        Flag flag(1.f, 8.f, 8.f, size, size);
+        perturb(flag, 0.1f * flag.L0.x);
+        runner.run("Flag::applyInternalForces", { { "gridSize", size } }, flag.nbParticles, [&]() {
+            flag.applyInternalForces(0.016f);
+            doNotOptimize(flag.forceArray[0]);
+        });
+    }
+}
+
+static void benchOctree(BenchmarkRunner& runner) {
+    if (!runner.isEnabled("Octree"))
+        return;
+
+    for (int size = 64; size <= 256; size *= 2) {
+        Flag flag(1.f, 8.f, 8.f, size, size);
+        perturb(flag, 0.5f * flag.L0.x);
+        Octree<int> octree(7, glm::vec3(0.f, -10.f, 0.f), glm::vec3(50.f));
+
+        // Cycle d'une frame: insertion de toutes les particules, une requête par particule, suppression
+        runner.run("Octree::add+get+remove", { { "gridSize", size }, { "depth", 7 } }, flag.nbParticles, [&]() {
+            size_t found = 0;
+            for (int k = 0; k < flag.nbParticles; ++k)
+                octree.add(k, flag.positionArray[k]);
+            for (int k = 0; k < flag.nbParticles; ++k)
+                found += octree.get(flag.positionArray[k]).size();
+            for (int k = 0; k < flag.nbParticles; ++k)
+                octree.remove(k, flag.positionArray[k]);
+            doNotOptimize(found);
+        });
+    }
+}
+
+static void benchSphereCollision(BenchmarkRunner& runner) {
+    if (!runner.isEnabled("Flag::applySphereCollision"))
+        return;
+
+    const int size = 256;
+    Flag flag(1.f, 8.f, 3.f, size, size);
+
+    for (int sphereCount = 1; sphereCount <= 64; sphereCount *= 4) {
+        // Sphères réparties devant le drapeau, dont une partie le touche
+        SphereHandler sphereHandler;
+        RandomStream random(3, 0, sphereCount);
+        for (int s = 0; s < sphereCount; ++s) {
+            sphereHandler.positions.push_back(glm::vec3(random.nextFloat(-4.f, 4.f), random.nextFloat(0.f, 3.f), random.nextFloat(-0.5f, 1.5f)));
+            sphereHandler.radius.push_back(random.nextFloat(0.2f, 1.f));
+            sphereHandler.colors.push_back(glm::vec3(1.f));
+        }
+
+        runner.run("Flag::applySphereCollision", { { "gridSize", size }, { "spheres", sphereCount } }, flag.nbParticles, [&]() {
+            flag.applySphereCollision(sphereHandler, 1.5f, 0.15f);
+            doNotOptimize(flag.forceArray[0]);
+        });
+    }
+}
+
+// Passe CPU de FlagRenderer3D::drawGrid (normales des faces puis des sommets), sans l'envoi au GPU
+static void benchNormals(BenchmarkRunner& runner, ThreadPool& pool) {
+    if (!runner.isEnabled("computeGridNormals"))
+        return;
+
+    for (int size = 256; size <= 1024; size *= 4) {
+        Flag flag(1.f, 8.f, 8.f, size, size);
+        perturb(flag, 0.5f * flag.L0.x);
+        std::vector<glm::vec3> faceNormals(2 * (size - 1) * (size - 1)), normals(size * size);
+
+        runner.run("computeGridNormals", { { "gridSize", size }, { "threads", 1 } }, flag.nbParticles, [&]() {
+            computeGridNormals(flag.positionArray.data(), size, size, faceNormals.data(), normals.data());
+            doNotOptimize(normals[0]);
+        });
+        if (pool.getThreadCount() < 2)
+            continue;
+        runner.run("computeGridNormals", { { "gridSize", size }, { "threads", double(pool.getThreadCount()) } }, flag.nbParticles, [&]() {
+            computeGridNormals(flag.positionArray.data(), size, size, faceNormals.data(), normals.data(), &pool);
+            doNotOptimize(normals[0]);
+        });
+    }
+}
+
+// Pas complet de la boucle principale de flag: forces, collisions, octree, contacts et intégration
+static void stepFlag(Flag& flag, Octree<int>& octree, const SphereHandler& sphereHandler, const SceneConfig& scene, uint64_t frame,
+                     ThreadPool& pool) {
+    const float dt = 1.f / 60.f;
+    pool.resetFrameArenas();
+    flag.applyExternalForce(scene.gravity);
+    RandomStream wind(scene.seed, RANDOM_STREAM_WIND, frame);
+    flag.applyExternalForce(wind.sphericalRand(scene.windVelocity));
+    flag.applyInternalForces(dt);
+
+    // Le solveur de contacts est actif: il remplace la force de pénalité des sphères et la répulsion
+    // des paires non voisines
+    for (int k = 0; k < flag.nbParticles; ++k)
+        octree.add(k, flag.positionArray[k]);
+    flag.applyRepulseForces(octree, scene.maxDstRepulseForce, scene.multRepulseForce, true);
+    flag.detectSphereContacts(sphereHandler, scene.radiusDelta);
+    flag.detectSelfContacts(octree, scene.maxDstRepulseForce, &pool);
+    for (int k = 0; k < flag.nbParticles; ++k)
+        octree.remove(k, flag.positionArray[k]);
+
+    flag.solveContacts(dt, scene.contactIterations);
+    flag.update(dt);
+}
+
+// Pas de plusieurs bannières: une à une avec Flag, ou toutes ensemble dans un ClothWorld
+static void benchClothWorld(BenchmarkRunner& runner, ThreadPool& pool) {
+    SceneConfig scene;
+    SphereHandler sphereHandler;
+    sphereHandler.positions = scene.spherePositions;
+    sphereHandler.radius = scene.sphereRadius;
+    sphereHandler.colors = scene.sphereColors;
+    const glm::ivec2 grid(30, 20);
+    const glm::vec2 size(2.5f, 2.f);
+
+    for (int bannerCount = 1; bannerCount <= 32; bannerCount *= 4) {
+        double particleCount = double(bannerCount) * grid.x * grid.y;
+
+        if (runner.isEnabled("Flag step")) {
+            std::vector<Flag> flags(bannerCount, Flag(scene.mass, size.x, size.y, grid.x, grid.y));
+            Octree<int> octree(scene.octreeDepth, scene.octreeCenter, scene.octreeSize);
+            uint64_t frame = 0;
+            runner.run("Flag step", { { "banners", bannerCount } }, particleCount, [&]() {
+                for (auto& flag : flags)
+                    stepFlag(flag, octree, sphereHandler, scene, frame, pool);
+                ++frame;
+                doNotOptimize(flags[0].positionArray[0]);
+            });
+        }
+
+        if (runner.isEnabled("ClothWorld::step")) {
+            ClothWorld world;
+            for (int b = 0; b < bannerCount; ++b) {
+                glm::vec3 offset((b % 8) * 3.f - 10.5f, 0.f, (b / 8) * 1.5f);
+                world.addCloth(grid, size, glm::translate(glm::mat4(1.f), offset), scene);
+            }
+            runner.run("ClothWorld::step", { { "banners", bannerCount }, { "threads", double(pool.getThreadCount()) } }, particleCount, [&]() {
+                world.step(1.f / 60.f, scene, sphereHandler, pool);
+                doNotOptimize(world.getPositions()[0]);
+            });
+        }
+    }
+}
+
+// Renvoie EXIT_FAILURE si un pas alloue encore de la mémoire après la mise en route
+static int checkStepAllocations(ThreadPool& pool) {
+    if (!isAllocationCountingEnabled()) {
+        std::cerr << "--check-allocations requires a build with PARTYKEL_ENABLE_PROFILING" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Scène par défaut, avec une sphère sur laquelle le drapeau reste appuyé
+    const int warmUpSteps = 1000, checkedSteps = 1000;
+    SceneConfig scene;
+    Flag flag(scene.mass, scene.size.x, scene.size.y, scene.grid.x, scene.grid.y);
+    Octree<int> octree(scene.octreeDepth, scene.octreeCenter, scene.octreeSize);
+    SphereHandler sphereHandler;
+    sphereHandler.positions = { glm::vec3(0.f, 1.5f, -1.f) };
+    sphereHandler.radius = { 1.1f };
+    sphereHandler.colors = { glm::vec3(1.f) };
+
+    // La mise en route doit avoir dimensionné les contacts: sinon la vérification ne prouve rien
+    uint64_t frame = 0;
+    size_t maxContacts = 0;
+    for (int step = 0; step < warmUpSteps; ++step) {
+        stepFlag(flag, octree, sphereHandler, scene, frame++, pool);
+        maxContacts = std::max(maxContacts, flag.sphereContacts.contacts().size());
+    }
+    if (!maxContacts) {
+        std::cerr << "Allocation check: the flag does not touch the sphere" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint64_t worstStep = 0, total = 0;
+    for (int step = 0; step < checkedSteps; ++step) {
+        uint64_t before = getAllocationCount();
+        stepFlag(flag, octree, sphereHandler, scene, frame++, pool);
+        uint64_t allocations = getAllocationCount() - before;
+        worstStep = std::max(worstStep, allocations);
+        total += allocations;
+    }
+
+    std::cout << "Heap allocations over " << checkedSteps << " steps after " << warmUpSteps << " warm-up steps: "
+              << total << " (at most " << worstStep << " in one step)" << std::endl;
+    return total == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Renvoie EXIT_FAILURE si les tuiles ne s'endorment pas, ou si le vent aléatoire les réveille
+static int checkSleeping(ThreadPool& pool) {
+    // Scène par défaut (celle de scenes/flag.scene), avec le seuil conseillé par le Readme
+    const int settleSteps = 5000, checkedSteps = 2000;
+    SceneConfig scene;
+    Flag flag(scene.mass, scene.size.x, scene.size.y, scene.grid.x, scene.grid.y);
+    flag.sleepThreshold = 0.0003f;
+    Octree<int> octree(scene.octreeDepth, scene.octreeCenter, scene.octreeSize);
+    SphereHandler sphereHandler;
+    sphereHandler.positions = scene.spherePositions;
+    sphereHandler.radius = scene.sphereRadius;
+    sphereHandler.colors = scene.sphereColors;
+
+    uint64_t frame = 0;
+    for (int step = 0; step < settleSteps; ++step)
+        stepFlag(flag, octree, sphereHandler, scene, frame++, pool);
+
+    int tileCount = flag.tileCountX * flag.tileCountY;
+    int sleepingTiles = flag.getSleepingTileCount();
+    int wokenTiles = 0;
+    std::vector<uint8_t> wasAwake;
+    for (int step = 0; step < checkedSteps; ++step) {
+        wasAwake = flag.tileAwakeArray;
+        stepFlag(flag, octree, sphereHandler, scene, frame++, pool);
+        for (int tile = 0; tile < tileCount; ++tile)
+            wokenTiles += !wasAwake[tile] && flag.tileAwakeArray[tile];
+    }
+
+    std::cout << "Sleeping tiles after " << settleSteps << " steps: " << sleepingTiles << " / " << tileCount
+              << ", woken during the next " << checkedSteps << " steps: " << wokenTiles << std::endl;
+    return sleepingTiles == tileCount && wokenTiles == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char** argv) {
+    std::string filter, outputPath;
+    double minSampleMilliseconds = 50.;
+    int sampleCount = 5;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            minSampleMilliseconds = std::atof(argv[++i]);
+        } else if (arg == "--samples" && i + 1 < argc) {
+            sampleCount = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--check-allocations") {
+            ThreadPool pool;
+            return checkStepAllocations(pool);
+        } else if (arg == "--check-sleeping") {
+            ThreadPool pool;
+            return checkSleeping(pool);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter <text>] [--min-time <ms>] [--samples <n>] [--output <file>]" << std::endl;
+            std::cerr << "       " << argv[0] << " --check-allocations" << std::endl;
+            std::cerr << "       " << argv[0] << " --check-sleeping" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+#ifndef __OPTIMIZE__
+    std::cerr << "Warning: cloth_bench was built without optimizations, timings are not representative" << std::endl;
+#endif
+
+    BenchmarkRunner runner(filter, minSampleMilliseconds, sampleCount);
+    ThreadPool pool;
+
+    benchForces(runner);
+    benchInternalForces(runner);
+    benchOctree(runner);
+    benchSphereCollision(runner);
+    benchNormals(runner, pool);
+    benchClothWorld(runner, pool);
+
+    if (outputPath.empty()) {
+        runner.writeJSON(std::cout);
+    } else {
+        std::ofstream out(outputPath);
+        runner.writeJSON(out);
+        if (!out) {
+            std::cerr << "Unable to write " << outputPath << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -3,7 +3,6 @@
 
 #include <PartyKel/glm.hpp>
 #include <PartyKel/WindowManager.hpp>
-#include <glm/gtc/random.hpp>
 
 #include <PartyKel/renderer/FlagRenderer3D.hpp>
 #include <PartyKel/renderer/TrackballCamera.hpp>
@@ -11,254 +10,175 @@
 #include <PartyKel/renderer/Sphere.hpp>
 #include <PartyKel/atb.hpp>
 #include <PartyKel/Octree.hpp>
+#include <PartyKel/ContactCache.hpp>
+#include <PartyKel/ThreadPool.hpp>
+#include <PartyKel/Checkpoint.hpp>
+#include <PartyKel/SimulationCache.hpp>
+#include <PartyKel/SimulationPlayback.hpp>
+#include <PartyKel/MeshSequenceExporter.hpp>
+#include <PartyKel/GridMesh.hpp>
+#include <PartyKel/SceneConfig.hpp>
+#include <PartyKel/Random.hpp>
+#include <PartyKel/Flag.hpp>
+#include <PartyKel/Profiler.hpp>
+#include <PartyKel/AllocationCounter.hpp>
 
 #include <vector>
+#include <string>
+#include <memory>
+#include <stdexcept>
 
 static const Uint32 WINDOW_WIDTH = 900;
 static const Uint32 WINDOW_HEIGHT = 700;
 
 using namespace PartyKel;
 
-// Calcule une force de type ressort de Hook entre deux particules de positions P1 et P2
-// K est la résistance du ressort et L sa longueur à vide
-inline glm::vec3 hookForce(float K, float L, const glm::vec3& P1, const glm::vec3& P2) {
-    static const float epsilon = 0.0001;
-    return K * (1-(L/std::max(glm::distance(P1, P2), epsilon))) * (P2 - P1);
-}
-
-inline glm::vec3 repulseForce(float dst, const glm::vec3& P1, const glm::vec3& P2) {
-    glm::vec3 direction = glm::normalize(P1 - P2);
-    return direction * (1 / (1 + glm::pow(dst, 2.f)));
-}
-
-// Calcule une force de type frein cinétique entre deux particules de vélocités v1 et v2
-// V est le paramètre du frein
-// dt est le pas temporel (delta time)
-inline glm::vec3 brakeForce(float V, float dt, const glm::vec3& v1, const glm::vec3& v2) {
-    return V * ((v2-v1) / dt);
-}
-
-inline glm::vec3 sphereCollisionForce(float distanceToCenter, 
-                                      const glm::vec3& sphereCenter,
-                                      float sphereRadius, 
-                                      const glm::vec3 particlePosition, 
-                                      const glm::vec3& forceParticle) {
-    glm::vec3 direction = glm::normalize(particlePosition - sphereCenter);
-    return direction * (1 / (1 + glm::pow(distanceToCenter, 2.f)));
-}
-
-// Structure permettant de simuler un drapeau à l'aide un système masse-ressort
-struct Flag {
-    int gridWidth, gridHeight; // Dimensions de la grille de points
-
-    // Propriétés physique des points:
-    std::vector<glm::vec3> positionArray;
-    std::vector<glm::vec3> velocityArray;
-    std::vector<float> massArray;
-    std::vector<glm::vec3> forceArray;
-    int nbParticles;
-
-    // Paramètres des forces interne de simulation
-    // Longueurs à vide
-    glm::vec2 L0;
-    float L1;
-    glm::vec2 L2;
-
-    float K0, K1, K2; // Paramètres de résistance
-    float V0, V1, V2; // Paramètres de frein
-
-    // Créé un drapeau discretisé sous la forme d'une grille contenant gridWidth * gridHeight
-    // points. Chaque point a pour masse : mass / (gridWidth * gridHeight).
-    // La taille du drapeau en 3D est spécifié par les paramètres width et height
-    Flag(float mass, float width, float height, int gridWidth, int gridHeight):
-            gridWidth(gridWidth), gridHeight(gridHeight),
-            positionArray(gridWidth * gridHeight),
-            velocityArray(gridWidth * gridHeight, glm::vec3(0.f)),
-            massArray(gridWidth * gridHeight, mass / (gridWidth * gridHeight)),
-            forceArray(gridWidth * gridHeight, glm::vec3(0.f)) {
-
-        // glm::vec3 origin(-0.5f * width, -0.5f * height, 0.f);
-        glm::vec3 origin(-0.5f * width, 0.f, 0.f);
-        glm::vec3 scale(width / (gridWidth - 1), height / (gridHeight - 1), 1.f);
-
-        nbParticles = gridWidth * gridHeight;
-        for (int j = 0; j < gridHeight; ++j) {
-            for (int i = 0; i < gridWidth; ++i) {
-                int k = i + j * gridWidth;
-                positionArray[k] = origin + glm::vec3(i, j, origin.z) * scale;
-                massArray[k] = 1 - ( i / (2*(gridHeight*gridWidth)));
-            }
-        }
-
-        // Les longueurs à vide sont calculés à partir de la position initiale
-        // des points sur le drapeau
-        L0.x = scale.x;
-        L0.y = scale.y;
-        L1 = glm::length(L0);
-        L2 = 4.f * L0;
-
-        // Paramètres à fixer pour avoir un système stable
-        K0 = 1;
-        K1 = 1;
-        K2 = 1;
-
-        V0 = 0.08;
-        V1 = 0.02;
-        V2 = 0.06;
-    }
-
-    // Applique les forces internes sur chaque point du drapeau SAUF les points fixes
-    void applyInternalForces(float dt) {
-        std::vector<glm::ivec2> neighbors(4);
-        for (int i = 0; i < gridWidth; ++i) {
-            for (int j = 0; j < gridHeight-1; ++j) {
-                int currentK = j*gridWidth + i;
-
-                // TOPOLOGY 1
-                neighbors[0] = glm::ivec2(i+1, j);
-                neighbors[1] = glm::ivec2(i-1, j);
-                neighbors[2] = glm::ivec2(i, j-1);
-                neighbors[3] = glm::ivec2(i, j+1);
-
-                int tmpI = 0;
-                for (auto& p : neighbors) {
-                    if (p.x < 0 || p.y < 0 || p.x >= gridWidth || p.y >= gridHeight)
-                        continue;
-                    int k = p.y * gridWidth + p.x;
-                    forceArray[currentK] += hookForce(K0, tmpI < 2 ? L0.x : L0.y, positionArray[currentK], positionArray[k]);
-                    forceArray[currentK] += brakeForce(V0, dt, velocityArray[currentK], velocityArray[k]);
-                    ++tmpI;
-                }
-
-                // TOPOLOGY 2
-                neighbors[0] = glm::ivec2(i-1, j-1);
-                neighbors[1] = glm::ivec2(i+1, j-1);
-                neighbors[2] = glm::ivec2(i+1, j+1);
-                neighbors[3] = glm::ivec2(i-1, j+1);
-
-                for (auto& p : neighbors) {
-                    if (p.x < 0 || p.y < 0 || p.x >= gridWidth || p.y >= gridHeight)
-                        continue;
-                    int k = p.y * gridWidth + p.x;
-                    forceArray[currentK] += hookForce(K1, L1, positionArray[currentK], positionArray[k]);
-                    forceArray[currentK] += brakeForce(V1, dt, velocityArray[currentK], velocityArray[k]);
-                }
-
-                // TOPOLOGY 3
-                neighbors[0] = glm::ivec2(i-2, j);
-                neighbors[1] = glm::ivec2(i+2, j);
-                neighbors[2] = glm::ivec2(i, j-2);
-                neighbors[3] = glm::ivec2(i, j+2);
-
-                tmpI = 0;
-                for (auto& p : neighbors) {
-                    if (p.x < 0 || p.y < 0 || p.x >= gridWidth || p.y >= gridHeight)
-                        continue;
-                    int k = p.y * gridWidth + p.x;
-                    forceArray[currentK] += hookForce(K2, tmpI < 2 ? L2.x : L2.y, positionArray[currentK], positionArray[k]);
-                    forceArray[currentK] += brakeForce(V2, dt, velocityArray[currentK], velocityArray[k]);
-                    ++tmpI;
-                }
-
-            }
-        }
-    }
-
-    void applyRepulseForces(Octree<glm::vec3>& octree, float maxDst, float multRepulse) {
-        for (int i = 0; i < gridWidth; ++i) {
-            for (int j = 0; j < gridHeight-1; ++j) {
-                int k = j*gridWidth + i;
-                auto& pos = positionArray[k];
-
-                auto &inSameVoxel = octree.get(pos);
-                assert(!inSameVoxel.empty());
-
-                if (inSameVoxel.size() < 2)
-                    continue;
-
-                for (auto &v : inSameVoxel) {
-                    float dst = glm::distance(v, pos);
-                    if (dst > maxDst || pos == v)
-                        continue;
-
-                    forceArray[k] += repulseForce(dst, pos, v) * multRepulse;
-                }
-            }
-        }
-    }
-
-    // Applique une force externe sur chaque point du drapeau SAUF les points fixes
-    void applyExternalForce(const glm::vec3& F) {
-        for (int i = 0; i < nbParticles; ++i) {
-            // if (i % gridWidth == 0) continue;
-            if (i > nbParticles - gridWidth-1) continue;
-            forceArray[i] += F;
-        }
-    }
-
-    void applySphereCollision(const SphereHandler& sphereHandler, float multiplier, float radiusDelta) {
-        for (int i = 0; i < nbParticles; ++i) {
-            // if (i % gridWidth == 0) continue;
-            if (i > nbParticles - gridWidth-1) continue;
-
-            for (size_t j = 0; j < sphereHandler.positions.size(); ++j) {
-                float dist = glm::distance(sphereHandler.positions[j], positionArray[i]);
-                if (dist < sphereHandler.radius[j] + radiusDelta) {
-                    forceArray[i] += sphereCollisionForce(dist, sphereHandler.positions[j], sphereHandler.radius[j], positionArray[i], forceArray[i]) * multiplier;
-                }
+int main(int argc, char** argv) {
+    // flag --headless <dossier> [nombre de frames]: rendu hors écran d'une séquence d'images
+    // flag --restore <fichier>: reprend la simulation depuis une sauvegarde
+    // flag --save <fichier>: sauvegarde l'état de la simulation en quittant
+    // flag --record <fichier> [pas de quantification]: enregistre les positions de chaque frame
+    // flag --record-normals: enregistre aussi les normales, pour une relecture sans calcul
+    // flag --play <fichier>: relit un enregistrement au lieu de simuler
+    // flag --export <dossier> [ply|obj]: exporte le maillage de chaque frame (topologie dans topology.<ext>)
+    // flag --export-embed-topology: chaque fichier exporté est un maillage complet
+    // flag --scene <fichier>: paramètres de la scène (voir SceneConfig.hpp)
+    // flag --set clé=valeur: remplace un paramètre de la scène (peut être répété)
+    // flag --trace <fichier>: enregistre la chronologie des frames dès le lancement (voir Tracer.hpp)
+    // flag --dt <secondes>: pas de temps fixe, au lieu de la durée mesurée de chaque frame
+    std::string headlessDirectory;
+    int headlessFrameCount = 600;
+    std::string restorePath, savePath;
+    std::string recordPath, playPath;
+    std::string exportDirectory;
+    MeshSequenceExporter::Format exportFormat = MeshSequenceExporter::Format::BinaryPLY;
+    bool exportEmbedTopology = false;
+    float recordQuantizationStep = 0.f; // 0: positions enregistrées en float
+    bool recordNormals = false;
+    std::string scenePath;
+    std::vector<std::string> sceneOverrides;
+    std::string tracePath;
+    float fixedDt = 0.f; // 0: pas de temps mesuré (fixe en mode --headless)
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless" && i + 1 < argc) {
+            headlessDirectory = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                headlessFrameCount = std::atoi(argv[++i]);
+        } else if (arg == "--restore" && i + 1 < argc) {
+            restorePath = argv[++i];
+        } else if (arg == "--save" && i + 1 < argc) {
+            savePath = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                recordQuantizationStep = std::atof(argv[++i]);
+        } else if (arg == "--record-normals") {
+            recordNormals = true;
+        } else if (arg == "--play" && i + 1 < argc) {
+            playPath = argv[++i];
+        } else if (arg == "--export" && i + 1 < argc) {
+            exportDirectory = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                if (std::string(argv[++i]) == "obj")
+                    exportFormat = MeshSequenceExporter::Format::OBJ;
             }
+        } else if (arg == "--export-embed-topology") {
+            exportEmbedTopology = true;
+        } else if (arg == "--scene" && i + 1 < argc) {
+            scenePath = argv[++i];
+        } else if (arg == "--set" && i + 1 < argc) {
+            sceneOverrides.push_back(argv[++i]);
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "--dt" && i + 1 < argc) {
+            fixedDt = std::atof(argv[++i]);
         }
     }
 
-    // Met à jour la vitesse et la position de chaque point du drapeau
-    // en utilisant un schema de type Leapfrog
-    void update(float dt) {
-        for (int i = 0; i < nbParticles ; ++i) {
-            velocityArray[i] += dt * (forceArray[i]/massArray[i]);
-            positionArray[i] += dt * velocityArray[i];
-            forceArray[i] = glm::vec3(0);
+    // Scène: valeurs par défaut, puis fichier de scène, puis surcharges de la ligne de commande
+    auto readScene = [&](SceneConfig& config) {
+        try {
+            config = SceneConfig();
+            if (!scenePath.empty())
+                config.loadFile(scenePath);
+            for (const auto& assignment : sceneOverrides)
+                config.set(assignment);
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return false;
         }
-    }
-};
+    };
 
-int main() {
+    SceneConfig scene;
+    if (!readScene(scene))
+        return EXIT_FAILURE;
 
     SphereHandler sphereHandler;
-    sphereHandler.colors = {glm::vec3(1, 0, 0), glm::vec3(1, 1, 0), glm::vec3(0, 1, 0)};
-    sphereHandler.positions = {glm::vec3(0, -3, 2), glm::vec3(1.5, -3.5, 0.7), glm::vec3(3, -2, -1.5)};
-    sphereHandler.radius = {2, 1.5, .8};
-    float sphereCollisionMultiplier = 1.5;
-    float radiusDelta = 0.15;
-    glm::ivec2 flagGrid = glm::ivec2(70, 30);
-    glm::ivec2 flagSize = glm::ivec2(8, 3);
-    float flagMass = 1.f;
-
-    WindowManager wm(WINDOW_WIDTH, WINDOW_HEIGHT, "Flag Simulation");
-    wm.setFramerate(60);
+    sphereHandler.colors = scene.sphereColors;
+    sphereHandler.positions = scene.spherePositions;
+    sphereHandler.radius = scene.sphereRadius;
+    float sphereCollisionMultiplier = scene.sphereCollisionMultiplier;
+    float radiusDelta = scene.radiusDelta;
+
+    std::unique_ptr<WindowManager> wm(headlessDirectory.empty() ?
+        new WindowManager(WINDOW_WIDTH, WINDOW_HEIGHT, "Flag Simulation") :
+        new WindowManager(WINDOW_WIDTH, WINDOW_HEIGHT, headlessDirectory));
+    wm->setFramerate(60);
 
     // Initialisation de AntTweakBar (pour la GUI)
     TwInit(TW_OPENGL, NULL);
     TwWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
 
-    Flag flag(flagMass, flagSize.x, flagSize.y, flagGrid.x, flagGrid.y); // Création d'un drapeau
-    glm::vec3 G(0.f, -0.05f, 0.f); // Gravité
-
-    float maxDstRepulseForce    = 0.17;
-    float multRepulseForce      = 0.1;
-    bool activeSpheres          = true;
-    bool activeAutoCollisions   = true;
+    // Création d'un drapeau
+    auto createFlag = [&]() {
+        Flag flag(scene.mass, scene.size.x, scene.size.y, scene.grid.x, scene.grid.y);
+        flag.K0 = scene.K0;
+        flag.K1 = scene.K1;
+        flag.K2 = scene.K2;
+        flag.V0 = scene.V0;
+        flag.V1 = scene.V1;
+        flag.V2 = scene.V2;
+        flag.sleepThreshold = scene.sleepThreshold;
+        flag.sleepFrames = scene.sleepFrames;
+        flag.wakeForceDelta = scene.wakeForceDelta;
+        return flag;
+    };
+    Flag flag = createFlag();
+    glm::vec3 G = scene.gravity; // Gravité
+
+    float maxDstRepulseForce    = scene.maxDstRepulseForce;
+    float multRepulseForce      = scene.multRepulseForce;
+    bool activeSpheres          = scene.activeSpheres;
+    bool activeAutoCollisions   = scene.activeAutoCollisions;
+    bool activeContactSolver    = scene.activeContactSolver;
+    int contactIterations       = scene.contactIterations;
+    int contactIterationsUsed   = 0;
     bool wireframe              = false;
 
-    FlagRenderer3D renderer(flag.gridWidth, flag.gridHeight);
-    Octree<glm::vec3> octree(7, glm::vec3(0,-10,0), glm::vec3(50.f));
+    ThreadPool threadPool;
 
     glm::mat4 projection = glm::perspective(70.f, float(WINDOW_WIDTH) / WINDOW_HEIGHT, 0.1f, 100.f);
 
-    renderer.setProjMatrix(projection);
+    // Recréés lorsque la scène est rechargée
+    std::unique_ptr<FlagRenderer3D> renderer;
+    std::unique_ptr<Octree<int>> octree;
+    auto createRenderer = [&]() {
+        renderer.reset(new FlagRenderer3D(flag.gridWidth, flag.gridHeight));
+        renderer->setThreadPool(&threadPool);
+        renderer->setProjMatrix(projection);
+    };
+    auto createOctree = [&]() {
+        octree.reset(new Octree<int>(scene.octreeDepth, scene.octreeCenter, scene.octreeSize));
+    };
+    createRenderer();
+    createOctree();
+
     TwBar* gui = TwNewBar("Parametres");
 
     float randomMoveScale = 0.01f;
-    float windVelocity = 0.025f;
+    float windVelocity = scene.windVelocity;
     float newWindVelocity = windVelocity;
 
     atb::addVarRW(gui, ATB_VAR(flag.K0), "step=0.01");
@@ -269,8 +189,14 @@ int main() {
     atb::addVarRW(gui, ATB_VAR(flag.V2), "step=0.01");
 
     atb::addVarRW(gui, ATB_VAR(sphereCollisionMultiplier), "step=0.01");
-    atb::addVarRW(gui, ATB_VAR(sphereHandler.radius[0]), "label='Sphere radius' step=0.01");
-    atb::addVarRW(gui, ATB_VAR(sphereHandler.positions[0].x), "label='Sphere x pos' step=0.03");
+    // La première sphère est réglable dans la GUI (variables à réenregistrer si les sphères changent)
+    auto addSphereVars = [&]() {
+        if (sphereHandler.positions.empty())
+            return;
+        atb::addVarRW(gui, ATB_VAR(sphereHandler.radius[0]), "label='Sphere radius' step=0.01");
+        atb::addVarRW(gui, ATB_VAR(sphereHandler.positions[0].x), "label='Sphere x pos' step=0.03");
+    };
+    addSphereVars();
     atb::addVarRW(gui, ATB_VAR(radiusDelta), "step=0.01");
 
     atb::addVarRW(gui, ATB_VAR(maxDstRepulseForce), "step=0.01");
@@ -280,17 +206,57 @@ int main() {
 
     atb::addVarRW(gui, ATB_VAR(activeAutoCollisions));
     atb::addVarRW(gui, ATB_VAR(activeSpheres));
+    atb::addVarRW(gui, ATB_VAR(activeContactSolver));
+    atb::addVarRW(gui, ATB_VAR(contactIterations), "min=0 max=200");
+    atb::addVarRO(gui, ATB_VAR(contactIterationsUsed));
+    atb::addVarROCB(gui, "warmStartedContacts", [&]() -> uint32_t {
+        return flag.sphereContacts.persistentCount() + flag.selfContacts.persistentCount();
+    });
+    atb::addVarRW(gui, ATB_VAR(flag.sleepThreshold), "min=0 step=0.00001 precision=5");
+    atb::addVarROCB(gui, "sleepingTiles", [&]() -> int32_t {
+        return flag.getSleepingTileCount();
+    });
     atb::addVarRW(gui, ATB_VAR(wireframe));
 
+#ifdef PARTYKEL_ENABLE_PROFILING
+    // Compteurs matériels autour de chaque phase, si le système les rend accessibles
+    std::string hardwareCountersError;
+    bool hardwareCounters = Profiler::instance().enableHardwareCounters(hardwareCountersError);
+    if (!hardwareCounters)
+        std::cerr << "Hardware counters disabled: " << hardwareCountersError << std::endl;
+
+    // Temps de chaque phase sur les dernières frames (voir Profiler.hpp) et compteurs de la dernière frame
+    TwBar* statsBar = TwNewBar("Statistiques");
+    TwDefine((" Statistiques position='" + std::to_string(WINDOW_WIDTH - 236) + " 16' size='220 420' valueswidth=70 ").c_str());
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase) {
+        ProfilePhase p = ProfilePhase(phase);
+        std::string name = "phase" + std::to_string(phase);
+        std::string group = std::string(" group='") + Profiler::getPhaseName(p) + "'";
+        atb::addVarROCB(statsBar, (name + "Min").c_str(), [p]() { return Profiler::instance().getStats(p).min; },
+                        ("label='min (ms)' precision=3" + group).c_str());
+        atb::addVarROCB(statsBar, (name + "Avg").c_str(), [p]() { return Profiler::instance().getStats(p).avg; },
+                        ("label='avg (ms)' precision=3" + group).c_str());
+        atb::addVarROCB(statsBar, (name + "P99").c_str(), [p]() { return Profiler::instance().getStats(p).p99; },
+                        ("label='p99 (ms)' precision=3" + group).c_str());
+        if (hardwareCounters) {
+            atb::addVarROCB(statsBar, (name + "IPC").c_str(), [p]() { return Profiler::instance().getHardwareStats(p).ipc; },
+                            ("label='IPC' precision=2" + group).c_str());
+            atb::addVarROCB(statsBar, (name + "CacheMisses").c_str(), [p]() { return Profiler::instance().getHardwareStats(p).cacheMissesPerParticle; },
+                            ("label='LLC misses/particle' precision=3" + group).c_str());
+            atb::addVarROCB(statsBar, (name + "BranchMisses").c_str(), [p]() { return Profiler::instance().getHardwareStats(p).branchMissesPerParticle; },
+                            ("label='branch misses/particle' precision=3" + group).c_str());
+        }
+    }
+    for (int counter = 0; counter < PROFILE_COUNTER_COUNT; ++counter) {
+        ProfileCounter c = ProfileCounter(counter);
+        atb::addVarROCB(statsBar, ("counter" + std::to_string(counter)).c_str(),
+                        [c]() { return uint32_t(Profiler::instance().getCounter(c)); },
+                        (std::string("label='") + Profiler::getCounterName(c) + "'").c_str());
+    }
+#endif
+
     atb::addButton(gui, "Reset", [&]() {
-        Flag tmp(flagMass, flagSize.x, flagSize.y, flagGrid.x, flagGrid.y); // Création d'un drapeau
-        tmp.K0 = flag.K0;
-        tmp.K1 = flag.K1;
-        tmp.K2 = flag.K2;
-        tmp.V0 = flag.V0;
-        tmp.V1 = flag.V1;
-        tmp.V2 = flag.V2;
-        flag = tmp;
+        flag.reset();
     });
 
     TrackballCamera camera;
@@ -303,50 +269,309 @@ int main() {
     Renderer3D renderer3D;
     renderer3D.setProjMatrix(projection);
 
-    float spherePosZ = sphereHandler.positions[0].z;
-    float spherePosY = sphereHandler.positions[0].y;
+    float spherePosZ = sphereHandler.positions.empty() ? 0.f : sphereHandler.positions[0].z;
+    float spherePosY = sphereHandler.positions.empty() ? 0.f : sphereHandler.positions[0].y;
     float moveStep = 1.f;
 
+    // Le vent de la frame n est tiré dans le flux (graine, RANDOM_STREAM_WIND, n): toute frame est reproductible
+    uint64_t randomSeed = scene.seed;
+    uint64_t simulationFrame = 0;
+    std::string checkpointPath = "flag.checkpoint"; // Fichier utilisé par les boutons de la GUI
+
+    // Sauvegarde: état du drapeau, des sphères, du vent et du générateur aléatoire (graine et frame courante)
+    auto saveState = [&](const std::string& path) {
+        try {
+            CheckpointWriter checkpoint(path);
+            flag.save(checkpoint);
+
+            float sceneState[] = { windVelocity, newWindVelocity, spherePosY, spherePosZ };
+
+            checkpoint.write(checkpointTag("SPOS"), sphereHandler.positions);
+            checkpoint.write(checkpointTag("SRAD"), sphereHandler.radius);
+            checkpoint.write(checkpointTag("SCOL"), sphereHandler.colors);
+            checkpoint.write(checkpointTag("SCEN"), sceneState, sizeof(sceneState));
+            checkpoint.write(checkpointTag("SEED"), randomSeed);
+            checkpoint.write(checkpointTag("FRAM"), simulationFrame);
+            checkpoint.close();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    };
+
+    auto loadState = [&](const std::string& path) {
+        try {
+            CheckpointReader checkpoint(path);
+            if (checkpoint.getVersion() < 2) {
+                throw std::runtime_error("Checkpoint " + path + " uses the previous wind generator and cannot be replayed");
+            }
+
+            // Les sphères sont référencées par la GUI: leur nombre ne doit pas changer
+            size_t sphereCount, radiusCount, colorCount, sceneCount;
+            const glm::vec3* spherePositions = checkpoint.array<glm::vec3>(checkpointTag("SPOS"), sphereCount);
+            const float* sphereRadius = checkpoint.array<float>(checkpointTag("SRAD"), radiusCount);
+            const glm::vec3* sphereColors = checkpoint.array<glm::vec3>(checkpointTag("SCOL"), colorCount);
+            const float* sceneState = checkpoint.array<float>(checkpointTag("SCEN"), sceneCount);
+            uint64_t seed, frame;
+            checkpoint.read(checkpointTag("SEED"), seed);
+            checkpoint.read(checkpointTag("FRAM"), frame);
+            if (sphereCount != sphereHandler.positions.size() || radiusCount != sphereCount ||
+                colorCount != sphereCount || sceneCount != 4) {
+                throw std::runtime_error("Checkpoint scene does not match the current scene");
+            }
+
+            flag.load(checkpoint);
+
+            std::copy(spherePositions, spherePositions + sphereCount, sphereHandler.positions.begin());
+            std::copy(sphereRadius, sphereRadius + sphereCount, sphereHandler.radius.begin());
+            std::copy(sphereColors, sphereColors + sphereCount, sphereHandler.colors.begin());
+            windVelocity = sceneState[0];
+            newWindVelocity = sceneState[1];
+            spherePosY = sceneState[2];
+            spherePosZ = sceneState[3];
+            randomSeed = seed;
+            simulationFrame = frame;
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return false;
+        }
+    };
+
+    atb::addButton(gui, "Save state", [&]() {
+        saveState(checkpointPath);
+    });
+    atb::addButton(gui, "Load state", [&]() {
+        loadState(checkpointPath);
+    });
+
+    if (!restorePath.empty() && !loadState(restorePath))
+        return EXIT_FAILURE;
+
+    std::unique_ptr<SimulationCacheWriter> recorder;
+    if (!recordPath.empty()) {
+        try {
+            recorder.reset(new SimulationCacheWriter(recordPath, flag.nbParticles,
+                recordQuantizationStep > 0.f ? SimulationCacheEncoding::QuantizedDelta : SimulationCacheEncoding::Raw,
+                recordQuantizationStep > 0.f ? recordQuantizationStep : 0.0001f, 30,
+                recordNormals ? flag.gridWidth : 0));
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Export: la simulation n'attend jamais le disque, les frames en trop sont ignorées et comptées
+    std::unique_ptr<MeshSequenceExporter> exporter;
+    if (!exportDirectory.empty()) {
+        try {
+            std::vector<uint32_t> triangleIndices;
+            buildGridIndices(flag.gridWidth, flag.gridHeight, triangleIndices);
+            exporter.reset(new MeshSequenceExporter(exportDirectory, flag.nbParticles, triangleIndices, flag.positionArray.data(),
+                                                    exportFormat, 4, MeshSequenceExporter::Backpressure::Drop, exportEmbedTopology));
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        atb::addVarROCB(gui, "exportedFrames", [&]() -> uint32_t {
+            return exporter->getStats().writtenFrames;
+        });
+        atb::addVarROCB(gui, "droppedExportFrames", [&]() -> uint32_t {
+            return exporter->getStats().droppedFrames;
+        });
+    }
+
+    // Relecture: la simulation est suspendue et le drapeau est dessiné depuis l'enregistrement
+    std::unique_ptr<SimulationPlayback> playback;
+    float playbackTime = 0.f;   // En frames enregistrées
+    float playbackSpeed = 1.f;  // Frames enregistrées par frame affichée (< 1: ralenti interpolé)
+    bool playbackPaused = false;
+    if (!playPath.empty()) {
+        try {
+            playback.reset(new SimulationPlayback(playPath));
+            if (playback->getParticleCount() != uint32_t(flag.nbParticles) ||
+                (playback->getGridWidth() && playback->getGridWidth() != uint32_t(flag.gridWidth))) {
+                throw std::runtime_error("Simulation cache " + playPath + " does not match the flag grid");
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::string frameRange = "min=0 max=" + std::to_string(playback->getFrameCount() - 1) + " step=1";
+        atb::addVarRW(gui, ATB_VAR(playbackTime), ("label='Playback frame' " + frameRange).c_str());
+        atb::addVarRW(gui, ATB_VAR(playbackSpeed), "label='Playback speed' min=0 step=0.05");
+        atb::addVarRW(gui, ATB_VAR(playbackPaused), "label='Pause'");
+    }
+
+    // Recharge le fichier de scène (et les surcharges --set) sans redémarrer l'application
+    atb::addButton(gui, "Reload scene", [&]() {
+        SceneConfig newScene;
+        if (!readScene(newScene))
+            return;
+
+        bool gridChanged = newScene.grid != scene.grid;
+        if (gridChanged && (recorder || exporter || playback)) {
+            std::cerr << "The grid size cannot change while recording, exporting or playing back" << std::endl;
+            return;
+        }
+        scene = newScene;
+
+        TwRemoveVar(gui, "sphereHandler.radius[0]");
+        TwRemoveVar(gui, "sphereHandler.positions[0].x");
+        sphereHandler.colors = scene.sphereColors;
+        sphereHandler.positions = scene.spherePositions;
+        sphereHandler.radius = scene.sphereRadius;
+        addSphereVars();
+        spherePosZ = sphereHandler.positions.empty() ? 0.f : sphereHandler.positions[0].z;
+        spherePosY = sphereHandler.positions.empty() ? 0.f : sphereHandler.positions[0].y;
+
+        sphereCollisionMultiplier = scene.sphereCollisionMultiplier;
+        radiusDelta = scene.radiusDelta;
+        G = scene.gravity;
+        maxDstRepulseForce = scene.maxDstRepulseForce;
+        multRepulseForce = scene.multRepulseForce;
+        activeSpheres = scene.activeSpheres;
+        activeAutoCollisions = scene.activeAutoCollisions;
+        activeContactSolver = scene.activeContactSolver;
+        contactIterations = scene.contactIterations;
+        windVelocity = newWindVelocity = scene.windVelocity;
+        randomSeed = scene.seed;
+        simulationFrame = 0;
+
+        flag = createFlag();
+        if (gridChanged)
+            createRenderer();
+        createOctree();
+    });
+
+#ifdef PARTYKEL_ENABLE_PROFILING
+    // Trace des frames: la touche T démarre l'enregistrement, ou l'arrête et écrit le fichier
+    Tracer::instance().setThreadName("Main");
+    if (tracePath.empty())
+        tracePath = "flag_trace.json";
+    else
+        Tracer::instance().start();
+
+    auto writeTrace = [&]() {
+        Tracer& tracer = Tracer::instance();
+        tracer.stop();
+        try {
+            tracer.writeJSON(tracePath);
+            std::cout << "Trace written to " << tracePath;
+            if (tracer.getDroppedCount())
+                std::cout << " (" << tracer.getDroppedCount() << " events dropped)";
+            std::cout << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    };
+#else
+    if (!tracePath.empty())
+        std::cerr << "--trace ignored: build with PARTYKEL_ENABLE_PROFILING" << std::endl;
+#endif
+
     bool done = false;
     while(!done) {
-        wm.startMainLoop();
+        wm->startMainLoop();
 
         // Rendu
-        renderer.clear();
-        renderer.setViewMatrix(camera.getViewMatrix());
+        renderer->clear();
+        renderer->setViewMatrix(camera.getViewMatrix());
         renderer3D.setViewMatrix(camera.getViewMatrix());
-        renderer.drawGrid(flag.positionArray.data(), wireframe);
+        if (playback) {
+            playback->seek(playbackTime);
+            renderer->drawGrid(playback->getPositions(), playback->getNormals(), wireframe);
+        } else {
+            // Les rangées des tuiles endormies n'ont pas bougé depuis la frame précédente
+            renderer->setChangedRows(flag.rowChangedArray.data());
+            renderer->drawGrid(flag.positionArray.data(), wireframe);
+        }
 
         if (activeSpheres)
             renderer3D.drawParticles(sphereHandler.positions.size(), sphereHandler.positions.data(), sphereHandler.radius.data(), sphereHandler.colors.data(), 1);
 
         // Simulation
-        if (dt > 0.f) {
-            flag.applyExternalForce(G); // Applique la gravité
-            flag.applyExternalForce(glm::sphericalRand(windVelocity)); // Applique un "vent" de direction aléatoire et de force 0.25 Newtons
-            flag.applyInternalForces(dt); // Applique les forces internes
+        if (dt > 0.f && !playback) {
+            uint64_t allocationsBeforeStep = getAllocationCount();
+            // Les données temporaires du pas précédent ne sont plus utilisées
+            threadPool.resetFrameArenas();
+            {
+                PK_SCOPED_TIMER(PROFILE_EXTERNAL_FORCES);
+                flag.applyExternalForce(G); // Applique la gravité
+                RandomStream wind(randomSeed, RANDOM_STREAM_WIND, simulationFrame);
+                flag.applyExternalForce(wind.sphericalRand(windVelocity)); // Applique un "vent" de direction aléatoire et de force 0.25 Newtons
+            }
+            {
+                PK_SCOPED_TIMER(PROFILE_INTERNAL_FORCES);
+                flag.applyInternalForces(dt); // Applique les forces internes
+            }
 
-            if (activeSpheres)
+            // Avec le solveur, les contacts des sphères sont résolus par impulsions, sans force de pénalité
+            if (activeSpheres && !activeContactSolver) {
+                PK_SCOPED_TIMER(PROFILE_SPHERE_COLLISION);
                 flag.applySphereCollision(sphereHandler, sphereCollisionMultiplier, radiusDelta);
+            }
 
-            for (auto& pos : flag.positionArray)
-                octree.add(pos, pos);
+            {
+                PK_SCOPED_TIMER(PROFILE_OCTREE_BUILD);
+                for (int k = 0; k < flag.nbParticles; ++k)
+                    octree->add(k, flag.positionArray[k]);
+            }
             
-            if (activeAutoCollisions)
-                flag.applyRepulseForces(octree, maxDstRepulseForce, multRepulseForce);
+            if (activeAutoCollisions) {
+                PK_SCOPED_TIMER(PROFILE_REPULSION);
+                flag.applyRepulseForces(*octree, maxDstRepulseForce, multRepulseForce, activeContactSolver);
+            }
 
-            for (auto& pos : flag.positionArray)
-                octree.remove(pos, pos);
+            if (activeContactSolver) {
+                PK_SCOPED_TIMER(PROFILE_CONTACTS);
+                if (activeSpheres)
+                    flag.detectSphereContacts(sphereHandler, radiusDelta);
+                else
+                    flag.sphereContacts.clear();
+
+                if (activeAutoCollisions)
+                    flag.detectSelfContacts(*octree, maxDstRepulseForce, &threadPool);
+                else
+                    flag.selfContacts.clear();
+            }
+
+            {
+                PK_SCOPED_TIMER(PROFILE_OCTREE_BUILD);
+                for (int k = 0; k < flag.nbParticles; ++k)
+                    octree->remove(k, flag.positionArray[k]);
+            }
+
+            if (activeContactSolver) {
+                PK_SCOPED_TIMER(PROFILE_CONTACTS);
+                contactIterationsUsed = flag.solveContacts(dt, contactIterations);
+            }
+
+            {
+                PK_SCOPED_TIMER(PROFILE_INTEGRATION);
+                flag.update(dt); // Mise à jour du système à partir des forces appliquées
+            }
 
-            flag.update(dt); // Mise à jour du système à partir des forces appliquées
+            ++simulationFrame;
+            PK_COUNT(PROFILE_STEP_ALLOCATIONS, getAllocationCount() - allocationsBeforeStep);
+
+            if (recorder)
+                recorder->append(flag.positionArray.data());
+
+            if (exporter)
+                exporter->submit(flag.positionArray.data());
         }
 
         // GUI Display
-        TwDraw();
+        if (!wm->isHeadless()) {
+            PK_SCOPED_TIMER(PROFILE_GUI);
+            TwDraw();
+        }
 
         // Gestion des evenements
         SDL_Event e;
-        while(wm.pollEvent(e)) {
+        while(wm->pollEvent(e)) {
             int handled = TwEventSDL(&e, SDL_MAJOR_VERSION, SDL_MINOR_VERSION);
 
             switch(e.type) {
@@ -357,6 +582,17 @@ int main() {
                     if (e.key.keysym.sym == SDLK_SPACE) {
                         wireframe = !wireframe;
                     }
+                    if (e.key.keysym.sym == SDLK_p) {
+                        playbackPaused = !playbackPaused;
+                    }
+#ifdef PARTYKEL_ENABLE_PROFILING
+                    if (e.key.keysym.sym == SDLK_t) {
+                        if (Tracer::instance().isRecording())
+                            writeTrace();
+                        else
+                            Tracer::instance().start();
+                    }
+#endif
                     if (e.key.keysym.sym == SDLK_ESCAPE) {
                         done = true;
                         break;
@@ -402,7 +638,7 @@ int main() {
         }
 
         int mouseX, mouseY;
-        if (SDL_GetMouseState(&mouseX, &mouseY) & SDL_BUTTON(SDL_BUTTON_LEFT)) {
+        if (!wm->isHeadless() && SDL_GetMouseState(&mouseX, &mouseY) & SDL_BUTTON(SDL_BUTTON_LEFT)) {
             float dX = mouseX - mouseLastX, dY = mouseY - mouseLastY;
             camera.rotateLeft(glm::radians(dX));
             camera.rotateUp(glm::radians(dY));
@@ -410,12 +646,55 @@ int main() {
             mouseLastY = mouseY;
         }
 
-        sphereHandler.positions[0].z = glm::mix(sphereHandler.positions[0].z, spherePosZ, .08);
-        sphereHandler.positions[0].y = glm::mix(sphereHandler.positions[0].y, spherePosY, .08);
+        if (!sphereHandler.positions.empty()) {
+            sphereHandler.positions[0].z = glm::mix(sphereHandler.positions[0].z, spherePosZ, .08);
+            sphereHandler.positions[0].y = glm::mix(sphereHandler.positions[0].y, spherePosY, .08);
+        }
         windVelocity = glm::mix(windVelocity, newWindVelocity, .08);
 
+        if (playback && !playbackPaused) {
+            playbackTime += playbackSpeed;
+            if (playbackTime > playback->getFrameCount() - 1)
+                playbackTime = 0.f;
+        }
+
+#ifdef PARTYKEL_ENABLE_PROFILING
+        Profiler::instance().setParticleCount(flag.nbParticles);
+#endif
+        PK_END_FRAME();
+
         // Mise à jour de la fenêtre
-        dt = wm.update();
+        dt = wm->update();
+        if (fixedDt > 0.f)
+            dt = fixedDt;
+
+        if (wm->isHeadless() && --headlessFrameCount <= 0)
+            done = true;
+    }
+
+    if (!savePath.empty())
+        saveState(savePath);
+
+#ifdef PARTYKEL_ENABLE_PROFILING
+    if (Tracer::instance().isRecording())
+        writeTrace();
+#endif
+
+    if (exporter) {
+        exporter->flush();
+        MeshSequenceExporter::Stats stats = exporter->getStats();
+        if (exporter->isFallingBehind() || stats.failedFrames) {
+            std::cerr << "Mesh export: " << stats.writtenFrames << " frames written, " << stats.droppedFrames
+                      << " dropped (disk too slow), " << stats.failedFrames << " failed" << std::endl;
+        }
+    }
+
+    if (recorder) {
+        try {
+            recorder->close();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
     }
 
     return EXIT_SUCCESS;
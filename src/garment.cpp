@@ -0,0 +1,236 @@
+#include <iostream>
+#include <cstdlib>
+
+#include <PartyKel/glm.hpp>
+#include <PartyKel/WindowManager.hpp>
+
+#include <PartyKel/renderer/MeshRenderer3D.hpp>
+#include <PartyKel/renderer/TrackballCamera.hpp>
+#include <PartyKel/renderer/Renderer3D.hpp>
+#include <PartyKel/renderer/Sphere.hpp>
+#include <PartyKel/atb.hpp>
+#include <PartyKel/ThreadPool.hpp>
+#include <PartyKel/SceneConfig.hpp>
+#include <PartyKel/Random.hpp>
+#include <PartyKel/TriangleMesh.hpp>
+#include <PartyKel/MeshCloth.hpp>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <stdexcept>
+
+static const Uint32 WINDOW_WIDTH = 900;
+static const Uint32 WINDOW_HEIGHT = 700;
+
+using namespace PartyKel;
+
+// Simulation d'un panneau de vêtement lu dans un fichier OBJ
+int main(int argc, char** argv) {
+    // garment <fichier.obj>: maillage du vêtement
+    // garment --pin <y>: fixe les sommets d'ordonnée supérieure ou égale à y (par défaut: le haut du maillage)
+    // garment --headless <dossier> [nombre de frames]: rendu hors écran d'une séquence d'images
+    // garment --scene <fichier> / --set clé=valeur: paramètres de la scène (voir SceneConfig.hpp),
+    // les clés propres à la grille du drapeau (grid, size, octree...) sont ignorées
+    std::string meshPath;
+    std::string headlessDirectory;
+    int headlessFrameCount = 600;
+    bool pinned = false;
+    float pinHeight = 0.f;
+    std::string scenePath;
+    std::vector<std::string> sceneOverrides;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless" && i + 1 < argc) {
+            headlessDirectory = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                headlessFrameCount = std::atoi(argv[++i]);
+        } else if (arg == "--pin" && i + 1 < argc) {
+            pinned = true;
+            pinHeight = std::atof(argv[++i]);
+        } else if (arg == "--scene" && i + 1 < argc) {
+            scenePath = argv[++i];
+        } else if (arg == "--set" && i + 1 < argc) {
+            sceneOverrides.push_back(argv[++i]);
+        } else if (arg[0] != '-') {
+            meshPath = arg;
+        }
+    }
+
+    if (meshPath.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <mesh.obj> [--pin y] [--scene file] [--set key=value] [--headless dir [frames]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    SceneConfig scene;
+    std::unique_ptr<MeshCloth> cloth;
+    try {
+        if (!scenePath.empty())
+            scene.loadFile(scenePath);
+        for (const auto& assignment : sceneOverrides)
+            scene.set(assignment);
+
+        cloth.reset(new MeshCloth(loadOBJ(meshPath), scene.mass));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    cloth->K0 = scene.K0;
+    cloth->K1 = scene.K1;
+    cloth->K2 = scene.K2;
+    cloth->V0 = scene.V0;
+    cloth->V1 = scene.V1;
+    cloth->V2 = scene.V2;
+
+    // Par défaut le vêtement est suspendu par ses sommets les plus hauts
+    if (!pinned) {
+        float minY = cloth->positionArray[0].y, maxY = minY;
+        for (const auto& position : cloth->positionArray) {
+            minY = std::min(minY, position.y);
+            maxY = std::max(maxY, position.y);
+        }
+        pinHeight = maxY - 0.01f * (maxY - minY);
+    }
+    cloth->fixAbove(pinHeight);
+
+    std::cout << meshPath << ": " << cloth->nbParticles << " particles, " << cloth->indexArray.size() / 3 << " triangles, "
+              << cloth->structuralSprings.size() << " structural, " << cloth->shearSprings.size() << " shear and "
+              << cloth->bendSprings.size() << " bend springs" << std::endl;
+
+    SphereHandler sphereHandler;
+    sphereHandler.colors = scene.sphereColors;
+    sphereHandler.positions = scene.spherePositions;
+    sphereHandler.radius = scene.sphereRadius;
+
+    std::unique_ptr<WindowManager> wm(headlessDirectory.empty() ?
+        new WindowManager(WINDOW_WIDTH, WINDOW_HEIGHT, "Garment Simulation") :
+        new WindowManager(WINDOW_WIDTH, WINDOW_HEIGHT, headlessDirectory));
+    wm->setFramerate(60);
+
+    // Initialisation de AntTweakBar (pour la GUI)
+    TwInit(TW_OPENGL, NULL);
+    TwWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    bool activeSpheres = scene.activeSpheres;
+    bool wireframe = false;
+    float windVelocity = scene.windVelocity;
+
+    ThreadPool threadPool;
+
+    glm::mat4 projection = glm::perspective(70.f, float(WINDOW_WIDTH) / WINDOW_HEIGHT, 0.1f, 100.f);
+
+    MeshRenderer3D renderer(cloth->nbParticles, cloth->indexArray);
+    renderer.setThreadPool(&threadPool);
+    renderer.setProjMatrix(projection);
+
+    Renderer3D renderer3D;
+    renderer3D.setProjMatrix(projection);
+
+    TwBar* gui = TwNewBar("Parametres");
+
+    atb::addVarRW(gui, ATB_VAR(cloth->K0), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(cloth->K1), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(cloth->K2), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(cloth->V0), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(cloth->V1), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(cloth->V2), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(scene.sphereCollisionMultiplier), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(scene.radiusDelta), "step=0.01");
+    atb::addVarRW(gui, ATB_VAR(windVelocity), "label='Wind velocity' step=0.02");
+    atb::addVarRW(gui, ATB_VAR(activeSpheres));
+    atb::addVarRW(gui, ATB_VAR(wireframe));
+
+    TrackballCamera camera;
+    camera.moveFront(12);
+    int mouseLastX, mouseLastY;
+
+    // Delta Time : temps s'écoulant entre chaque frame
+    float dt = 0.f;
+
+    uint64_t simulationFrame = 0;
+
+    bool done = false;
+    while(!done) {
+        wm->startMainLoop();
+
+        // Rendu
+        renderer.clear();
+        renderer.setViewMatrix(camera.getViewMatrix());
+        renderer3D.setViewMatrix(camera.getViewMatrix());
+        renderer.drawMesh(cloth->positionArray.data(), wireframe);
+
+        if (activeSpheres)
+            renderer3D.drawParticles(sphereHandler.positions.size(), sphereHandler.positions.data(), sphereHandler.radius.data(), sphereHandler.colors.data(), 1);
+
+        // Simulation
+        if (dt > 0.f) {
+            cloth->applyExternalForce(scene.gravity);
+            RandomStream wind(scene.seed, RANDOM_STREAM_WIND, simulationFrame);
+            cloth->applyExternalForce(wind.sphericalRand(windVelocity));
+            cloth->applyInternalForces(dt);
+
+            if (activeSpheres)
+                cloth->applySphereCollision(sphereHandler, scene.sphereCollisionMultiplier, scene.radiusDelta);
+
+            cloth->update(dt);
+            ++simulationFrame;
+        }
+
+        // GUI Display
+        if (!wm->isHeadless())
+            TwDraw();
+
+        // Gestion des evenements
+        SDL_Event e;
+        while(wm->pollEvent(e)) {
+            // Les évènements consommés par l'interface ne sont pas transmis à la scène
+            if (TwEventSDL(&e, SDL_MAJOR_VERSION, SDL_MINOR_VERSION))
+                continue;
+
+            switch(e.type) {
+                case SDL_QUIT:
+                    done = true;
+                    break;
+                case SDL_KEYDOWN:
+                    if (e.key.keysym.sym == SDLK_SPACE) {
+                        wireframe = !wireframe;
+                    }
+                    if (e.key.keysym.sym == SDLK_ESCAPE) {
+                        done = true;
+                    }
+                    break;
+                case SDL_MOUSEBUTTONDOWN:
+                    if (e.button.button == SDL_BUTTON_WHEELUP) {
+                        camera.moveFront(-0.4f);
+                    } else if (e.button.button == SDL_BUTTON_WHEELDOWN) {
+                        camera.moveFront(0.4f);
+                    }
+                    else if (e.button.button == SDL_BUTTON_LEFT) {
+                        mouseLastX = e.button.x;
+                        mouseLastY = e.button.y;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        int mouseX, mouseY;
+        if (!wm->isHeadless() && SDL_GetMouseState(&mouseX, &mouseY) & SDL_BUTTON(SDL_BUTTON_LEFT)) {
+            float dX = mouseX - mouseLastX, dY = mouseY - mouseLastY;
+            camera.rotateLeft(glm::radians(dX));
+            camera.rotateUp(glm::radians(dY));
+            mouseLastX = mouseX;
+            mouseLastY = mouseY;
+        }
+
+        // Mise à jour de la fenêtre
+        dt = wm->update();
+
+        if (wm->isHeadless() && --headlessFrameCount <= 0)
+            done = true;
+    }
+
+    return EXIT_SUCCESS;
+}
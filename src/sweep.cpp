@@ -0,0 +1,429 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+#include <PartyKel/glm.hpp>
+#include <PartyKel/renderer/Sphere.hpp>
+#include <PartyKel/Octree.hpp>
+#include <PartyKel/ThreadPool.hpp>
+#include <PartyKel/Random.hpp>
+#include <PartyKel/Flag.hpp>
+#include <PartyKel/SceneConfig.hpp>
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace PartyKel;
+
+// Balayage de paramètres sans fenêtre: de nombreuses petites simulations de drapeau indépendantes,
+// une par coeur, dont les mesures de stabilité et d'énergie sont écrites dans un tableau CSV.
+//
+//   sweep <spec> [--random <n>] [--steps <n>] [--frames <n>] [--dt <s>] [--threads <n>] [--seed <n>]
+//         [--scene <fichier>] [--set clé=valeur] [--output <fichier.csv>]
+//
+// Le fichier spec donne une clé de scène (voir SceneConfig.hpp) par ligne:
+//
+//   K0 = 0.5, 1, 2          # liste de valeurs
+//   V0 = [0.02, 0.2]        # intervalle
+//
+// Sans --random, toutes les combinaisons sont simulées (grille), chaque intervalle étant découpé en --steps valeurs.
+// Avec --random n, n configurations sont tirées: uniformément dans les intervalles, parmi les valeurs des listes.
+// Les bornes d'intervalle écrites sans point donnent des valeurs entières (contactIterations = [5, 40])
+//
+// Avec PARTYKEL_ENABLE_PROFILING, les simulations concurrentes ajoutent leurs compteurs (PK_COUNT) au même Profiler,
+// dont les totaux sont atomiques: les valeurs cumulées de tous les threads ne sont pas rapportées par sweep
+
+namespace {
+
+struct SweepParameter {
+    std::string key;
+    std::vector<std::string> values; // Liste de valeurs, vide pour un intervalle
+    float min, max;
+    bool integer;
+};
+
+struct SweepResult {
+    bool stable;
+    int failedFrame;            // Frame à laquelle la simulation a divergé, -1 si stable
+    std::string failure;
+    float maxKineticEnergy;
+    float finalKineticEnergy;
+    float tailKineticEnergy;    // Moyenne sur le dernier quart des frames: nulle pour un drapeau qui s'immobilise
+    float maxStretch;           // Plus grand allongement relatif d'un ressort structurel
+    int contacts;               // Contacts à la dernière frame
+    float solverIterations;     // Itérations moyennes du solveur de contacts
+    double milliseconds;
+};
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos)
+        return std::string();
+    return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator))
+        parts.push_back(trim(part));
+    return parts;
+}
+
+std::string formatValue(float value, bool integer) {
+    char buffer[32];
+    if (integer)
+        std::snprintf(buffer, sizeof(buffer), "%d", int(std::floor(value + 0.5f)));
+    else
+        std::snprintf(buffer, sizeof(buffer), "%g", value);
+    return buffer;
+}
+
+std::vector<SweepParameter> loadSpec(const std::string& path) {
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error(path + ": unable to open the sweep spec");
+
+    std::vector<SweepParameter> parameters;
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+
+        std::string location = path + ":" + std::to_string(lineNumber) + ": ";
+        size_t equal = line.find('=');
+        if (equal == std::string::npos)
+            throw std::runtime_error(location + "expected 'key = values'");
+
+        SweepParameter parameter;
+        parameter.key = trim(line.substr(0, equal));
+        std::string value = trim(line.substr(equal + 1));
+        if (!value.empty() && value.front() == '[') {
+            std::vector<std::string> bounds = split(value.substr(1, value.find(']') - 1), ',');
+            char* end0;
+            char* end1;
+            if (value.back() != ']' || bounds.size() != 2)
+                throw std::runtime_error(location + "expected an interval '[min, max]'");
+            parameter.min = std::strtof(bounds[0].c_str(), &end0);
+            parameter.max = std::strtof(bounds[1].c_str(), &end1);
+            if (*end0 || *end1 || bounds[0].empty() || bounds[1].empty() || parameter.min > parameter.max)
+                throw std::runtime_error(location + "invalid interval '" + value + "'");
+            parameter.integer = bounds[0].find_first_of(".eE") == std::string::npos &&
+                                bounds[1].find_first_of(".eE") == std::string::npos;
+        } else {
+            parameter.values = split(value, ',');
+            if (std::find(parameter.values.begin(), parameter.values.end(), std::string()) != parameter.values.end())
+                throw std::runtime_error(location + "empty value in '" + value + "'");
+        }
+        parameters.push_back(parameter);
+    }
+
+    if (parameters.empty())
+        throw std::runtime_error(path + ": no parameter to sweep");
+    return parameters;
+}
+
+// Valeurs de chaque configuration, dans l'ordre des paramètres
+std::vector<std::vector<std::string>> gridConfigurations(const std::vector<SweepParameter>& parameters, int steps) {
+    std::vector<std::vector<std::string>> axes;
+    for (const auto& parameter : parameters) {
+        if (!parameter.values.empty()) {
+            axes.push_back(parameter.values);
+            continue;
+        }
+        std::vector<std::string> axis;
+        for (int s = 0; s < steps; ++s) {
+            float t = steps > 1 ? float(s) / (steps - 1) : 0.5f;
+            std::string value = formatValue(glm::mix(parameter.min, parameter.max, t), parameter.integer);
+            if (axis.empty() || axis.back() != value)
+                axis.push_back(value);
+        }
+        axes.push_back(axis);
+    }
+
+    size_t count = 1;
+    for (const auto& axis : axes)
+        count *= axis.size();
+
+    // Le dernier paramètre varie le plus vite
+    std::vector<std::vector<std::string>> configurations(count, std::vector<std::string>(parameters.size()));
+    for (size_t c = 0; c < count; ++c) {
+        size_t index = c;
+        for (size_t p = parameters.size(); p-- > 0;) {
+            configurations[c][p] = axes[p][index % axes[p].size()];
+            index /= axes[p].size();
+        }
+    }
+    return configurations;
+}
+
+std::vector<std::vector<std::string>> randomConfigurations(const std::vector<SweepParameter>& parameters, int count, uint64_t seed) {
+    std::vector<std::vector<std::string>> configurations(count);
+    for (int c = 0; c < count; ++c) {
+        // Un flux par configuration: le tirage ne dépend pas du nombre de configurations demandées
+        RandomStream random(seed, RANDOM_STREAM_SWEEP, c);
+        for (const auto& parameter : parameters) {
+            if (!parameter.values.empty())
+                configurations[c].push_back(parameter.values[random.nextUint() % parameter.values.size()]);
+            else if (parameter.integer)
+                configurations[c].push_back(formatValue(std::floor(random.nextFloat(parameter.min, parameter.max + 1.f)), true));
+            else
+                configurations[c].push_back(formatValue(random.nextFloat(parameter.min, parameter.max), false));
+        }
+    }
+    return configurations;
+}
+
+// Simule un drapeau seul, dans l'ordre de flag, sur le thread appelant
+SweepResult simulate(const SceneConfig& scene, int frameCount, float dt) {
+    auto start = std::chrono::steady_clock::now();
+
+    SweepResult result = { true, -1, std::string(), 0.f, 0.f, 0.f, 0.f, 0, 0.f, 0. };
+
+    Flag flag(scene.mass, scene.size.x, scene.size.y, scene.grid.x, scene.grid.y);
+    flag.K0 = scene.K0;
+    flag.K1 = scene.K1;
+    flag.K2 = scene.K2;
+    flag.V0 = scene.V0;
+    flag.V1 = scene.V1;
+    flag.V2 = scene.V2;
+    flag.sleepThreshold = scene.sleepThreshold;
+    flag.sleepFrames = scene.sleepFrames;
+    flag.wakeForceDelta = scene.wakeForceDelta;
+    Octree<int> octree(scene.octreeDepth, scene.octreeCenter, scene.octreeSize);
+
+    SphereHandler sphereHandler;
+    sphereHandler.positions = scene.spherePositions;
+    sphereHandler.radius = scene.sphereRadius;
+    sphereHandler.colors = scene.sphereColors;
+
+    // Une particule éloignée de plus de cette distance de sa position de repos a divergé
+    std::vector<glm::vec3> restPositions = flag.positionArray;
+    float maxDisplacement = 4.f * (scene.size.x + scene.size.y);
+
+    int tailBegin = frameCount - frameCount / 4;
+    double tailEnergy = 0.;
+    int solverIterations = 0;
+    int frame = 0;
+    try {
+        for (; frame < frameCount; ++frame) {
+            flag.applyExternalForce(scene.gravity);
+            RandomStream wind(scene.seed, RANDOM_STREAM_WIND, frame);
+            flag.applyExternalForce(wind.sphericalRand(scene.windVelocity));
+            flag.applyInternalForces(dt);
+            // Avec le solveur, les contacts des sphères sont résolus par impulsions, sans force de pénalité
+            if (scene.activeSpheres && !scene.activeContactSolver)
+                flag.applySphereCollision(sphereHandler, scene.sphereCollisionMultiplier, scene.radiusDelta);
+
+            for (int k = 0; k < flag.nbParticles; ++k)
+                octree.add(k, flag.positionArray[k]);
+            if (scene.activeAutoCollisions)
+                flag.applyRepulseForces(octree, scene.maxDstRepulseForce, scene.multRepulseForce, scene.activeContactSolver);
+            if (scene.activeContactSolver) {
+                if (scene.activeSpheres)
+                    flag.detectSphereContacts(sphereHandler, scene.radiusDelta);
+                if (scene.activeAutoCollisions)
+                    flag.detectSelfContacts(octree, scene.maxDstRepulseForce);
+            }
+            for (int k = 0; k < flag.nbParticles; ++k)
+                octree.remove(k, flag.positionArray[k]);
+
+            if (scene.activeContactSolver)
+                solverIterations += flag.solveContacts(dt, scene.contactIterations);
+            flag.update(dt);
+
+            float energy = 0.f;
+            for (int k = 0; k < flag.nbParticles; ++k) {
+                const glm::vec3& position = flag.positionArray[k];
+                if (!std::isfinite(position.x + position.y + position.z) ||
+                    glm::distance(position, restPositions[k]) > maxDisplacement)
+                    throw std::runtime_error("particle escaped");
+                energy += 0.5f * flag.massArray[k] * glm::dot(flag.velocityArray[k], flag.velocityArray[k]);
+            }
+            if (!std::isfinite(energy))
+                throw std::runtime_error("infinite energy");
+
+            for (int j = 0; j < flag.gridHeight; ++j) {
+                for (int i = 0; i < flag.gridWidth; ++i) {
+                    int k = i + j * flag.gridWidth;
+                    if (i + 1 < flag.gridWidth)
+                        result.maxStretch = std::max(result.maxStretch, glm::distance(flag.positionArray[k], flag.positionArray[k + 1]) / flag.L0.x - 1.f);
+                    if (j + 1 < flag.gridHeight)
+                        result.maxStretch = std::max(result.maxStretch, glm::distance(flag.positionArray[k], flag.positionArray[k + flag.gridWidth]) / flag.L0.y - 1.f);
+                }
+            }
+
+            result.maxKineticEnergy = std::max(result.maxKineticEnergy, energy);
+            result.finalKineticEnergy = energy;
+            if (frame >= tailBegin)
+                tailEnergy += energy;
+        }
+    } catch (const std::exception& e) {
+        // Particule hors de l'octree, position infinie...
+        result.stable = false;
+        result.failedFrame = frame;
+        result.failure = e.what();
+    }
+
+    if (result.stable)
+        result.tailKineticEnergy = tailEnergy / std::max(frameCount - tailBegin, 1);
+    result.contacts = flag.sphereContacts.contacts().size() + flag.selfContacts.contacts().size();
+    result.solverIterations = float(solverIterations) / std::max(frame, 1);
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void writeCSV(std::ostream& out, const std::vector<SweepParameter>& parameters,
+              const std::vector<std::vector<std::string>>& configurations, const std::vector<SweepResult>& results) {
+    out << "index";
+    for (const auto& parameter : parameters)
+        out << "," << parameter.key;
+    out << ",stable,failedFrame,maxKineticEnergy,finalKineticEnergy,tailKineticEnergy,maxStretch,contacts,solverIterations,milliseconds,failure\n";
+
+    for (size_t c = 0; c < configurations.size(); ++c) {
+        const SweepResult& r = results[c];
+        out << c;
+        // Les vecteurs (gravity = 0 -0.05 0) restent une seule colonne
+        for (const auto& value : configurations[c])
+            out << ",\"" << value << "\"";
+        out << "," << r.stable << "," << r.failedFrame << "," << r.maxKineticEnergy << "," << r.finalKineticEnergy << ","
+            << r.tailKineticEnergy << "," << r.maxStretch << "," << r.contacts << "," << r.solverIterations << "," << r.milliseconds << ",\"" << r.failure << "\"\n";
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string specPath;
+    int randomCount = 0;
+    int steps = 3;
+    int frameCount = 600;
+    float dt = 0.16f; // Pas de flag à 60 images par seconde (WindowManager::update)
+    unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    uint64_t seed = 0;
+    std::string scenePath;
+    std::vector<std::string> sceneOverrides;
+    std::string outputPath = "sweep.csv";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--random" && i + 1 < argc) {
+            randomCount = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--steps" && i + 1 < argc) {
+            steps = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frameCount = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--dt" && i + 1 < argc) {
+            dt = std::atof(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadCount = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--scene" && i + 1 < argc) {
+            scenePath = argv[++i];
+        } else if (arg == "--set" && i + 1 < argc) {
+            sceneOverrides.push_back(argv[++i]);
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg[0] != '-' && specPath.empty()) {
+            specPath = arg;
+        } else {
+            specPath.clear();
+            break;
+        }
+    }
+    if (specPath.empty() || dt <= 0.f) {
+        std::cerr << "Usage: " << argv[0] << " <spec> [--random n] [--steps n] [--frames n] [--dt s] [--threads n] [--seed n]" << std::endl;
+        std::cerr << "       [--scene file] [--set key=value] [--output file.csv]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<SweepParameter> parameters;
+    std::vector<std::vector<std::string>> configurations;
+    std::vector<SceneConfig> scenes;
+    try {
+        SceneConfig base;
+        if (!scenePath.empty())
+            base.loadFile(scenePath);
+        for (const auto& assignment : sceneOverrides)
+            base.set(assignment);
+
+        parameters = loadSpec(specPath);
+        configurations = randomCount > 0 ? randomConfigurations(parameters, randomCount, seed) : gridConfigurations(parameters, steps);
+
+        // Toutes les scènes sont construites avant de lancer les simulations: une clé invalide est signalée tout de suite
+        scenes.assign(configurations.size(), base);
+        for (size_t c = 0; c < configurations.size(); ++c) {
+            for (size_t p = 0; p < parameters.size(); ++p)
+                scenes[c].set(parameters[p].key, configurations[c][p]);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream out(outputPath);
+    if (!out) {
+        std::cerr << outputPath << ": unable to write the results" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int configurationCount = configurations.size();
+    std::cout << configurationCount << " configurations, " << frameCount << " frames each, on "
+              << threadCount << " pinned threads" << std::endl;
+
+    // Un bloc par thread; chaque thread prend la configuration suivante dès qu'il a terminé la sienne,
+    // les simulations qui divergent s'arrêtant plus tôt que les autres
+    ThreadPool pool(threadCount, true);
+    std::vector<SweepResult> results(configurationCount);
+    std::atomic<int> nextConfiguration(0);
+    int completed = 0;
+    std::mutex progressMutex;
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(0, pool.getThreadCount(), 1, [&](int, int) {
+        for (int c = nextConfiguration++; c < configurationCount; c = nextConfiguration++) {
+            results[c] = simulate(scenes[c], frameCount, dt);
+
+            std::lock_guard<std::mutex> lock(progressMutex);
+            ++completed;
+            if (completed % std::max(configurationCount / 100, 1) == 0 || completed == configurationCount) {
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                std::cout << "\r" << completed << " / " << configurationCount << " (" << int(seconds) << " s)" << std::flush;
+            }
+        }
+    });
+    std::cout << std::endl;
+
+    writeCSV(out, parameters, configurations, results);
+
+    // Résumé: configurations stables les plus calmes en fin de simulation
+    std::vector<int> stable;
+    for (int c = 0; c < configurationCount; ++c) {
+        if (results[c].stable)
+            stable.push_back(c);
+    }
+    std::sort(stable.begin(), stable.end(), [&](int a, int b) {
+        return results[a].tailKineticEnergy < results[b].tailKineticEnergy;
+    });
+
+    std::cout << stable.size() << " stable, " << configurationCount - stable.size() << " diverged; results written to " << outputPath << std::endl;
+    for (size_t s = 0; s < std::min<size_t>(stable.size(), 5); ++s) {
+        int c = stable[s];
+        std::cout << "  #" << c << ":";
+        for (size_t p = 0; p < parameters.size(); ++p)
+            std::cout << " " << parameters[p].key << "=" << configurations[c][p];
+        std::cout << "  tail energy " << results[c].tailKineticEnergy << ", max stretch " << results[c].maxStretch << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,314 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+
+#include <PartyKel/glm.hpp>
+#include <PartyKel/ThreadPool.hpp>
+#include <PartyKel/Random.hpp>
+#include <PartyKel/Flag.hpp>
+#include <PartyKel/SceneConfig.hpp>
+#include <PartyKel/ClothTile.hpp>
+#include <PartyKel/SharedRing.hpp>
+#include <PartyKel/renderer/Sphere.hpp>
+
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <stdexcept>
+
+using namespace PartyKel;
+
+// Simulation d'un grand drapeau découpé en bandes de rangées, une par processus.
+// Le lanceur crée les files de mémoire partagée entre bandes voisines, puis un processus par bande, fixé sur
+// sa part des coeurs: ses tableaux sont alloués et remplis par ce processus, donc placés sur son noeud mémoire.
+// À chaque pas, chaque bande envoie ses deux premières et ses deux dernières rangées (positions et vitesses)
+// aux bandes voisines, qui les copient dans leur halo.
+//
+//   tiles [--tiles <n>] [--frames <n>] [--dt <s>] [--slots <n>] [--scene <fichier>] [--set clé=valeur] [--verify]
+//
+// --verify simule le même drapeau avec Flag dans le lanceur et compare les positions finales
+
+namespace {
+
+// Résultat d'une bande, écrit par son processus dans un segment partagé avec le lanceur
+struct TileReport {
+    double checksum;        // Somme des coordonnées des positions finales de la bande
+    double kineticEnergy;
+    double milliseconds;
+    int32_t rowBegin, rowEnd;
+    int32_t cpuCount;
+    int32_t done;
+};
+
+std::string ringName(const std::string& session, const char* direction, int boundary) {
+    return session + "_" + direction + std::to_string(boundary);
+}
+
+int tileRowBegin(int tile, int tileCount, int gridHeight) {
+    return int(int64_t(tile) * gridHeight / tileCount);
+}
+
+// Coeurs autorisés pour le lanceur, répartis en parts contiguës (les coeurs d'un même noeud NUMA se suivent)
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+void runTile(const SceneConfig& scene, int tile, int tileCount, int frameCount, float dt, const std::string& session, TileReport& report) {
+    int rowBegin = tileRowBegin(tile, tileCount, scene.grid.y), rowEnd = tileRowBegin(tile + 1, tileCount, scene.grid.y);
+    ClothTile cloth(scene, rowBegin, rowEnd);
+
+    cpu_set_t allowed;
+    unsigned int cpuCount = sched_getaffinity(0, sizeof(allowed), &allowed) == 0 ? CPU_COUNT(&allowed) : 1;
+    ThreadPool pool(cpuCount, true);
+
+    // Files ouvertes par leur nom: "up" va de la bande b à la bande b + 1, "down" de b + 1 à b
+    std::unique_ptr<SharedRing> sendDown, receiveDown, sendUp, receiveUp;
+    if (tile > 0) {
+        sendDown.reset(new SharedRing(ringName(session, "down", tile - 1)));
+        receiveDown.reset(new SharedRing(ringName(session, "up", tile - 1)));
+    }
+    if (tile + 1 < tileCount) {
+        sendUp.reset(new SharedRing(ringName(session, "up", tile)));
+        receiveUp.reset(new SharedRing(ringName(session, "down", tile)));
+    }
+
+    const int halo = ClothTile::HALO_ROWS;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frameCount; ++frame) {
+        RandomStream wind(scene.seed, RANDOM_STREAM_WIND, frame);
+        cloth.step(scene, dt, wind.sphericalRand(scene.windVelocity), pool);
+
+        // Envoi puis réception: les files ont au moins deux emplacements, une bande peut prendre un pas d'avance
+        if (sendDown) {
+            cloth.packRows(rowBegin, halo, static_cast<glm::vec3*>(sendDown->beginWrite()));
+            sendDown->endWrite();
+        }
+        if (sendUp) {
+            cloth.packRows(rowEnd - halo, halo, static_cast<glm::vec3*>(sendUp->beginWrite()));
+            sendUp->endWrite();
+        }
+        if (receiveDown) {
+            cloth.unpackRows(rowBegin - halo, halo, static_cast<const glm::vec3*>(receiveDown->beginRead()));
+            receiveDown->endRead();
+        }
+        if (receiveUp) {
+            cloth.unpackRows(rowEnd, halo, static_cast<const glm::vec3*>(receiveUp->beginRead()));
+            receiveUp->endRead();
+        }
+    }
+
+    report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    report.checksum = 0.;
+    report.kineticEnergy = 0.;
+    for (int j = rowBegin; j < rowEnd; ++j) {
+        for (int i = 0; i < cloth.getGridWidth(); ++i) {
+            const glm::vec3& position = cloth.getPosition(i, j);
+            const glm::vec3& velocity = cloth.getVelocity(i, j);
+            report.checksum += double(position.x) + position.y + position.z;
+            report.kineticEnergy += 0.5 * glm::dot(velocity, velocity);
+        }
+    }
+    report.rowBegin = rowBegin;
+    report.rowEnd = rowEnd;
+    report.cpuCount = cpuCount;
+    report.done = 1;
+}
+
+// Même simulation avec un Flag, sommée par bande comme les rapports des processus
+std::vector<double> referenceChecksums(const SceneConfig& scene, int tileCount, int frameCount, float dt) {
+    Flag flag(scene.mass, scene.size.x, scene.size.y, scene.grid.x, scene.grid.y);
+    flag.K0 = scene.K0;
+    flag.K1 = scene.K1;
+    flag.K2 = scene.K2;
+    flag.V0 = scene.V0;
+    flag.V1 = scene.V1;
+    flag.V2 = scene.V2;
+
+    SphereHandler sphereHandler;
+    sphereHandler.positions = scene.spherePositions;
+    sphereHandler.radius = scene.sphereRadius;
+    sphereHandler.colors = scene.sphereColors;
+
+    for (int frame = 0; frame < frameCount; ++frame) {
+        flag.applyExternalForce(scene.gravity);
+        RandomStream wind(scene.seed, RANDOM_STREAM_WIND, frame);
+        flag.applyExternalForce(wind.sphericalRand(scene.windVelocity));
+        flag.applyInternalForces(dt);
+        if (scene.activeSpheres)
+            flag.applySphereCollision(sphereHandler, scene.sphereCollisionMultiplier, scene.radiusDelta);
+        flag.update(dt);
+    }
+
+    std::vector<double> checksums(tileCount, 0.);
+    for (int tile = 0; tile < tileCount; ++tile) {
+        int begin = tileRowBegin(tile, tileCount, scene.grid.y) * scene.grid.x;
+        int end = tileRowBegin(tile + 1, tileCount, scene.grid.y) * scene.grid.x;
+        for (int k = begin; k < end; ++k)
+            checksums[tile] += double(flag.positionArray[k].x) + flag.positionArray[k].y + flag.positionArray[k].z;
+    }
+    return checksums;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int tileCount = 2;
+    int frameCount = 600;
+    float dt = 0.16f; // Pas de flag à 60 images par seconde (WindowManager::update)
+    int slotCount = 2;
+    bool verify = false;
+    std::string scenePath;
+    std::vector<std::string> sceneOverrides;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--tiles" && i + 1 < argc) {
+            tileCount = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frameCount = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--dt" && i + 1 < argc) {
+            dt = std::atof(argv[++i]);
+        } else if (arg == "--slots" && i + 1 < argc) {
+            slotCount = std::max(2, std::atoi(argv[++i]));
+        } else if (arg == "--scene" && i + 1 < argc) {
+            scenePath = argv[++i];
+        } else if (arg == "--set" && i + 1 < argc) {
+            sceneOverrides.push_back(argv[++i]);
+        } else if (arg == "--verify") {
+            verify = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--tiles n] [--frames n] [--dt s] [--slots n] [--scene file] [--set key=value] [--verify]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    SceneConfig scene;
+    try {
+        if (!scenePath.empty())
+            scene.loadFile(scenePath);
+        for (const auto& assignment : sceneOverrides)
+            scene.set(assignment);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (scene.grid.y < tileCount * ClothTile::HALO_ROWS) {
+        std::cerr << "A " << scene.grid.y << " rows grid cannot be split in " << tileCount << " tiles of at least "
+                  << ClothTile::HALO_ROWS << " rows" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Les segments sont créés avant les processus et supprimés par le lanceur à la fin
+    std::string session = "/partykel_tiles_" + std::to_string(getpid());
+    size_t slotSize = 2 * ClothTile::HALO_ROWS * scene.grid.x * sizeof(glm::vec3);
+    std::vector<std::unique_ptr<SharedRing>> rings;
+    std::unique_ptr<SharedMemory> reportMemory;
+    try {
+        for (int boundary = 0; boundary + 1 < tileCount; ++boundary) {
+            rings.emplace_back(new SharedRing(ringName(session, "up", boundary), slotSize, slotCount));
+            rings.emplace_back(new SharedRing(ringName(session, "down", boundary), slotSize, slotCount));
+        }
+        reportMemory.reset(new SharedMemory(session + "_report", tileCount * sizeof(TileReport)));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    TileReport* reports = static_cast<TileReport*>(reportMemory->getData());
+
+    std::cout << "Grid " << scene.grid.x << " x " << scene.grid.y << " (" << int64_t(scene.grid.x) * scene.grid.y
+              << " particles) in " << tileCount << " tiles, " << frameCount << " frames" << std::endl;
+
+    std::vector<int> cpus = allowedCpus();
+    std::vector<pid_t> children;
+    auto start = std::chrono::steady_clock::now();
+    for (int tile = 0; tile < tileCount; ++tile) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::perror("fork");
+            for (pid_t child : children)
+                kill(child, SIGTERM);
+            return EXIT_FAILURE;
+        }
+        if (pid == 0) {
+            // Part des coeurs de la bande, au moins un
+            if (!cpus.empty()) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                size_t begin = size_t(tile) * cpus.size() / tileCount, end = size_t(tile + 1) * cpus.size() / tileCount;
+                if (begin == end)
+                    CPU_SET(cpus[tile % cpus.size()], &set);
+                for (size_t c = begin; c < end; ++c)
+                    CPU_SET(cpus[c], &set);
+                sched_setaffinity(0, sizeof(set), &set);
+            }
+            // _exit: les segments hérités du lanceur ne doivent pas être supprimés par le processus de la bande
+            try {
+                runTile(scene, tile, tileCount, frameCount, dt, session, reports[tile]);
+            } catch (const std::exception& e) {
+                std::cerr << "Tile " << tile << ": " << e.what() << std::endl;
+                _exit(EXIT_FAILURE);
+            }
+            _exit(EXIT_SUCCESS);
+        }
+        children.push_back(pid);
+    }
+
+    // Un processus en échec bloquerait ses voisines sur leurs files: les autres sont alors arrêtés
+    bool failed = false;
+    for (size_t remaining = children.size(); remaining > 0; --remaining) {
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0)
+            break;
+        if (!failed && (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)) {
+            failed = true;
+            for (pid_t child : children) {
+                if (child != pid)
+                    kill(child, SIGTERM);
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (failed) {
+        std::cerr << "A tile process failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double checksum = 0., kineticEnergy = 0.;
+    for (int tile = 0; tile < tileCount; ++tile) {
+        const TileReport& report = reports[tile];
+        std::cout << "  tile " << tile << ": rows [" << report.rowBegin << ", " << report.rowEnd << "), "
+                  << report.cpuCount << " cpus, " << report.milliseconds / frameCount << " ms / frame" << std::endl;
+        checksum += report.checksum;
+        kineticEnergy += report.kineticEnergy;
+    }
+    std::printf("checksum %.9f, kinetic energy %g, %.1f M particle steps / s\n", checksum, kineticEnergy,
+                double(scene.grid.x) * scene.grid.y * frameCount / seconds * 1e-6);
+
+    if (verify) {
+        std::vector<double> reference = referenceChecksums(scene, tileCount, frameCount, dt);
+        double referenceChecksum = 0.;
+        for (double tileChecksum : reference)
+            referenceChecksum += tileChecksum;
+        if (referenceChecksum != checksum) {
+            std::printf("Flag reference differs: checksum %.9f\n", referenceChecksum);
+            return EXIT_FAILURE;
+        }
+        std::cout << "Identical to the Flag reference" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}